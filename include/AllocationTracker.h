@@ -0,0 +1,224 @@
+// Contagem de alocações do heap por subsistema
+//
+// O operator new/delete global é substituído (só com CG_TRACK_ALLOCATIONS, opção do
+// CMake) e cada bloco leva um cabeçalho de 16 bytes com o tamanho e o subsistema que o
+// alocou. AllocationTracker::Scope marca o subsistema da thread atual enquanto existir;
+// fora de qualquer escopo a alocação conta como "outros". As liberações são debitadas
+// do subsistema que alocou, então os bytes vivos e o pico de cada um ficam corretos
+// mesmo quando outro trecho libera a memória.
+//
+// No modo estrito (setStrict) qualquer alocação marcada como FRAME_LOOP mostra o tamanho
+// e aborta o programa no ponto da alocação (para ver a pilha no depurador). Quem usa o
+// modo estrito só o liga depois dos primeiros frames, quando os buffers reaproveitados
+// já chegaram à capacidade de regime.
+//
+// Como a substituição do operator new só pode existir uma vez no programa, ela fica sob
+// CG_ALLOCATION_TRACKER_IMPLEMENTATION, definido antes do #include num único arquivo
+// (como STB_IMAGE_IMPLEMENTATION). Sem CG_TRACK_ALLOCATIONS os escopos não fazem nada e
+// as estatísticas ficam zeradas.
+
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <atomic>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+class AllocationTracker
+{
+public:
+    enum Subsystem
+    {
+        OTHER,
+        LOADING,      // OBJ, MTL, texturas e buffers de geometria
+        SCENE_CONFIG, // Leitura do scene_config.txt
+        TRAJECTORIES, // Pontos de controle das trajetórias
+        FRAME_LOOP,   // Simulação, snapshot e desenho de cada frame
+        SUBSYSTEM_COUNT
+    };
+
+    struct Stats
+    {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t bytes = 0;     // Total alocado desde o início
+        uint64_t liveBytes = 0; // Alocado e ainda não liberado
+        uint64_t peakBytes = 0; // Máximo de liveBytes
+    };
+
+#ifdef CG_TRACK_ALLOCATIONS
+    static constexpr bool compiledIn() { return true; }
+#else
+    static constexpr bool compiledIn() { return false; }
+#endif
+
+    static const char* subsystemName(int subsystem)
+    {
+        static const char* names[SUBSYSTEM_COUNT] = { "outros", "carga de modelos", "configuração da cena", "trajetórias", "loop do frame" };
+        return names[subsystem];
+    }
+
+    static Stats getStats(int subsystem)
+    {
+        const Counters& c = counters()[subsystem];
+        Stats stats;
+        stats.allocations = c.allocations.load(std::memory_order_relaxed);
+        stats.frees = c.frees.load(std::memory_order_relaxed);
+        stats.bytes = c.bytes.load(std::memory_order_relaxed);
+        stats.liveBytes = c.liveBytes.load(std::memory_order_relaxed);
+        stats.peakBytes = c.peakBytes.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // Aborta em qualquer alocação do loop do frame enquanto ligado
+    static void setStrict(bool enabled) { strictFlag().store(enabled, std::memory_order_relaxed); }
+    static bool isStrict() { return strictFlag().load(std::memory_order_relaxed); }
+
+    static void report(std::ostream& out)
+    {
+        if (!compiledIn())
+            return;
+        out << "Alocações por subsistema:" << std::endl;
+        for (int s = 0; s < SUBSYSTEM_COUNT; ++s)
+        {
+            Stats stats = getStats(s);
+            if (stats.allocations == 0)
+                continue;
+            out << "  " << subsystemName(s) << ": " << stats.allocations << " alocações (" << stats.frees
+                << " liberadas), " << stats.bytes / 1024.0 << " KB no total, " << stats.liveBytes / 1024.0
+                << " KB vivos, pico " << stats.peakBytes / 1024.0 << " KB" << std::endl;
+        }
+    }
+
+    // Marca o subsistema da thread atual (escopos aninhados restauram o anterior)
+    class Scope
+    {
+    public:
+        explicit Scope(Subsystem subsystem) : previous(current())
+        {
+            current() = subsystem;
+        }
+        ~Scope() { current() = previous; }
+
+    private:
+        int previous;
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // Usados pelo operator new/delete substituído
+    static void* allocate(size_t size);
+    static void release(void* pointer);
+
+private:
+    struct Counters
+    {
+        std::atomic<uint64_t> allocations{ 0 };
+        std::atomic<uint64_t> frees{ 0 };
+        std::atomic<uint64_t> bytes{ 0 };
+        std::atomic<uint64_t> liveBytes{ 0 };
+        std::atomic<uint64_t> peakBytes{ 0 };
+    };
+
+    // Cabeçalho antes de cada bloco; 16 bytes mantém o alinhamento do malloc
+    struct alignas(16) Header
+    {
+        size_t size;
+        int subsystem;
+    };
+
+    // Estado estático sem construtor dinâmico: o operator new pode rodar antes do main
+    static Counters* counters()
+    {
+        static Counters perSubsystem[SUBSYSTEM_COUNT];
+        return perSubsystem;
+    }
+
+    static std::atomic<bool>& strictFlag()
+    {
+        static std::atomic<bool> strict{ false };
+        return strict;
+    }
+
+    static int& current()
+    {
+        thread_local int subsystem = OTHER;
+        return subsystem;
+    }
+};
+
+#if defined(CG_ALLOCATION_TRACKER_IMPLEMENTATION) && defined(CG_TRACK_ALLOCATIONS)
+
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+
+void* AllocationTracker::allocate(size_t size)
+{
+    Header* header = (Header*)malloc(sizeof(Header) + size);
+    if (!header)
+        return nullptr;
+    int subsystem = current();
+    header->size = size;
+    header->subsystem = subsystem;
+
+    Counters& c = counters()[subsystem];
+    c.allocations.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(size, std::memory_order_relaxed);
+    uint64_t live = c.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    uint64_t peak = c.peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !c.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {
+    }
+
+    if (subsystem == FRAME_LOOP && isStrict())
+    {
+        // fprintf e abort não alocam: seguro dentro do operator new
+        fprintf(stderr, "ERROR::ALLOC::FRAME_LOOP_ALLOCATION %zu bytes alocados no loop do frame (modo estrito)\n", size);
+        abort();
+    }
+    return header + 1;
+}
+
+void AllocationTracker::release(void* pointer)
+{
+    if (!pointer)
+        return;
+    Header* header = (Header*)pointer - 1;
+    Counters& c = counters()[header->subsystem];
+    c.frees.fetch_add(1, std::memory_order_relaxed);
+    c.liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+    free(header);
+}
+
+// Substituições globais (as versões com alinhamento estendido continuam as da biblioteca
+// e não entram na contagem)
+void* operator new(std::size_t size)
+{
+    void* pointer = AllocationTracker::allocate(size);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+    void* pointer = AllocationTracker::allocate(size);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return AllocationTracker::allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return AllocationTracker::allocate(size); }
+void operator delete(void* pointer) noexcept { AllocationTracker::release(pointer); }
+void operator delete[](void* pointer) noexcept { AllocationTracker::release(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { AllocationTracker::release(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { AllocationTracker::release(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { AllocationTracker::release(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { AllocationTracker::release(pointer); }
+
+#endif
+
+#endif
@@ -0,0 +1,385 @@
+// Compilação de programas de shader sem bloquear o frame
+//
+// submit() inicia a compilação e devolve um identificador; poll() diz, sem esperar,
+// se o programa já está pronto. Três modos, escolhidos em init():
+//   - GL_KHR/ARB_parallel_shader_compile: glCompileShader/glLinkProgram retornam na
+//     hora e o driver compila em threads próprias; o fim é consultado com
+//     GL_COMPLETION_STATUS_KHR;
+//   - contexto compartilhado: uma thread de trabalho com um contexto GL invisível
+//     (compartilhando objetos com o principal) compila e linka, e um fence avisa a
+//     thread principal quando o programa pode ser usado;
+//   - síncrono: sem nenhum dos dois, compila na hora como antes.
+// Binários do ProgramCache, quando existem, são carregados direto em submit().
+
+#ifndef ASYNC_PROGRAM_COMPILER_H
+#define ASYNC_PROGRAM_COMPILER_H
+
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "ProgramCache.h"
+#include "CpuTracer.h"
+
+// GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+class AsyncProgramCompiler
+{
+public:
+    enum Mode
+    {
+        MODE_SYNC,
+        MODE_PARALLEL_KHR,
+        MODE_WORKER_CONTEXT
+    };
+
+    typedef uint32_t Job;
+
+    struct Stats
+    {
+        int submitted = 0;
+        int cacheHits = 0;
+        int completed = 0;
+        int failed = 0;
+        double totalLatencyMs = 0.0; // Do submit até o programa ficar pronto
+        double maxLatencyMs = 0.0;
+    };
+
+    AsyncProgramCompiler() : mode(MODE_SYNC), cache(nullptr), workerWindow(nullptr), stopping(false) {}
+    ~AsyncProgramCompiler() { shutdown(); }
+
+    // Detecta a extensão de compilação paralela; sem ela, usa workerContext (janela
+    // invisível que compartilha objetos com a principal) se houver
+    Mode init(GLADloadproc loader, ProgramCache* programCache, GLFWwindow* workerContext)
+    {
+        cache = programCache;
+
+        if (supportsParallelCompile())
+        {
+            typedef void (APIENTRYP MaxThreadsFn)(GLuint count);
+            MaxThreadsFn maxThreads = (MaxThreadsFn)loader("glMaxShaderCompilerThreadsKHR");
+            if (!maxThreads)
+                maxThreads = (MaxThreadsFn)loader("glMaxShaderCompilerThreadsARB");
+            if (maxThreads)
+                maxThreads(0xFFFFFFFFu); // Quantas threads o driver quiser
+            mode = MODE_PARALLEL_KHR;
+        }
+        else if (workerContext)
+        {
+            workerWindow = workerContext;
+            worker = std::thread(&AsyncProgramCompiler::workerLoop, this);
+            mode = MODE_WORKER_CONTEXT;
+        }
+        else
+        {
+            mode = MODE_SYNC;
+        }
+        return mode;
+    }
+
+    // Com a extensão não é preciso criar o contexto da thread de trabalho
+    static bool supportsParallelCompile()
+    {
+        return hasExtension("GL_KHR_parallel_shader_compile") || hasExtension("GL_ARB_parallel_shader_compile");
+    }
+
+    // Extensão anunciada pelo contexto atual (também usada fora do compilador)
+    static bool hasExtension(const char* name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i)
+        {
+            const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if (ext && std::strcmp(ext, name) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    void shutdown()
+    {
+        if (worker.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                stopping = true;
+            }
+            queueReady.notify_all();
+            worker.join();
+        }
+    }
+
+    Mode getMode() const { return mode; }
+
+    static const char* modeName(Mode m)
+    {
+        switch (m)
+        {
+        case MODE_PARALLEL_KHR: return "GL_KHR_parallel_shader_compile";
+        case MODE_WORKER_CONTEXT: return "contexto compartilhado em thread de trabalho";
+        default: return "síncrona";
+        }
+    }
+
+    // Inicia a compilação (as fontes são copiadas)
+    Job submit(GLsizei vertexCount, const GLchar* const* vertexParts, GLsizei fragmentCount, const GLchar* const* fragmentParts)
+    {
+        std::unique_ptr<JobState> job(new JobState());
+        job->submitTime = std::chrono::steady_clock::now();
+        for (GLsizei i = 0; i < vertexCount; ++i)
+            job->vertexSource.push_back(vertexParts[i]);
+        for (GLsizei i = 0; i < fragmentCount; ++i)
+            job->fragmentSource.push_back(fragmentParts[i]);
+        stats.submitted++;
+
+        // Binário já compilado antes: pronto na hora
+        if (cache)
+        {
+            job->cacheKey = cache->makeKey(vertexCount, vertexParts, fragmentCount, fragmentParts);
+            job->program = cache->load(job->cacheKey);
+            if (job->program != 0)
+            {
+                job->status = JOB_DONE;
+                job->success = true;
+                job->fromCache = true;
+                stats.cacheHits++;
+                complete(*job);
+            }
+        }
+
+        if (job->status != JOB_DONE)
+        {
+            switch (mode)
+            {
+            case MODE_PARALLEL_KHR:
+                startCompile(*job); // Retorna sem esperar o driver
+                break;
+            case MODE_WORKER_CONTEXT:
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                queue.push_back(job.get());
+                queueReady.notify_one();
+                break;
+            }
+            default:
+                startCompile(*job);
+                finishCompile(*job);
+                job->status = JOB_DONE;
+                complete(*job);
+                break;
+            }
+        }
+
+        jobs.push_back(std::move(job));
+        return (Job)(jobs.size() - 1);
+    }
+
+    // true quando o programa terminou (program = 0 se falhou); nunca bloqueia
+    bool poll(Job id, GLuint& program)
+    {
+        JobState& job = *jobs[id];
+        if (job.status != JOB_DONE)
+        {
+            if (mode == MODE_PARALLEL_KHR)
+            {
+                GLint done = GL_FALSE;
+                glGetProgramiv(job.program, GL_COMPLETION_STATUS_KHR, &done);
+                if (!done)
+                    return false;
+                finishCompile(job);
+            }
+            else if (mode == MODE_WORKER_CONTEXT)
+            {
+                if (job.workerStatus.load(std::memory_order_acquire) != JOB_COMPILED)
+                    return false;
+                // A thread de trabalho terminou de emitir; o fence diz se a GPU/driver também
+                GLenum result = glClientWaitSync(job.fence, 0, 0);
+                if (result == GL_TIMEOUT_EXPIRED)
+                    return false;
+                glDeleteSync(job.fence);
+                job.fence = 0;
+                printLog(job);
+            }
+            job.status = JOB_DONE;
+            complete(job);
+        }
+        program = job.success ? job.program : 0;
+        return true;
+    }
+
+    // Espera o programa ficar pronto (para programas de que não há como prescindir)
+    GLuint wait(Job id)
+    {
+        GLuint program = 0;
+        while (!poll(id, program))
+            std::this_thread::yield();
+        return program;
+    }
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    enum JobStatus
+    {
+        JOB_PENDING,
+        JOB_COMPILED, // Thread de trabalho terminou (falta o fence)
+        JOB_DONE
+    };
+
+    struct JobState
+    {
+        std::vector<std::string> vertexSource, fragmentSource;
+        GLuint program = 0;
+        GLuint vertexShader = 0, fragmentShader = 0;
+        uint64_t cacheKey = 0;
+        JobStatus status = JOB_PENDING;
+        std::atomic<int> workerStatus{ JOB_PENDING };
+        GLsync fence = 0;
+        bool success = false;
+        bool fromCache = false;
+        std::string log;
+        std::chrono::steady_clock::time_point submitTime;
+    };
+
+    Mode mode;
+    ProgramCache* cache;
+    GLFWwindow* workerWindow;
+    std::vector<std::unique_ptr<JobState>> jobs;
+    Stats stats;
+
+    std::thread worker;
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<JobState*> queue;
+    bool stopping;
+
+    // Emite compilação e link sem consultar status (consultar é o que bloquearia)
+    void startCompile(JobState& job)
+    {
+        std::vector<const GLchar*> vertex, fragment;
+        for (const auto& part : job.vertexSource)
+            vertex.push_back(part.c_str());
+        for (const auto& part : job.fragmentSource)
+            fragment.push_back(part.c_str());
+
+        job.vertexShader = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(job.vertexShader, (GLsizei)vertex.size(), vertex.data(), NULL);
+        glCompileShader(job.vertexShader);
+        job.fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(job.fragmentShader, (GLsizei)fragment.size(), fragment.data(), NULL);
+        glCompileShader(job.fragmentShader);
+
+        job.program = glCreateProgram();
+        glAttachShader(job.program, job.vertexShader);
+        glAttachShader(job.program, job.fragmentShader);
+        if (cache)
+            cache->markRetrievable(job.program);
+        glLinkProgram(job.program);
+    }
+
+    // Checa erros (como o antigo setupShader) e libera os shaders
+    void finishCompile(JobState& job)
+    {
+        GLint success = 0;
+        GLchar infoLog[512];
+        glGetShaderiv(job.vertexShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(job.vertexShader, 512, NULL, infoLog);
+            job.log += std::string("ERROR::SHADER::VERTEX::COMPILATION_FAILED\n") + infoLog + "\n";
+        }
+        glGetShaderiv(job.fragmentShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(job.fragmentShader, 512, NULL, infoLog);
+            job.log += std::string("ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n") + infoLog + "\n";
+        }
+        glGetProgramiv(job.program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(job.program, 512, NULL, infoLog);
+            job.log += std::string("ERROR::SHADER::PROGRAM::LINKING_FAILED\n") + infoLog + "\n";
+        }
+        job.success = success != 0;
+        glDeleteShader(job.vertexShader);
+        glDeleteShader(job.fragmentShader);
+        job.vertexShader = job.fragmentShader = 0;
+
+        // Na thread de trabalho o log é impresso pela principal
+        if (mode != MODE_WORKER_CONTEXT)
+            printLog(job);
+    }
+
+    static void printLog(JobState& job)
+    {
+        if (!job.log.empty())
+        {
+            std::cout << job.log;
+            job.log.clear();
+        }
+    }
+
+    // Programa pronto: grava no cache, libera as fontes e contabiliza
+    void complete(JobState& job)
+    {
+        double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job.submitTime).count();
+        if (job.success)
+        {
+            stats.completed++;
+            if (cache && !job.fromCache)
+                cache->store(job.cacheKey, job.program);
+        }
+        else
+        {
+            stats.failed++;
+        }
+        stats.totalLatencyMs += latency;
+        stats.maxLatencyMs = std::max(stats.maxLatencyMs, latency);
+        job.vertexSource.clear();
+        job.fragmentSource.clear();
+    }
+
+    void workerLoop()
+    {
+        CG_TRACE_THREAD("compilação de shaders");
+        glfwMakeContextCurrent(workerWindow);
+        for (;;)
+        {
+            JobState* job = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (stopping)
+                    break;
+                job = queue.front();
+                queue.pop_front();
+            }
+
+            CG_TRACE_SCOPE("compilação do programa");
+            startCompile(*job);
+            finishCompile(*job);
+            job->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush(); // Garante que o fence chegue ao driver antes de a principal esperar por ele
+            job->workerStatus.store(JOB_COMPILED, std::memory_order_release);
+        }
+        glfwMakeContextCurrent(nullptr);
+    }
+};
+
+#endif
@@ -0,0 +1,297 @@
+// Iluminação clusterizada (clustered forward shading)
+//
+// O frustum da câmera é dividido numa grade 3D de clusters: tiles em espaço de tela
+// e fatias exponenciais em profundidade. A cada frame a CPU testa a esfera de
+// alcance de cada luz contra as caixas (em espaço de visão) dos clusters que ela
+// pode tocar e monta, para cada cluster, a lista de índices das luzes que o afetam.
+// O fragment shader descobre seu cluster por gl_FragCoord e profundidade e só
+// percorre essas luzes.
+//
+// Buffers (std430):
+//   binding 2: luzes      { vec4 positionRange; vec4 color; }
+//   binding 3: clusters   uvec2 (início na lista, quantidade)
+//   binding 4: lista de índices de luzes (uint)
+// Os três são faixas do StreamingBuffer do frame.
+
+#ifndef CLUSTERED_LIGHTING_H
+#define CLUSTERED_LIGHTING_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "GLStateCache.h"
+#include "StreamingBuffer.h"
+
+// Luz como enviada para a GPU
+struct GPULight
+{
+    glm::vec4 positionRange; // xyz = posição em mundo, w = alcance
+    glm::vec4 color;         // rgb = cor * intensidade
+};
+
+class LightClusterer
+{
+public:
+    static const int GRID_X = 16;
+    static const int GRID_Y = 16;
+    static const int GRID_Z = 24;
+    static const int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+    static const GLuint LIGHT_SSBO_BINDING = 2;
+    static const GLuint CLUSTER_SSBO_BINDING = 3;
+    static const GLuint INDEX_SSBO_BINDING = 4;
+
+    LightClusterer()
+        : fovY(0.0f), aspect(0.0f), nearPlane(0.0f), farPlane(0.0f),
+          clusterRanges(CLUSTER_COUNT * 2, 0), lastPairs(0)
+    {
+    }
+
+    // Fatia exponencial: slice = log(-z) * scale + bias (mesma fórmula no shader)
+    float getSliceScale() const { return GRID_Z / std::log(farPlane / nearPlane); }
+    float getSliceBias() const { return -GRID_Z * std::log(nearPlane) / std::log(farPlane / nearPlane); }
+
+    // Distribui as luzes nos clusters para a câmera dada
+    void build(const glm::mat4& view, float fovYRadians, float aspectRatio, float zNear, float zFar,
+               const std::vector<GPULight>& lights)
+    {
+        if (fovYRadians != fovY || aspectRatio != aspect || zNear != nearPlane || zFar != farPlane)
+        {
+            fovY = fovYRadians;
+            aspect = aspectRatio;
+            nearPlane = zNear;
+            farPlane = zFar;
+            computeClusterBounds();
+        }
+
+        gpuLights.assign(lights.begin(), lights.end());
+
+        // Pares (cluster, luz), depois agrupados por cluster com counting sort
+        pairs.clear();
+        float tanY = std::tan(fovY * 0.5f);
+        float tanX = tanY * aspect;
+        float sliceScale = getSliceScale();
+        float sliceBias = getSliceBias();
+
+        for (uint32_t l = 0; l < (uint32_t)lights.size(); ++l)
+        {
+            glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(lights[l].positionRange), 1.0f));
+            float radius = lights[l].positionRange.w;
+
+            // Profundidade de visão (positiva) coberta pela esfera
+            float dNear = -center.z - radius;
+            float dFar = -center.z + radius;
+            if (dFar <= nearPlane || dNear >= farPlane)
+                continue;
+            dNear = std::max(dNear, nearPlane);
+            dFar = std::min(dFar, farPlane);
+
+            int z0 = std::max(0, (int)std::floor(std::log(dNear) * sliceScale + sliceBias));
+            int z1 = std::min(GRID_Z - 1, (int)std::floor(std::log(dFar) * sliceScale + sliceBias));
+
+            // Retângulo de tela conservador: caixa da esfera projetada na profundidade mais próxima
+            float xMin = (center.x - radius) / (tanX * dNear), xMax = (center.x + radius) / (tanX * dNear);
+            float yMin = (center.y - radius) / (tanY * dNear), yMax = (center.y + radius) / (tanY * dNear);
+            if (center.x - radius > 0.0f) xMin = (center.x - radius) / (tanX * dFar);
+            if (center.x + radius < 0.0f) xMax = (center.x + radius) / (tanX * dFar);
+            if (center.y - radius > 0.0f) yMin = (center.y - radius) / (tanY * dFar);
+            if (center.y + radius < 0.0f) yMax = (center.y + radius) / (tanY * dFar);
+            if (xMin > 1.0f || xMax < -1.0f || yMin > 1.0f || yMax < -1.0f)
+                continue;
+
+            int x0 = std::max(0, (int)std::floor((xMin * 0.5f + 0.5f) * GRID_X));
+            int x1 = std::min(GRID_X - 1, (int)std::floor((xMax * 0.5f + 0.5f) * GRID_X));
+            int y0 = std::max(0, (int)std::floor((yMin * 0.5f + 0.5f) * GRID_Y));
+            int y1 = std::min(GRID_Y - 1, (int)std::floor((yMax * 0.5f + 0.5f) * GRID_Y));
+
+            for (int z = z0; z <= z1; ++z)
+            {
+                for (int y = y0; y <= y1; ++y)
+                {
+                    for (int x = x0; x <= x1; ++x)
+                    {
+                        uint32_t cluster = x + GRID_X * (y + GRID_Y * z);
+                        if (sphereIntersectsCluster(center, radius, cluster))
+                            pairs.push_back(((uint64_t)cluster << 32) | l);
+                    }
+                }
+            }
+        }
+
+        // Contagem por cluster e prefixo -> (início, quantidade)
+        std::fill(clusterRanges.begin(), clusterRanges.end(), 0);
+        for (uint64_t pair : pairs)
+            clusterRanges[(pair >> 32) * 2 + 1]++;
+        uint32_t offset = 0;
+        for (int c = 0; c < CLUSTER_COUNT; ++c)
+        {
+            clusterRanges[c * 2] = offset;
+            offset += clusterRanges[c * 2 + 1];
+        }
+
+        lightIndices.resize(std::max<size_t>(pairs.size(), 1));
+        cursor.assign(CLUSTER_COUNT, 0);
+        for (uint64_t pair : pairs)
+        {
+            uint32_t c = (uint32_t)(pair >> 32);
+            lightIndices[clusterRanges[c * 2] + cursor[c]++] = (uint32_t)(pair & 0xFFFFFFFF);
+        }
+        lastPairs = pairs.size();
+    }
+
+    // Bytes que upload() vai alocar no StreamingBuffer
+    GLsizeiptr getStreamSize(const StreamingBuffer& stream) const
+    {
+        return stream.alignedSize(gpuLights.size() * sizeof(GPULight)) +
+               stream.alignedSize(clusterRanges.size() * sizeof(uint32_t)) +
+               stream.alignedSize(lightIndices.size() * sizeof(uint32_t));
+    }
+
+    // Copia luzes, clusters e índices para a região do frame e vincula os três SSBOs
+    void upload(GLStateCache& state, StreamingBuffer& stream) const
+    {
+        uploadRange(state, stream, LIGHT_SSBO_BINDING, gpuLights.data(), gpuLights.size() * sizeof(GPULight));
+        uploadRange(state, stream, CLUSTER_SSBO_BINDING, clusterRanges.data(), clusterRanges.size() * sizeof(uint32_t));
+        uploadRange(state, stream, INDEX_SSBO_BINDING, lightIndices.data(), lightIndices.size() * sizeof(uint32_t));
+    }
+
+    size_t getLightCount() const { return gpuLights.size(); }
+    size_t getAssignmentCount() const { return lastPairs; }
+
+    // Maior número de luzes num único cluster no último build
+    uint32_t getMaxLightsPerCluster() const
+    {
+        uint32_t maxCount = 0;
+        for (int c = 0; c < CLUSTER_COUNT; ++c)
+            maxCount = std::max(maxCount, clusterRanges[c * 2 + 1]);
+        return maxCount;
+    }
+
+    // Cabeçalho GLSL com os blocos e a função de busca do cluster, compartilhado
+    // pelos shaders que iluminam (forward e deferred)
+    static const char* glslDeclarations()
+    {
+        return
+            "struct Light {\n"
+            "    vec4 positionRange;\n"
+            "    vec4 color;\n"
+            "};\n"
+            "layout (std430, binding = 2) readonly buffer LightBuffer { Light lights[]; };\n"
+            "layout (std430, binding = 3) readonly buffer ClusterBuffer { uvec2 clusters[]; };\n"
+            "layout (std430, binding = 4) readonly buffer LightIndexBuffer { uint lightIndices[]; };\n"
+            "uvec2 findCluster(vec2 fragCoord, float viewDepth)\n"
+            "{\n"
+            "    uvec3 grid = clusterGrid.xyz;\n"
+            "    uvec2 tile = min(uvec2(fragCoord * screenSize.zw * vec2(grid.xy)), grid.xy - 1u);\n"
+            "    uint slice = uint(clamp(log(viewDepth) * clusterParams.x + clusterParams.y, 0.0, float(grid.z - 1u)));\n"
+            "    return clusters[tile.x + grid.x * (tile.y + grid.y * slice)];\n"
+            "}\n"
+            "float lightAttenuation(float dist, float range)\n"
+            "{\n"
+            "    float ratio = dist / range;\n"
+            "    float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);\n"
+            "    return window * window;\n"
+            "}\n"
+            "// Soma difusa e especular (Phong) de uma luz, sem os coeficientes do material.\n"
+            "// O termo especular só é calculado com SPECULAR definido\n"
+            "void accumulateLight(Light light, vec3 fragPos, vec3 N, vec3 V, float shininess,\n"
+            "                     inout vec3 diffuseLight, inout vec3 specularLight)\n"
+            "{\n"
+            "    vec3 toLight = light.positionRange.xyz - fragPos;\n"
+            "    float dist = length(toLight);\n"
+            "    float attenuation = lightAttenuation(dist, light.positionRange.w);\n"
+            "    if (attenuation <= 0.0)\n"
+            "        return;\n"
+            "    vec3 L = toLight / dist;\n"
+            "    diffuseLight += max(dot(N, L), 0.0) * light.color.rgb * attenuation;\n"
+            "#ifdef SPECULAR\n"
+            "    vec3 R = reflect(-L, N);\n"
+            "    specularLight += pow(max(dot(R, V), 0.0), shininess) * light.color.rgb * attenuation;\n"
+            "#endif\n"
+            "}\n"
+            "// Mesma soma sobre as luzes do cluster do fragmento\n"
+            "void accumulateClusterLights(vec3 fragPos, vec3 N, vec3 V, vec2 fragCoord, float viewDepth, float shininess,\n"
+            "                             inout vec3 diffuseLight, inout vec3 specularLight)\n"
+            "{\n"
+            "    uvec2 cluster = findCluster(fragCoord, viewDepth);\n"
+            "    for (uint i = 0u; i < cluster.y; ++i)\n"
+            "        accumulateLight(lights[lightIndices[cluster.x + i]], fragPos, N, V, shininess, diffuseLight, specularLight);\n"
+            "}\n";
+    }
+
+private:
+    float fovY, aspect, nearPlane, farPlane;
+
+    std::vector<glm::vec3> clusterMin, clusterMax; // Caixas em espaço de visão
+    std::vector<GPULight> gpuLights;
+    std::vector<uint64_t> pairs;
+    std::vector<uint32_t> clusterRanges;
+    std::vector<uint32_t> lightIndices;
+    std::vector<uint32_t> cursor;
+    size_t lastPairs;
+
+    void computeClusterBounds()
+    {
+        clusterMin.resize(CLUSTER_COUNT);
+        clusterMax.resize(CLUSTER_COUNT);
+        float tanY = std::tan(fovY * 0.5f);
+        float tanX = tanY * aspect;
+
+        for (int z = 0; z < GRID_Z; ++z)
+        {
+            float d0 = nearPlane * std::pow(farPlane / nearPlane, (float)z / GRID_Z);
+            float d1 = nearPlane * std::pow(farPlane / nearPlane, (float)(z + 1) / GRID_Z);
+            for (int y = 0; y < GRID_Y; ++y)
+            {
+                float ny0 = (float)y / GRID_Y * 2.0f - 1.0f, ny1 = (float)(y + 1) / GRID_Y * 2.0f - 1.0f;
+                for (int x = 0; x < GRID_X; ++x)
+                {
+                    float nx0 = (float)x / GRID_X * 2.0f - 1.0f, nx1 = (float)(x + 1) / GRID_X * 2.0f - 1.0f;
+                    glm::vec3 bMin(1e30f), bMax(-1e30f);
+                    const float depths[2] = { d0, d1 };
+                    for (float d : depths)
+                    {
+                        const float xs[2] = { nx0 * tanX * d, nx1 * tanX * d };
+                        const float ys[2] = { ny0 * tanY * d, ny1 * tanY * d };
+                        for (float px : xs)
+                        {
+                            for (float py : ys)
+                            {
+                                glm::vec3 p(px, py, -d);
+                                bMin = glm::min(bMin, p);
+                                bMax = glm::max(bMax, p);
+                            }
+                        }
+                    }
+                    int c = x + GRID_X * (y + GRID_Y * z);
+                    clusterMin[c] = bMin;
+                    clusterMax[c] = bMax;
+                }
+            }
+        }
+    }
+
+    bool sphereIntersectsCluster(const glm::vec3& center, float radius, uint32_t cluster) const
+    {
+        glm::vec3 closest = glm::max(clusterMin[cluster], glm::min(center, clusterMax[cluster]));
+        glm::vec3 delta = closest - center;
+        return glm::dot(delta, delta) <= radius * radius;
+    }
+
+    static void uploadRange(GLStateCache& state, StreamingBuffer& stream, GLuint binding, const void* data, size_t size)
+    {
+        // Faixa mínima de 16 bytes: tamanho 0 em bindBufferRange viraria glBindBufferBase
+        StreamingBuffer::Allocation range = stream.allocate((GLsizeiptr)size);
+        if (size > 0)
+            std::memcpy(range.data, data, size);
+        state.bindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, stream.getBuffer(), range.offset, range.size);
+    }
+};
+
+#endif
@@ -0,0 +1,272 @@
+// Tracer de zonas de CPU com exportação para chrome://tracing / Perfetto
+//
+// CG_TRACE_SCOPE("nome") mede o bloco onde aparece; CG_TRACE_FUNCTION() usa o nome da
+// função; CG_TRACE_THREAD("nome") dá nome à thread no trace. Os nomes precisam ser
+// literais (só o ponteiro é guardado).
+//
+// Cada thread escreve num buffer circular próprio, registrado uma única vez (sob mutex)
+// na primeira zona da thread; a partir daí gravar uma zona é só ler o relógio duas vezes
+// e escrever 24 bytes, sem trava nem atômico compartilhado. Fora de uma captura, a zona
+// custa uma leitura de flag. As capturas (startCapture/stopCapture) marcam o trecho dos
+// buffers que writeJson() exporta como eventos "X" (início + duração, em microssegundos
+// com resolução de nanossegundo).
+//
+// Em x86 o relógio é o contador de ciclos (rdtsc, invariante nas CPUs atuais): custa
+// bem menos que steady_clock::now(). A conversão para nanossegundos só acontece em
+// writeJson(), pela razão entre o contador e o steady_clock desde a criação do tracer.
+//
+// Sem CG_ENABLE_TRACING (opção do CMake) as macros viram nada e CpuTracer só tem
+// funções vazias, para que quem controla as capturas compile igual.
+
+#ifndef CPU_TRACER_H
+#define CPU_TRACER_H
+
+#include <string>
+
+#ifdef CG_ENABLE_TRACING
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <cstdint>
+
+#include "AllocationTracker.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CG_TRACE_USE_TSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+class CpuTracer
+{
+public:
+    static const size_t EVENTS_PER_THREAD = 1 << 16; // Potência de 2 (buffer circular)
+
+    static constexpr bool compiledIn() { return true; }
+
+    static CpuTracer& instance()
+    {
+        static CpuTracer tracer;
+        return tracer;
+    }
+
+    // Marca de tempo nas unidades do relógio do tracer (ciclos ou nanossegundos)
+    static uint64_t now()
+    {
+#ifdef CG_TRACE_USE_TSC
+        return __rdtsc();
+#else
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    bool isCapturing() const { return capturing.load(std::memory_order_relaxed); }
+
+    // Começa a marcar eventos; os de capturas anteriores deixam de ser exportados
+    void startCapture()
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto& buffer : buffers)
+            buffer->captureStart = buffer->count.load(std::memory_order_acquire);
+        captureStartTicks = now();
+        capturing.store(true, std::memory_order_release);
+    }
+
+    void stopCapture()
+    {
+        capturing.store(false, std::memory_order_release);
+    }
+
+    // Exporta os eventos da última captura. Pode ser chamada durante ou depois dela: só
+    // lê as posições já publicadas de cada buffer
+    bool writeJson(const std::string& path)
+    {
+        std::ofstream file(path, std::ios::out | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        double nsPerTick = nanosecondsPerTick();
+        file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        bool first = true;
+        for (size_t t = 0; t < buffers.size(); ++t)
+        {
+            ThreadBuffer& buffer = *buffers[t];
+            file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t
+                 << ",\"args\":{\"name\":\"" << escape(buffer.name) << "\"}}";
+            first = false;
+
+            uint64_t end = buffer.count.load(std::memory_order_acquire);
+            uint64_t begin = buffer.captureStart;
+            if (end - begin > EVENTS_PER_THREAD)
+                begin = end - EVENTS_PER_THREAD; // O início da captura já foi sobrescrito
+            for (uint64_t i = begin; i < end; ++i)
+            {
+                const Event& event = buffer.events[i & (EVENTS_PER_THREAD - 1)];
+                if (event.start < captureStartTicks)
+                    continue;
+                uint64_t startNs = (uint64_t)((double)(event.start - originTicks) * nsPerTick);
+                uint64_t durationNs = (uint64_t)((double)event.duration * nsPerTick);
+                file << ",\n{\"name\":\"" << escape(event.name) << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << t
+                     << ",\"ts\":" << microseconds(startNs) << ",\"dur\":" << microseconds(durationNs) << "}";
+            }
+        }
+        file << "\n]}\n";
+        return true;
+    }
+
+    // Chamado pelas macros
+    void record(const char* name, uint64_t start, uint64_t end)
+    {
+        ThreadBuffer& buffer = threadBuffer();
+        uint64_t index = buffer.count.load(std::memory_order_relaxed);
+        Event& event = buffer.events[index & (EVENTS_PER_THREAD - 1)];
+        event.name = name;
+        event.start = start;
+        event.duration = end - start;
+        buffer.count.store(index + 1, std::memory_order_release); // Publica o evento para writeJson()
+    }
+
+    void setThreadName(const char* name)
+    {
+        ThreadBuffer& buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer.name = name;
+    }
+
+    // Zona RAII usada por CG_TRACE_SCOPE
+    class Zone
+    {
+    public:
+        explicit Zone(const char* zoneName)
+            : name(zoneName), start(CpuTracer::instance().isCapturing() ? CpuTracer::now() : NOT_CAPTURING)
+        {
+        }
+        ~Zone()
+        {
+            if (start != NOT_CAPTURING)
+                CpuTracer::instance().record(name, start, CpuTracer::now());
+        }
+
+    private:
+        static const uint64_t NOT_CAPTURING = ~0ull;
+        const char* name;
+        uint64_t start;
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+    };
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Event
+    {
+        const char* name;
+        uint64_t start;    // Unidades de now()
+        uint64_t duration;
+    };
+
+    struct ThreadBuffer
+    {
+        std::unique_ptr<Event[]> events;
+        std::atomic<uint64_t> count{ 0 }; // Eventos já escritos (só a própria thread escreve)
+        uint64_t captureStart = 0;
+        std::string name;
+    };
+
+    Clock::time_point origin;
+    uint64_t originTicks;
+    std::atomic<bool> capturing;
+    uint64_t captureStartTicks;
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers; // Nunca encolhe: as threads guardam ponteiros
+
+    CpuTracer() : origin(Clock::now()), originTicks(now()), capturing(false), captureStartTicks(0) {}
+
+    // Razão medida entre o relógio do tracer e o steady_clock desde a criação
+    double nanosecondsPerTick() const
+    {
+#ifdef CG_TRACE_USE_TSC
+        uint64_t elapsedTicks = now() - originTicks;
+        double elapsedNs = std::chrono::duration<double, std::nano>(Clock::now() - origin).count();
+        return elapsedTicks > 0 ? elapsedNs / (double)elapsedTicks : 1.0;
+#else
+        return 1.0;
+#endif
+    }
+
+    ThreadBuffer& threadBuffer()
+    {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer)
+        {
+            // Registro do tracer, não do trecho medido (o modo estrito de alocações ignora)
+            AllocationTracker::Scope allocationScope(AllocationTracker::OTHER);
+            std::unique_ptr<ThreadBuffer> created(new ThreadBuffer());
+            created->events.reset(new Event[EVENTS_PER_THREAD]);
+            std::lock_guard<std::mutex> lock(registryMutex);
+            created->name = "thread " + std::to_string(buffers.size());
+            created->captureStart = 0;
+            buffer = created.get();
+            buffers.push_back(std::move(created));
+        }
+        return *buffer;
+    }
+
+    static std::string microseconds(uint64_t ns)
+    {
+        // Parte inteira e três casas: nanossegundos sem perder precisão em double
+        std::string fraction = std::to_string(ns % 1000);
+        return std::to_string(ns / 1000) + "." + std::string(3 - fraction.size(), '0') + fraction;
+    }
+
+    static std::string escape(const std::string& text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+};
+
+#define CG_TRACE_CONCAT_INNER(a, b) a##b
+#define CG_TRACE_CONCAT(a, b) CG_TRACE_CONCAT_INNER(a, b)
+#define CG_TRACE_SCOPE(name) CpuTracer::Zone CG_TRACE_CONCAT(cgTraceZone, __LINE__)(name)
+#define CG_TRACE_FUNCTION() CG_TRACE_SCOPE(__func__)
+#define CG_TRACE_THREAD(name) CpuTracer::instance().setThreadName(name)
+
+#else
+
+class CpuTracer
+{
+public:
+    static constexpr bool compiledIn() { return false; }
+    static CpuTracer& instance()
+    {
+        static CpuTracer tracer;
+        return tracer;
+    }
+    bool isCapturing() const { return false; }
+    void startCapture() {}
+    void stopCapture() {}
+    bool writeJson(const std::string&) { return false; }
+};
+
+#define CG_TRACE_SCOPE(name) ((void)0)
+#define CG_TRACE_FUNCTION() ((void)0)
+#define CG_TRACE_THREAD(name) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,193 @@
+// Caminho de renderização deferred
+//
+// Passo de geometria: a cena é desenhada num G-buffer com
+//   0: RGBA8   albedo difuso (textura * kd)
+//   1: RG16F   normal em codificação octaédrica
+//   2: RGBA16F ks.rgb e expoente q
+//   3: RGBA8   albedo ambiente (textura * ka)
+//   profundidade: textura DEPTH24_STENCIL8
+// Passo de iluminação: um triângulo de tela cheia reconstrói a posição pela
+// profundidade e ilumina cada pixel uma única vez com as luzes do seu cluster
+// (mesmos buffers de LightClusterer do caminho forward).
+// No fim a profundidade é copiada para o framebuffer de saída (o padrão, ou o FBO do
+// modo headless), para que o que ainda é desenhado em forward (ex.: pontos de
+// controle) seja ocluído corretamente.
+//
+// Os programas (inclusive as permutações SHADER_GBUFFER do passo de geometria) são
+// compilados por quem usa a classe; aqui ficam só os alvos e os passos.
+
+#ifndef DEFERRED_RENDERER_H
+#define DEFERRED_RENDERER_H
+
+#include <iostream>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "GLStateCache.h"
+
+class DeferredRenderer
+{
+public:
+    static const int COLOR_TARGETS = 4;
+
+    // Unidades de textura lidas pelo passo de iluminação
+    static const GLuint ALBEDO_UNIT = 0;
+    static const GLuint NORMAL_UNIT = 1;
+    static const GLuint MATERIAL_UNIT = 2;
+    static const GLuint AMBIENT_UNIT = 3;
+    static const GLuint DEPTH_UNIT = 4;
+
+    DeferredRenderer()
+        : fbo(0), depthTexture(0), emptyVAO(0), lightingProgram(0),
+          invViewProjectionLoc(-1), width(0), height(0)
+    {
+        for (int i = 0; i < COLOR_TARGETS; ++i)
+            colorTextures[i] = 0;
+    }
+
+    // Cria o G-buffer e prepara o programa de iluminação. Retorna false se o FBO
+    // não estiver completo (o chamador continua só com o caminho forward)
+    bool init(GLStateCache& state, int w, int h, GLuint lighting)
+    {
+        lightingProgram = lighting;
+
+        glGenFramebuffers(1, &fbo);
+        glGenVertexArrays(1, &emptyVAO); // O perfil core exige um VAO mesmo sem atributos
+        bool complete = resize(w, h);
+        state.invalidate(); // resize() vincula FBO e texturas por fora do cache
+
+        invViewProjectionLoc = glGetUniformLocation(lightingProgram, "invViewProjection");
+        state.useProgram(lightingProgram);
+        state.uniform1i(glGetUniformLocation(lightingProgram, "gAlbedo"), ALBEDO_UNIT);
+        state.uniform1i(glGetUniformLocation(lightingProgram, "gNormal"), NORMAL_UNIT);
+        state.uniform1i(glGetUniformLocation(lightingProgram, "gMaterial"), MATERIAL_UNIT);
+        state.uniform1i(glGetUniformLocation(lightingProgram, "gAmbient"), AMBIENT_UNIT);
+        state.uniform1i(glGetUniformLocation(lightingProgram, "gDepth"), DEPTH_UNIT);
+        return complete;
+    }
+
+    void destroy()
+    {
+        releaseTargets();
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteVertexArrays(1, &emptyVAO);
+        fbo = emptyVAO = 0;
+    }
+
+    // (Re)cria as texturas do G-buffer quando o tamanho muda
+    bool resize(int w, int h)
+    {
+        if (w == width && h == height && depthTexture != 0)
+            return true;
+
+        releaseTargets();
+        width = w;
+        height = h;
+
+        const GLenum internalFormats[COLOR_TARGETS] = { GL_RGBA8, GL_RG16F, GL_RGBA16F, GL_RGBA8 };
+        const GLenum formats[COLOR_TARGETS] = { GL_RGBA, GL_RG, GL_RGBA, GL_RGBA };
+        const GLenum types[COLOR_TARGETS] = { GL_UNSIGNED_BYTE, GL_HALF_FLOAT, GL_HALF_FLOAT, GL_UNSIGNED_BYTE };
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glGenTextures(COLOR_TARGETS, colorTextures);
+        GLenum drawBuffers[COLOR_TARGETS];
+        for (int i = 0; i < COLOR_TARGETS; ++i)
+        {
+            glBindTexture(GL_TEXTURE_2D, colorTextures[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, internalFormats[i], width, height, 0, formats[i], types[i], nullptr);
+            setNearestFiltering();
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorTextures[i], 0);
+            drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+        }
+        glDrawBuffers(COLOR_TARGETS, drawBuffers);
+
+        // Mesmo formato do framebuffer padrão do GLFW, para o blit de profundidade
+        glGenTextures(1, &depthTexture);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+        setNearestFiltering();
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "ERROR::DEFERRED::FRAMEBUFFER_INCOMPLETE 0x" << std::hex << status << std::dec << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Passa a desenhar no G-buffer. Blending fica desligado: o G-buffer guarda dados, não cor
+    void beginGeometryPass(GLStateCache& state)
+    {
+        state.bindFramebuffer(GL_FRAMEBUFFER, fbo);
+        state.disable(GL_BLEND);
+        state.enable(GL_DEPTH_TEST);
+        state.depthMask(GL_TRUE);
+        state.clearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    // Ilumina o framebuffer de saída a partir do G-buffer e copia a profundidade para ele
+    void lightingPass(GLStateCache& state, const glm::mat4& invViewProjection, GLuint outputFramebuffer = 0)
+    {
+        state.bindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+        state.disable(GL_DEPTH_TEST);
+        state.depthMask(GL_FALSE);
+
+        state.useProgram(lightingProgram);
+        state.uniformMatrix4fv(invViewProjectionLoc, glm::value_ptr(invViewProjection));
+        state.bindTextureUnit(ALBEDO_UNIT, GL_TEXTURE_2D, colorTextures[0]);
+        state.bindTextureUnit(NORMAL_UNIT, GL_TEXTURE_2D, colorTextures[1]);
+        state.bindTextureUnit(MATERIAL_UNIT, GL_TEXTURE_2D, colorTextures[2]);
+        state.bindTextureUnit(AMBIENT_UNIT, GL_TEXTURE_2D, colorTextures[3]);
+        state.bindTextureUnit(DEPTH_UNIT, GL_TEXTURE_2D, depthTexture);
+        state.bindVertexArray(emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        state.bindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        state.bindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        state.bindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+
+        state.enable(GL_DEPTH_TEST);
+        state.depthMask(GL_TRUE);
+        state.enable(GL_BLEND);
+    }
+
+private:
+    GLuint fbo;
+    GLuint colorTextures[COLOR_TARGETS];
+    GLuint depthTexture;
+    GLuint emptyVAO;
+    GLuint lightingProgram;
+    GLint invViewProjectionLoc;
+    int width, height;
+
+    static void setNearestFiltering()
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    void releaseTargets()
+    {
+        if (depthTexture != 0)
+        {
+            glDeleteTextures(COLOR_TARGETS, colorTextures);
+            glDeleteTextures(1, &depthTexture);
+        }
+        for (int i = 0; i < COLOR_TARGETS; ++i)
+            colorTextures[i] = 0;
+        depthTexture = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,251 @@
+// Tempo do loop principal
+//
+// FixedTimestep: a simulação (trajetórias, movimento da câmera) avança em passos fixos
+// de 1/Hz segundos, independentes da taxa de frames. O tempo real de cada frame entra
+// num acumulador que é consumido em passos inteiros; a sobra vira o alpha usado para
+// interpolar entre o estado anterior e o atual na hora de desenhar.
+//
+// FramePacer: limita o loop a um FPS alvo. Dorme enquanto falta bastante para o prazo
+// e termina girando (yield) nos últimos instantes, porque o sleep do sistema pode
+// acordar com atraso; a margem de giro se ajusta ao maior atraso de sleep observado.
+//
+// FrameTimeStats: janela dos últimos frames para percentis de tempo de frame.
+//
+// StartupTimeline: fases da inicialização até o primeiro frame. Cada mark() atribui o
+// tempo desde a marca anterior à fase nomeada (fases repetidas acumulam); a origem é a
+// construção do objeto (global: antes do main).
+
+#ifndef FRAME_TIMING_H
+#define FRAME_TIMING_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+class FixedTimestep
+{
+public:
+    // maxFrameDelta evita a "espiral da morte": após uma pausa longa (janela arrastada,
+    // breakpoint) a simulação não tenta recuperar tudo de uma vez
+    explicit FixedTimestep(double hz = 60.0, double maxFrameDelta = 0.25)
+        : step(1.0 / hz), maxDelta(maxFrameDelta), accumulator(0.0), time(0.0), totalSteps(0)
+    {
+    }
+
+    void setRate(double hz) { step = 1.0 / std::max(hz, 1.0); }
+    double getStep() const { return step; }
+    double getRate() const { return 1.0 / step; }
+
+    // Acrescenta o tempo real do frame e devolve quantos passos rodar agora
+    int advance(double frameDelta)
+    {
+        accumulator += std::min(std::max(frameDelta, 0.0), maxDelta);
+        int steps = 0;
+        while (accumulator >= step)
+        {
+            accumulator -= step;
+            time += step;
+            steps++;
+        }
+        totalSteps += steps;
+        return steps;
+    }
+
+    // Fração do próximo passo já decorrida (0..1): peso do estado atual na interpolação
+    float getAlpha() const { return (float)(accumulator / step); }
+
+    // Tempo da simulação interpolado, para o que é função direta do tempo (rotações)
+    double getRenderTime() const { return std::max(0.0, time - step + accumulator); }
+
+    double getTime() const { return time; }
+    long long getTotalSteps() const { return totalSteps; }
+
+private:
+    double step;
+    double maxDelta;
+    double accumulator;
+    double time;
+    long long totalSteps;
+};
+
+class FramePacer
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    FramePacer() : period(0.0), spinMargin(0.002), started(false) {}
+
+    // 0 = sem limite
+    void setTargetFps(double fps)
+    {
+        period = fps > 0.0 ? 1.0 / fps : 0.0;
+        started = false;
+    }
+    double getTargetFps() const { return period > 0.0 ? 1.0 / period : 0.0; }
+
+    // Espera até o início do próximo frame
+    void wait()
+    {
+        if (period <= 0.0)
+            return;
+
+        Clock::time_point now = Clock::now();
+        if (!started)
+        {
+            deadline = now;
+            started = true;
+        }
+        deadline += toDuration(period);
+
+        // Atraso de menos de um frame: segue sem esperar e mantém a cadência (o próximo prazo
+        // continua na grade). Mais de um frame: recomeça do agora em vez de acelerar para compensar
+        if (now > deadline + toDuration(period))
+        {
+            deadline = now;
+            return;
+        }
+        if (now >= deadline)
+            return;
+
+        // Sleep em fatias curtas até a margem de giro
+        for (;;)
+        {
+            double remaining = seconds(deadline - Clock::now());
+            if (remaining <= spinMargin)
+                break;
+            double slice = std::min(remaining - spinMargin, 0.001);
+            Clock::time_point before = Clock::now();
+            std::this_thread::sleep_for(toDuration(slice));
+            double overshoot = seconds(Clock::now() - before) - slice;
+            // Margem = maior atraso recente do sleep, decaindo devagar
+            spinMargin = std::max(overshoot, spinMargin * 0.99);
+            spinMargin = std::min(std::max(spinMargin, 0.0002), 0.004);
+        }
+
+        while (Clock::now() < deadline)
+            std::this_thread::yield();
+    }
+
+private:
+    double period;
+    double spinMargin; // Segundos finais feitos girando
+    bool started;
+    Clock::time_point deadline;
+
+    static double seconds(Clock::duration d) { return std::chrono::duration<double>(d).count(); }
+    static Clock::duration toDuration(double s)
+    {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(s));
+    }
+};
+
+class FrameTimeStats
+{
+public:
+    struct Percentiles
+    {
+        size_t samples = 0;
+        double averageMs = 0.0;
+        double minMs = 0.0;
+        double p50 = 0.0, p90 = 0.0, p95 = 0.0, p99 = 0.0, p999 = 0.0, maxMs = 0.0;
+    };
+
+    explicit FrameTimeStats(size_t window = 2000) : samples(window, 0.0), next(0), count(0) {}
+
+    void add(double frameMs)
+    {
+        samples[next] = frameMs;
+        next = (next + 1) % samples.size();
+        count = std::min(count + 1, samples.size());
+    }
+
+    Percentiles compute() const
+    {
+        Percentiles result;
+        result.samples = count;
+        if (count == 0)
+            return result;
+
+        std::vector<double> sorted(samples.begin(), samples.begin() + count);
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (double value : sorted)
+            sum += value;
+        result.averageMs = sum / count;
+        result.p50 = at(sorted, 0.50);
+        result.p90 = at(sorted, 0.90);
+        result.p95 = at(sorted, 0.95);
+        result.p99 = at(sorted, 0.99);
+        result.p999 = at(sorted, 0.999);
+        result.minMs = sorted.front();
+        result.maxMs = sorted.back();
+        return result;
+    }
+
+private:
+    std::vector<double> samples; // Buffer circular com os últimos frames
+    size_t next;
+    size_t count;
+
+    // Percentil pelo método do posto mais próximo
+    static double at(const std::vector<double>& sorted, double p)
+    {
+        size_t index = (size_t)std::ceil(p * sorted.size());
+        return sorted[std::min(sorted.size() - 1, index > 0 ? index - 1 : 0)];
+    }
+};
+
+class StartupTimeline
+{
+public:
+    struct Phase
+    {
+        std::string name;
+        double ms;
+    };
+
+    StartupTimeline() : origin(Clock::now()), last(origin), finishedMs(-1.0) {}
+
+    void mark(const char* phase)
+    {
+        if (isFinished())
+            return;
+        Clock::time_point now = Clock::now();
+        double ms = std::chrono::duration<double, std::milli>(now - last).count();
+        last = now;
+        for (auto& existing : phases)
+        {
+            if (existing.name == phase)
+            {
+                existing.ms += ms;
+                return;
+            }
+        }
+        phases.push_back({ phase, ms });
+    }
+
+    // Última fase; a partir daqui as marcas são ignoradas
+    void finish(const char* phase)
+    {
+        mark(phase);
+        finishedMs = std::chrono::duration<double, std::milli>(last - origin).count();
+    }
+
+    bool isFinished() const { return finishedMs >= 0.0; }
+    double getTotalMs() const { return finishedMs; }
+    const std::vector<Phase>& getPhases() const { return phases; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point origin;
+    Clock::time_point last;
+    double finishedMs;
+    std::vector<Phase> phases; // Na ordem da primeira marca
+};
+
+#endif
@@ -0,0 +1,383 @@
+// Contadores de chamadas GL por frame, instalados sobre os ponteiros da GLAD
+//
+// A GLAD guarda cada função num ponteiro global (glad_glDrawArrays etc.) e as macros
+// glDrawArrays etc. chamam através dele. install() troca esses ponteiros por funções
+// geradas por GLHook que incrementam o contador da função e repassam a chamada para o
+// ponteiro original; sem install() nada muda e não há custo. glBufferData,
+// glBufferSubData e glTexImage2D também somam os bytes enviados.
+//
+// endFrame() fecha o frame: zera os contadores, guarda o resultado em getLastFrame(),
+// acumula os totais e, se houver um log aberto, escreve uma linha com as chamadas do
+// frame em ordem alfabética (formato estável, para comparar builds com diff).
+//
+// Os contadores são atômicos: a thread de compilação de shaders usa os mesmos ponteiros
+// e suas chamadas entram no frame em que acontecem. Funções carregadas fora da GLAD
+// (glBufferStorage, glProgramBinary, ... via glLoader) não são contadas.
+
+#ifndef GL_CALL_STATS_H
+#define GL_CALL_STATS_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <glad/glad.h>
+
+class GLCallStats
+{
+public:
+    static const int MAX_ENTRIES = 128;
+
+    enum Category
+    {
+        CATEGORY_OTHER,
+        CATEGORY_DRAW,    // glDraw*
+        CATEGORY_BIND,    // glBind*, glUseProgram, glActiveTexture
+        CATEGORY_UNIFORM, // glUniform*
+        CATEGORY_STATE,   // glEnable, glDepthFunc, glViewport, ...
+        CATEGORY_UPLOAD   // glBufferData, glBufferSubData, glTexImage2D
+    };
+
+    struct FrameStats
+    {
+        uint64_t frames = 0; // Frames somados (1 em getLastFrame())
+        uint64_t calls = 0;
+        uint64_t draws = 0;
+        uint64_t binds = 0;
+        uint64_t uniforms = 0;
+        uint64_t stateChanges = 0;
+        uint64_t uploads = 0;
+        uint64_t bufferBytes = 0;
+        uint64_t textureBytes = 0;
+        std::vector<uint64_t> perEntry; // Índice = entrada (getEntryName)
+    };
+
+    GLCallStats() : entryCount(0), frameNumber(0) {}
+
+    // Depois de gladLoadGLLoader e antes de criar outras threads que usem GL
+    void install();
+    bool isInstalled() const { return active == this; }
+
+    // Log de chamadas por frame (o arquivo é sobrescrito)
+    bool openCallLog(const std::string& path)
+    {
+        callLog.open(path, std::ios::out | std::ios::trunc);
+        return callLog.is_open();
+    }
+
+    void endFrame()
+    {
+        if (!isInstalled())
+            return;
+
+        // Rascunho reaproveitado e trocado com lastFrame: sem alocação por frame (o vetor
+        // só muda de tamanho quando entram funções novas)
+        FrameStats& frame = scratchFrame;
+        frame.frames = 1;
+        frame.calls = frame.draws = frame.binds = frame.uniforms = frame.stateChanges = frame.uploads = 0;
+        if (frame.perEntry.size() != (size_t)entryCount)
+            frame.perEntry.resize(entryCount);
+        std::fill(frame.perEntry.begin(), frame.perEntry.end(), 0);
+        for (int i = 0; i < entryCount; ++i)
+        {
+            uint64_t count = counts[i].exchange(0, std::memory_order_relaxed);
+            frame.perEntry[i] = count;
+            frame.calls += count;
+            switch (categories[i])
+            {
+            case CATEGORY_DRAW: frame.draws += count; break;
+            case CATEGORY_BIND: frame.binds += count; break;
+            case CATEGORY_UNIFORM: frame.uniforms += count; break;
+            case CATEGORY_STATE: frame.stateChanges += count; break;
+            case CATEGORY_UPLOAD: frame.uploads += count; break;
+            default: break;
+            }
+        }
+        frame.bufferBytes = bufferBytes.exchange(0, std::memory_order_relaxed);
+        frame.textureBytes = textureBytes.exchange(0, std::memory_order_relaxed);
+
+        accumulate(totals, frame);
+        if (callLog.is_open())
+            writeLogLine(frame);
+        std::swap(lastFrame, scratchFrame);
+        frameNumber++;
+    }
+
+    const FrameStats& getLastFrame() const { return lastFrame; }
+    const FrameStats& getTotals() const { return totals; }
+    int getEntryCount() const { return entryCount; }
+    const char* getEntryName(int entry) const { return names[entry]; }
+
+    // Chamados pelas funções instaladas
+    static void countCall(int entry) { active->counts[entry].fetch_add(1, std::memory_order_relaxed); }
+    static void countBufferBytes(GLsizeiptr bytes)
+    {
+        if (bytes > 0)
+            active->bufferBytes.fetch_add((uint64_t)bytes, std::memory_order_relaxed);
+    }
+    static void countTextureBytes(uint64_t bytes) { active->textureBytes.fetch_add(bytes, std::memory_order_relaxed); }
+
+    int registerEntry(const char* name)
+    {
+        if (entryCount >= MAX_ENTRIES)
+            return -1;
+        names[entryCount] = name;
+        categories[entryCount] = categorize(name);
+        counts[entryCount].store(0, std::memory_order_relaxed);
+        return entryCount++;
+    }
+
+private:
+    inline static GLCallStats* active = nullptr;
+
+    std::atomic<uint64_t> counts[MAX_ENTRIES];
+    const char* names[MAX_ENTRIES];
+    Category categories[MAX_ENTRIES];
+    int entryCount;
+    std::vector<int> sortedEntries; // Ordem alfabética para o log
+    std::atomic<uint64_t> bufferBytes{ 0 };
+    std::atomic<uint64_t> textureBytes{ 0 };
+    FrameStats lastFrame;
+    FrameStats scratchFrame; // Montado em endFrame() e trocado com lastFrame
+    FrameStats totals;
+    uint64_t frameNumber;
+    std::ofstream callLog;
+
+    static bool startsWith(const char* name, const char* prefix) { return strncmp(name, prefix, strlen(prefix)) == 0; }
+
+    static Category categorize(const char* name)
+    {
+        if (startsWith(name, "glDraw") || startsWith(name, "glMultiDraw"))
+            return CATEGORY_DRAW;
+        if (startsWith(name, "glBind") || !strcmp(name, "glUseProgram") || !strcmp(name, "glActiveTexture"))
+            return CATEGORY_BIND;
+        if (startsWith(name, "glUniform"))
+            return CATEGORY_UNIFORM;
+        if (!strcmp(name, "glBufferData") || !strcmp(name, "glBufferSubData") || !strcmp(name, "glTexImage2D"))
+            return CATEGORY_UPLOAD;
+        static const char* stateCalls[] = { "glEnable", "glDisable", "glDepthFunc", "glDepthMask", "glBlendFunc",
+                                            "glColorMask", "glViewport", "glLineWidth", "glPointSize",
+                                            "glClearColor", "glPixelStorei", "glDrawBuffers" };
+        for (const char* call : stateCalls)
+        {
+            if (!strcmp(name, call))
+                return CATEGORY_STATE;
+        }
+        return CATEGORY_OTHER;
+    }
+
+    static void accumulate(FrameStats& sum, const FrameStats& frame)
+    {
+        sum.frames += frame.frames;
+        sum.calls += frame.calls;
+        sum.draws += frame.draws;
+        sum.binds += frame.binds;
+        sum.uniforms += frame.uniforms;
+        sum.stateChanges += frame.stateChanges;
+        sum.uploads += frame.uploads;
+        sum.bufferBytes += frame.bufferBytes;
+        sum.textureBytes += frame.textureBytes;
+        sum.perEntry.resize(frame.perEntry.size(), 0);
+        for (size_t i = 0; i < frame.perEntry.size(); ++i)
+            sum.perEntry[i] += frame.perEntry[i];
+    }
+
+    // "frame N: glBindBuffer=3 glDrawArrays=12 ... bytes=4096"
+    void writeLogLine(const FrameStats& frame)
+    {
+        if (sortedEntries.size() != (size_t)entryCount)
+        {
+            sortedEntries.resize(entryCount);
+            for (int i = 0; i < entryCount; ++i)
+                sortedEntries[i] = i;
+            std::sort(sortedEntries.begin(), sortedEntries.end(),
+                      [this](int a, int b) { return strcmp(names[a], names[b]) < 0; });
+        }
+        callLog << "frame " << frameNumber << ":";
+        for (int entry : sortedEntries)
+        {
+            if (frame.perEntry[entry] > 0)
+                callLog << " " << names[entry] << "=" << frame.perEntry[entry];
+        }
+        callLog << " bytes=" << frame.bufferBytes + frame.textureBytes << "\n";
+    }
+};
+
+// Substitui o ponteiro da GLAD em Slot (&glad_glX) por call(), que conta e repassa
+template <auto Slot>
+struct GLHook;
+
+template <typename R, typename... Args, R (APIENTRYP* Slot)(Args...)>
+struct GLHook<Slot>
+{
+    inline static R (APIENTRYP original)(Args...) = nullptr;
+    inline static int entry = -1;
+
+    static R APIENTRY call(Args... args)
+    {
+        GLCallStats::countCall(entry);
+        return original(args...);
+    }
+
+    static void install(GLCallStats& stats, const char* name)
+    {
+        if (!*Slot || original)
+            return; // Função não carregada pelo contexto, ou já instalada
+        entry = stats.registerEntry(name);
+        if (entry < 0)
+            return;
+        original = *Slot;
+        *Slot = &call;
+    }
+};
+
+// Bytes por pixel de uma imagem (formato + tipo) enviada com glTexImage2D
+inline uint64_t glTexelBytes(GLenum format, GLenum type)
+{
+    int components = 4;
+    switch (format)
+    {
+    case GL_RED: case GL_DEPTH_COMPONENT: components = 1; break;
+    case GL_RG: components = 2; break;
+    case GL_RGB: case GL_BGR: components = 3; break;
+    default: break;
+    }
+    switch (type)
+    {
+    case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return components * 2;
+    case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: return components * 4;
+    case GL_UNSIGNED_INT_24_8: case GL_UNSIGNED_INT_8_8_8_8: case GL_UNSIGNED_INT_2_10_10_10_REV: return 4;
+    default: return components;
+    }
+}
+
+inline void APIENTRY glCallStatsBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    GLCallStats::countBufferBytes(size);
+    GLHook<&glad_glBufferData>::call(target, size, data, usage);
+}
+
+inline void APIENTRY glCallStatsBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    GLCallStats::countBufferBytes(size);
+    GLHook<&glad_glBufferSubData>::call(target, offset, size, data);
+}
+
+inline void APIENTRY glCallStatsTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                                           GLint border, GLenum format, GLenum type, const void* pixels)
+{
+    if (pixels) // Sem dados (ou offset de um PBO) não há envio da CPU
+        GLCallStats::countTextureBytes((uint64_t)width * (uint64_t)height * glTexelBytes(format, type));
+    GLHook<&glad_glTexImage2D>::call(target, level, internalformat, width, height, border, format, type, pixels);
+}
+
+#define CG_GL_HOOK(name) GLHook<&glad_##name>::install(*this, #name)
+
+// As funções GL que o GrauBProva e os headers de include/ chamam pela GLAD
+inline void GLCallStats::install()
+{
+    if (active)
+        return;
+    active = this;
+
+    CG_GL_HOOK(glActiveTexture);
+    CG_GL_HOOK(glAttachShader);
+    CG_GL_HOOK(glBeginConditionalRender);
+    CG_GL_HOOK(glBeginQuery);
+    CG_GL_HOOK(glBindBuffer);
+    CG_GL_HOOK(glBindBufferBase);
+    CG_GL_HOOK(glBindBufferRange);
+    CG_GL_HOOK(glBindFramebuffer);
+    CG_GL_HOOK(glBindRenderbuffer);
+    CG_GL_HOOK(glBindSampler);
+    CG_GL_HOOK(glBindTexture);
+    CG_GL_HOOK(glBindVertexArray);
+    CG_GL_HOOK(glBlendFunc);
+    CG_GL_HOOK(glBlitFramebuffer);
+    CG_GL_HOOK(glBufferData);
+    CG_GL_HOOK(glBufferSubData);
+    CG_GL_HOOK(glCheckFramebufferStatus);
+    CG_GL_HOOK(glClear);
+    CG_GL_HOOK(glClearColor);
+    CG_GL_HOOK(glClientWaitSync);
+    CG_GL_HOOK(glColorMask);
+    CG_GL_HOOK(glCompileShader);
+    CG_GL_HOOK(glCreateProgram);
+    CG_GL_HOOK(glCreateShader);
+    CG_GL_HOOK(glDeleteBuffers);
+    CG_GL_HOOK(glDeleteFramebuffers);
+    CG_GL_HOOK(glDeleteProgram);
+    CG_GL_HOOK(glDeleteQueries);
+    CG_GL_HOOK(glDeleteRenderbuffers);
+    CG_GL_HOOK(glDeleteShader);
+    CG_GL_HOOK(glDeleteSync);
+    CG_GL_HOOK(glDeleteTextures);
+    CG_GL_HOOK(glDeleteVertexArrays);
+    CG_GL_HOOK(glDepthFunc);
+    CG_GL_HOOK(glDepthMask);
+    CG_GL_HOOK(glDisable);
+    CG_GL_HOOK(glDrawArrays);
+    CG_GL_HOOK(glDrawBuffers);
+    CG_GL_HOOK(glDrawElements);
+    CG_GL_HOOK(glEnable);
+    CG_GL_HOOK(glEnableVertexAttribArray);
+    CG_GL_HOOK(glEndConditionalRender);
+    CG_GL_HOOK(glEndQuery);
+    CG_GL_HOOK(glFenceSync);
+    CG_GL_HOOK(glFinish);
+    CG_GL_HOOK(glFlush);
+    CG_GL_HOOK(glFramebufferRenderbuffer);
+    CG_GL_HOOK(glFramebufferTexture2D);
+    CG_GL_HOOK(glGenBuffers);
+    CG_GL_HOOK(glGenFramebuffers);
+    CG_GL_HOOK(glGenQueries);
+    CG_GL_HOOK(glGenRenderbuffers);
+    CG_GL_HOOK(glGenTextures);
+    CG_GL_HOOK(glGenVertexArrays);
+    CG_GL_HOOK(glGenerateMipmap);
+    CG_GL_HOOK(glGetIntegerv);
+    CG_GL_HOOK(glGetProgramInfoLog);
+    CG_GL_HOOK(glGetProgramiv);
+    CG_GL_HOOK(glGetQueryObjectiv);
+    CG_GL_HOOK(glGetQueryObjectui64v);
+    CG_GL_HOOK(glGetQueryObjectuiv);
+    CG_GL_HOOK(glGetShaderInfoLog);
+    CG_GL_HOOK(glGetShaderiv);
+    CG_GL_HOOK(glGetUniformLocation);
+    CG_GL_HOOK(glLineWidth);
+    CG_GL_HOOK(glLinkProgram);
+    CG_GL_HOOK(glMapBufferRange);
+    CG_GL_HOOK(glPixelStorei);
+    CG_GL_HOOK(glPointSize);
+    CG_GL_HOOK(glQueryCounter);
+    CG_GL_HOOK(glReadPixels);
+    CG_GL_HOOK(glRenderbufferStorage);
+    CG_GL_HOOK(glShaderSource);
+    CG_GL_HOOK(glTexImage2D);
+    CG_GL_HOOK(glTexParameteri);
+    CG_GL_HOOK(glUniform1f);
+    CG_GL_HOOK(glUniform1i);
+    CG_GL_HOOK(glUniform2f);
+    CG_GL_HOOK(glUniform3f);
+    CG_GL_HOOK(glUniformMatrix4fv);
+    CG_GL_HOOK(glUnmapBuffer);
+    CG_GL_HOOK(glUseProgram);
+    CG_GL_HOOK(glVertexAttribPointer);
+    CG_GL_HOOK(glViewport);
+
+    // Envios de dados: contam a chamada (pelo GLHook) e os bytes
+    if (GLHook<&glad_glBufferData>::original)
+        glad_glBufferData = &glCallStatsBufferData;
+    if (GLHook<&glad_glBufferSubData>::original)
+        glad_glBufferSubData = &glCallStatsBufferSubData;
+    if (GLHook<&glad_glTexImage2D>::original)
+        glad_glTexImage2D = &glCallStatsTexImage2D;
+}
+
+#undef CG_GL_HOOK
+
+#endif
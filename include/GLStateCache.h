@@ -0,0 +1,474 @@
+// Cache do estado OpenGL
+//
+// Camada fina na frente da GLAD que guarda o último valor enviado de cada estado
+// (programa, VAO, texturas por unidade, buffers, samplers, blend/depth, uniforms)
+// e descarta as chamadas que não mudariam nada. Todo código que altera esses
+// estados por fora (ex.: funções de carregamento) deve chamar invalidate() depois.
+
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <unordered_map>
+#include <cstring>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+// GL 4.3
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+
+class GLStateCache
+{
+public:
+    enum Call
+    {
+        CALL_USE_PROGRAM,
+        CALL_BIND_VERTEX_ARRAY,
+        CALL_ACTIVE_TEXTURE,
+        CALL_BIND_TEXTURE,
+        CALL_BIND_SAMPLER,
+        CALL_BIND_BUFFER,
+        CALL_BIND_BUFFER_RANGE,
+        CALL_BIND_FRAMEBUFFER,
+        CALL_ENABLE,
+        CALL_BLEND_FUNC,
+        CALL_DEPTH_FUNC,
+        CALL_DEPTH_MASK,
+        CALL_COLOR_MASK,
+        CALL_LINE_WIDTH,
+        CALL_POINT_SIZE,
+        CALL_CLEAR_COLOR,
+        CALL_VIEWPORT,
+        CALL_UNIFORM,
+        CALL_COUNT
+    };
+
+    static const char* callName(int call)
+    {
+        static const char* names[CALL_COUNT] = {
+            "glUseProgram", "glBindVertexArray", "glActiveTexture", "glBindTexture",
+            "glBindSampler", "glBindBuffer", "glBindBufferRange", "glBindFramebuffer",
+            "glEnable/glDisable", "glBlendFunc", "glDepthFunc", "glDepthMask", "glColorMask",
+            "glLineWidth", "glPointSize", "glClearColor", "glViewport", "glUniform*"
+        };
+        return names[call];
+    }
+
+    struct Counters
+    {
+        long long issued[CALL_COUNT] = {};
+        long long elided[CALL_COUNT] = {};
+    };
+
+    static const int MAX_TEXTURE_UNITS = 32;
+    static const int MAX_BUFFER_BINDINGS = 16;
+
+    GLStateCache() { invalidate(); }
+
+    // Esquece todo o estado conhecido: a próxima chamada de cada tipo é sempre emitida
+    void invalidate()
+    {
+        program = UNKNOWN;
+        vertexArray = UNKNOWN;
+        activeUnit = UNKNOWN;
+        for (int u = 0; u < MAX_TEXTURE_UNITS; ++u)
+        {
+            for (int t = 0; t < TEXTURE_TARGETS; ++t)
+                textures[u][t] = UNKNOWN;
+            samplers[u] = UNKNOWN;
+        }
+        for (int b = 0; b < BUFFER_TARGETS; ++b)
+        {
+            buffers[b] = UNKNOWN;
+            for (int i = 0; i < MAX_BUFFER_BINDINGS; ++i)
+                ranges[b][i] = BufferRange();
+        }
+        drawFramebuffer = readFramebuffer = UNKNOWN;
+        for (int c = 0; c < CAPABILITIES; ++c)
+            capabilities[c] = -1;
+        blendSrc = blendDst = UNKNOWN;
+        depthFuncValue = UNKNOWN;
+        depthMaskValue = -1;
+        colorMaskValue = -1;
+        lineWidthValue = pointSizeValue = -1.0f;
+        for (int i = 0; i < 4; ++i)
+        {
+            clearColorValue[i] = -1.0f;
+            viewportValue[i] = -1;
+        }
+        uniforms.clear();
+    }
+
+    void useProgram(GLuint p)
+    {
+        if (count(CALL_USE_PROGRAM, program != p))
+        {
+            glUseProgram(p);
+            program = p;
+        }
+    }
+
+    void bindVertexArray(GLuint vao)
+    {
+        if (count(CALL_BIND_VERTEX_ARRAY, vertexArray != vao))
+        {
+            glBindVertexArray(vao);
+            vertexArray = vao;
+            // GL_ELEMENT_ARRAY_BUFFER faz parte do estado do VAO
+            buffers[bufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+        }
+    }
+
+    void activeTexture(GLenum unit)
+    {
+        if (count(CALL_ACTIVE_TEXTURE, activeUnit != unit))
+        {
+            glActiveTexture(unit);
+            activeUnit = unit;
+        }
+    }
+
+    // Vincula na unidade ativa
+    void bindTexture(GLenum target, GLuint texture)
+    {
+        int t = textureIndex(target);
+        int u = (activeUnit == UNKNOWN) ? -1 : (int)(activeUnit - GL_TEXTURE0);
+        if (t < 0 || u < 0 || u >= MAX_TEXTURE_UNITS)
+        {
+            count(CALL_BIND_TEXTURE, true);
+            glBindTexture(target, texture);
+            return;
+        }
+        if (count(CALL_BIND_TEXTURE, textures[u][t] != texture))
+        {
+            glBindTexture(target, texture);
+            textures[u][t] = texture;
+        }
+    }
+
+    // Vincula numa unidade específica, trocando a unidade ativa só se necessário
+    void bindTextureUnit(GLuint unit, GLenum target, GLuint texture)
+    {
+        int t = textureIndex(target);
+        if (t >= 0 && unit < (GLuint)MAX_TEXTURE_UNITS && textures[unit][t] == texture)
+        {
+            count(CALL_BIND_TEXTURE, false);
+            return;
+        }
+        activeTexture(GL_TEXTURE0 + unit);
+        bindTexture(target, texture);
+    }
+
+    void bindSampler(GLuint unit, GLuint sampler)
+    {
+        bool changed = unit >= (GLuint)MAX_TEXTURE_UNITS || samplers[unit] != sampler;
+        if (count(CALL_BIND_SAMPLER, changed))
+        {
+            glBindSampler(unit, sampler);
+            if (unit < (GLuint)MAX_TEXTURE_UNITS)
+                samplers[unit] = sampler;
+        }
+    }
+
+    void bindBuffer(GLenum target, GLuint buffer)
+    {
+        int b = bufferIndex(target);
+        if (count(CALL_BIND_BUFFER, b < 0 || buffers[b] != buffer))
+        {
+            glBindBuffer(target, buffer);
+            if (b >= 0)
+                buffers[b] = buffer;
+        }
+    }
+
+    // glBindBufferBase quando size == 0
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset = 0, GLsizeiptr size = 0)
+    {
+        int b = bufferIndex(target);
+        bool known = b >= 0 && index < (GLuint)MAX_BUFFER_BINDINGS;
+        if (known)
+        {
+            const BufferRange& r = ranges[b][index];
+            if (r.buffer == buffer && r.offset == offset && r.size == size)
+            {
+                count(CALL_BIND_BUFFER_RANGE, false);
+                return;
+            }
+        }
+        count(CALL_BIND_BUFFER_RANGE, true);
+        if (size == 0)
+            glBindBufferBase(target, index, buffer);
+        else
+            glBindBufferRange(target, index, buffer, offset, size);
+        if (known)
+        {
+            ranges[b][index].buffer = buffer;
+            ranges[b][index].offset = offset;
+            ranges[b][index].size = size;
+        }
+        // O bind indexado também altera o bind genérico do alvo
+        if (b >= 0)
+            buffers[b] = buffer;
+    }
+
+    void bindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+        bool drawSame = drawFramebuffer == framebuffer;
+        bool readSame = readFramebuffer == framebuffer;
+        bool changed = (target == GL_FRAMEBUFFER) ? !(drawSame && readSame)
+                     : (target == GL_DRAW_FRAMEBUFFER) ? !drawSame : !readSame;
+        if (count(CALL_BIND_FRAMEBUFFER, changed))
+        {
+            glBindFramebuffer(target, framebuffer);
+            if (target != GL_READ_FRAMEBUFFER)
+                drawFramebuffer = framebuffer;
+            if (target != GL_DRAW_FRAMEBUFFER)
+                readFramebuffer = framebuffer;
+        }
+    }
+
+    void setEnabled(GLenum cap, bool enabled)
+    {
+        int c = capabilityIndex(cap);
+        if (count(CALL_ENABLE, c < 0 || capabilities[c] != (enabled ? 1 : 0)))
+        {
+            if (enabled)
+                glEnable(cap);
+            else
+                glDisable(cap);
+            if (c >= 0)
+                capabilities[c] = enabled ? 1 : 0;
+        }
+    }
+
+    void enable(GLenum cap) { setEnabled(cap, true); }
+    void disable(GLenum cap) { setEnabled(cap, false); }
+
+    void blendFunc(GLenum src, GLenum dst)
+    {
+        if (count(CALL_BLEND_FUNC, blendSrc != src || blendDst != dst))
+        {
+            glBlendFunc(src, dst);
+            blendSrc = src;
+            blendDst = dst;
+        }
+    }
+
+    void depthFunc(GLenum func)
+    {
+        if (count(CALL_DEPTH_FUNC, depthFuncValue != func))
+        {
+            glDepthFunc(func);
+            depthFuncValue = func;
+        }
+    }
+
+    void depthMask(GLboolean flag)
+    {
+        if (count(CALL_DEPTH_MASK, depthMaskValue != (int)flag))
+        {
+            glDepthMask(flag);
+            depthMaskValue = flag;
+        }
+    }
+
+    void colorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a)
+    {
+        int mask = (r ? 1 : 0) | (g ? 2 : 0) | (b ? 4 : 0) | (a ? 8 : 0);
+        if (count(CALL_COLOR_MASK, colorMaskValue != mask))
+        {
+            glColorMask(r, g, b, a);
+            colorMaskValue = mask;
+        }
+    }
+
+    void lineWidth(GLfloat width)
+    {
+        if (count(CALL_LINE_WIDTH, lineWidthValue != width))
+        {
+            glLineWidth(width);
+            lineWidthValue = width;
+        }
+    }
+
+    void pointSize(GLfloat size)
+    {
+        if (count(CALL_POINT_SIZE, pointSizeValue != size))
+        {
+            glPointSize(size);
+            pointSizeValue = size;
+        }
+    }
+
+    void clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+    {
+        const GLfloat value[4] = { r, g, b, a };
+        if (count(CALL_CLEAR_COLOR, std::memcmp(clearColorValue, value, sizeof(value)) != 0))
+        {
+            glClearColor(r, g, b, a);
+            std::memcpy(clearColorValue, value, sizeof(value));
+        }
+    }
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        const GLint value[4] = { x, y, width, height };
+        if (count(CALL_VIEWPORT, std::memcmp(viewportValue, value, sizeof(value)) != 0))
+        {
+            glViewport(x, y, width, height);
+            std::memcpy(viewportValue, value, sizeof(value));
+        }
+    }
+
+    // Uniforms do programa atual, comparados com o último valor enviado
+    void uniform1i(GLint location, GLint v)
+    {
+        if (uniformChanged(location, &v, sizeof(v)))
+            glUniform1i(location, v);
+    }
+
+    void uniform1f(GLint location, GLfloat v)
+    {
+        if (uniformChanged(location, &v, sizeof(v)))
+            glUniform1f(location, v);
+    }
+
+    void uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z)
+    {
+        const GLfloat v[3] = { x, y, z };
+        if (uniformChanged(location, v, sizeof(v)))
+            glUniform3f(location, x, y, z);
+    }
+
+    void uniformMatrix4fv(GLint location, const GLfloat* value)
+    {
+        if (uniformChanged(location, value, 16 * sizeof(GLfloat)))
+            glUniformMatrix4fv(location, 1, GL_FALSE, value);
+    }
+
+    GLuint currentProgram() const { return program; }
+    const Counters& getCounters() const { return counters; }
+
+    long long totalIssued() const
+    {
+        long long total = 0;
+        for (int i = 0; i < CALL_COUNT; ++i)
+            total += counters.issued[i];
+        return total;
+    }
+
+    long long totalElided() const
+    {
+        long long total = 0;
+        for (int i = 0; i < CALL_COUNT; ++i)
+            total += counters.elided[i];
+        return total;
+    }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFF;
+    static const int TEXTURE_TARGETS = 4;
+    static const int BUFFER_TARGETS = 6;
+    static const int CAPABILITIES = 6;
+
+    struct BufferRange
+    {
+        GLuint buffer = UNKNOWN;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+    };
+
+    struct UniformValue
+    {
+        unsigned char data[64];
+        size_t size;
+    };
+
+    GLuint program;
+    GLuint vertexArray;
+    GLenum activeUnit;
+    GLuint textures[MAX_TEXTURE_UNITS][TEXTURE_TARGETS];
+    GLuint samplers[MAX_TEXTURE_UNITS];
+    GLuint buffers[BUFFER_TARGETS];
+    BufferRange ranges[BUFFER_TARGETS][MAX_BUFFER_BINDINGS];
+    GLuint drawFramebuffer, readFramebuffer;
+    int capabilities[CAPABILITIES];
+    GLenum blendSrc, blendDst;
+    GLenum depthFuncValue;
+    int depthMaskValue;
+    int colorMaskValue;
+    GLfloat lineWidthValue, pointSizeValue;
+    GLfloat clearColorValue[4];
+    GLint viewportValue[4];
+    std::unordered_map<uint64_t, UniformValue> uniforms;
+    Counters counters;
+
+    bool count(Call call, bool changed)
+    {
+        if (changed)
+            counters.issued[call]++;
+        else
+            counters.elided[call]++;
+        return changed;
+    }
+
+    bool uniformChanged(GLint location, const void* data, size_t size)
+    {
+        if (location < 0 || program == UNKNOWN || size > sizeof(UniformValue::data))
+            return count(CALL_UNIFORM, location >= 0);
+
+        uint64_t key = ((uint64_t)program << 32) | (uint32_t)location;
+        UniformValue& cached = uniforms[key];
+        bool changed = cached.size != size || std::memcmp(cached.data, data, size) != 0;
+        if (changed)
+        {
+            std::memcpy(cached.data, data, size);
+            cached.size = size;
+        }
+        return count(CALL_UNIFORM, changed);
+    }
+
+    static int textureIndex(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_CUBE_MAP: return 1;
+        case GL_TEXTURE_2D_ARRAY: return 2;
+        case GL_TEXTURE_3D: return 3;
+        default: return -1;
+        }
+    }
+
+    static int bufferIndex(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_ARRAY_BUFFER: return 0;
+        case GL_ELEMENT_ARRAY_BUFFER: return 1;
+        case GL_UNIFORM_BUFFER: return 2;
+        case GL_SHADER_STORAGE_BUFFER: return 3;
+        case GL_COPY_WRITE_BUFFER: return 4;
+        case GL_PIXEL_PACK_BUFFER: return 5;
+        default: return -1;
+        }
+    }
+
+    static int capabilityIndex(GLenum cap)
+    {
+        switch (cap)
+        {
+        case GL_DEPTH_TEST: return 0;
+        case GL_BLEND: return 1;
+        case GL_CULL_FACE: return 2;
+        case GL_SCISSOR_TEST: return 3;
+        case GL_STENCIL_TEST: return 4;
+        case GL_PROGRAM_POINT_SIZE: return 5;
+        default: return -1;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,223 @@
+// Profiler de GPU com timer queries
+//
+// Cada escopo nomeado grava dois GL_TIMESTAMP (glQueryCounter) no início e no fim, o que
+// permite escopos aninhados (GL_TIME_ELAPSED não pode ser aninhado). As queries ficam num
+// anel de FRAME_LATENCY frames: o frame N só é lido em beginFrame() do frame
+// N + FRAME_LATENCY, e só se GL_QUERY_RESULT_AVAILABLE já disser que está pronto; senão o
+// resultado é descartado e contado em getFramesMissed(). A CPU nunca espera pela GPU.
+//
+// Os tempos lidos alimentam médias móveis dos últimos HISTORY frames por escopo e,
+// opcionalmente, um CSV (frame, escopo, profundidade, ms).
+
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+class GpuProfiler
+{
+public:
+    static const int FRAME_LATENCY = 4; // Frames em voo antes da leitura
+    static const int MAX_SCOPES = 32;   // Escopos por frame
+    static const int HISTORY = 64;      // Frames na média móvel
+
+    struct ScopeStats
+    {
+        std::string name;
+        int depth = 0;          // Aninhamento (0 = escopo externo)
+        double lastMs = 0.0;
+        double averageMs = 0.0; // Média dos últimos HISTORY frames em que apareceu
+        double maxMs = 0.0;     // Máximo dentro da mesma janela
+        double history[HISTORY] = {};
+        int historyCount = 0;
+        int historyNext = 0;
+        uint64_t samples = 0;   // Frames lidos desde o início (para quem coleta lastMs)
+    };
+
+    GpuProfiler() : frameNumber(0), openDepth(0), framesRead(0), framesMissed(0), droppedScopes(0), initialized(false) {}
+
+    void init()
+    {
+        for (FrameSlot& slot : slots)
+        {
+            glGenQueries(MAX_SCOPES * 2, slot.queries);
+            slot.count = 0;
+            slot.pending = false;
+        }
+        initialized = true;
+    }
+
+    void destroy()
+    {
+        if (!initialized)
+            return;
+        for (FrameSlot& slot : slots)
+            glDeleteQueries(MAX_SCOPES * 2, slot.queries);
+        initialized = false;
+        if (csv.is_open())
+            csv.close();
+    }
+
+    // Grava os tempos de cada frame lido (o arquivo é sobrescrito)
+    bool openCsv(const std::string& path)
+    {
+        csv.open(path, std::ios::out | std::ios::trunc);
+        if (!csv.is_open())
+            return false;
+        csv << "frame,scope,depth,ms\n";
+        return true;
+    }
+
+    // Lê o frame que ocupava esta posição do anel e começa um novo
+    void beginFrame()
+    {
+        FrameSlot& slot = slots[frameNumber % FRAME_LATENCY];
+        if (slot.pending)
+            collect(slot);
+        slot.frame = frameNumber;
+        slot.count = 0;
+        slot.pending = false;
+        openDepth = 0;
+    }
+
+    void endFrame()
+    {
+        FrameSlot& slot = slots[frameNumber % FRAME_LATENCY];
+        slot.pending = slot.count > 0;
+        frameNumber++;
+    }
+
+    // Abre um escopo; devolve o índice para endScope() (-1 se o frame já está cheio)
+    int beginScope(const char* name)
+    {
+        FrameSlot& slot = slots[frameNumber % FRAME_LATENCY];
+        if (!initialized || slot.count >= MAX_SCOPES)
+        {
+            droppedScopes++;
+            return -1;
+        }
+        int index = slot.count++;
+        slot.scopes[index] = findOrAddScope(name, openDepth);
+        openDepth++;
+        slot.lastQuery = slot.queries[index * 2];
+        glQueryCounter(slot.lastQuery, GL_TIMESTAMP);
+        return index;
+    }
+
+    void endScope(int index)
+    {
+        if (index < 0)
+            return;
+        FrameSlot& slot = slots[frameNumber % FRAME_LATENCY];
+        slot.lastQuery = slot.queries[index * 2 + 1];
+        glQueryCounter(slot.lastQuery, GL_TIMESTAMP);
+        openDepth = std::max(0, openDepth - 1);
+    }
+
+    // Escopo válido até o fim do bloco
+    class Scope
+    {
+    public:
+        Scope(GpuProfiler& profiler, const char* name) : owner(profiler), index(profiler.beginScope(name)) {}
+        ~Scope() { owner.endScope(index); }
+
+    private:
+        GpuProfiler& owner;
+        int index;
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // Escopos na ordem em que apareceram pela primeira vez
+    const std::vector<ScopeStats>& getScopes() const { return scopes; }
+    uint64_t getFramesRead() const { return framesRead; }
+    uint64_t getFramesMissed() const { return framesMissed; }
+    uint64_t getDroppedScopes() const { return droppedScopes; }
+
+private:
+    struct FrameSlot
+    {
+        GLuint queries[MAX_SCOPES * 2];
+        int scopes[MAX_SCOPES]; // Índice em GpuProfiler::scopes
+        int count = 0;
+        GLuint lastQuery = 0;   // Última emitida: a última a ficar pronta
+        uint64_t frame = 0;
+        bool pending = false;
+    };
+
+    FrameSlot slots[FRAME_LATENCY];
+    std::vector<ScopeStats> scopes;
+    std::ofstream csv;
+    uint64_t frameNumber;
+    int openDepth;
+    uint64_t framesRead;
+    uint64_t framesMissed;
+    uint64_t droppedScopes;
+    bool initialized;
+
+    // Poucos escopos: busca linear pelo nome (e profundidade, para o mesmo nome em dois níveis)
+    int findOrAddScope(const char* name, int depth)
+    {
+        for (size_t i = 0; i < scopes.size(); ++i)
+        {
+            if (scopes[i].depth == depth && scopes[i].name == name)
+                return (int)i;
+        }
+        ScopeStats stats;
+        stats.name = name;
+        stats.depth = depth;
+        scopes.push_back(stats);
+        return (int)scopes.size() - 1;
+    }
+
+    void collect(FrameSlot& slot)
+    {
+        // Os timestamps terminam na ordem em que foram emitidos: se o último está pronto,
+        // todos estão
+        GLint available = 0;
+        glGetQueryObjectiv(slot.lastQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            framesMissed++;
+            return;
+        }
+
+        for (int i = 0; i < slot.count; ++i)
+        {
+            GLuint64 start = 0, end = 0;
+            glGetQueryObjectui64v(slot.queries[i * 2], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(slot.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+            double ms = end > start ? (double)(end - start) / 1.0e6 : 0.0;
+            addSample(scopes[slot.scopes[i]], ms);
+            if (csv.is_open())
+                csv << slot.frame << "," << scopes[slot.scopes[i]].name << "," << scopes[slot.scopes[i]].depth << "," << ms << "\n";
+        }
+        framesRead++;
+    }
+
+    static void addSample(ScopeStats& stats, double ms)
+    {
+        stats.lastMs = ms;
+        stats.samples++;
+        stats.history[stats.historyNext] = ms;
+        stats.historyNext = (stats.historyNext + 1) % HISTORY;
+        stats.historyCount = std::min(stats.historyCount + 1, HISTORY);
+
+        double sum = 0.0, maximum = 0.0;
+        for (int i = 0; i < stats.historyCount; ++i)
+        {
+            sum += stats.history[i];
+            maximum = std::max(maximum, stats.history[i]);
+        }
+        stats.averageMs = sum / stats.historyCount;
+        stats.maxMs = maximum;
+    }
+};
+
+#endif
@@ -0,0 +1,188 @@
+// Renderização sem janela (modo --headless)
+//
+// HeadlessContext cria um contexto OpenGL core por EGL sem superfície nenhuma
+// (EGL_MESA_platform_surfaceless + EGL_KHR_surfaceless_context), que funciona em
+// máquinas sem servidor gráfico e sem GPU com o llvmpipe da Mesa. Só existe quando o
+// projeto é compilado com EGL (CG_HAVE_EGL, definido pelo CMake).
+//
+// OffscreenTarget é o framebuffer onde esse modo desenha: cor RGBA8 e profundidade
+// DEPTH24_STENCIL8 (o formato que o passo deferred copia com glBlitFramebuffer),
+// com leitura para PNG.
+
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <stb_image_write.h>
+
+#include "GLStateCache.h"
+
+#ifdef CG_HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+class HeadlessContext
+{
+public:
+    HeadlessContext() : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT) {}
+
+    // Tenta 4.6 core e depois 4.5 (o mínimo dos shaders, #version 450)
+    bool create()
+    {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay)
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display == EGL_NO_DISPLAY)
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+        EGLint major = 0, minor = 0;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+        {
+            std::cout << "ERROR::HEADLESS::EGL_INITIALIZE_FAILED 0x" << std::hex << eglGetError() << std::dec << std::endl;
+            return false;
+        }
+        if (!eglBindAPI(EGL_OPENGL_API))
+        {
+            std::cout << "ERROR::HEADLESS::EGL_OPENGL_API_UNAVAILABLE" << std::endl;
+            return false;
+        }
+
+        const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+        {
+            std::cout << "ERROR::HEADLESS::EGL_NO_CONFIG" << std::endl;
+            return false;
+        }
+
+        const EGLint minorVersions[2] = { 6, 5 };
+        for (EGLint minorVersion : minorVersions)
+        {
+            const EGLint contextAttributes[] = {
+                EGL_CONTEXT_MAJOR_VERSION, 4,
+                EGL_CONTEXT_MINOR_VERSION, minorVersion,
+                EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                EGL_NONE
+            };
+            context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+            if (context != EGL_NO_CONTEXT)
+                break;
+        }
+        if (context == EGL_NO_CONTEXT)
+        {
+            std::cout << "ERROR::HEADLESS::EGL_CREATE_CONTEXT_FAILED 0x" << std::hex << eglGetError() << std::dec << std::endl;
+            return false;
+        }
+
+        // Sem superfície: tudo é desenhado em FBOs
+        if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        {
+            std::cout << "ERROR::HEADLESS::EGL_MAKE_CURRENT_FAILED 0x" << std::hex << eglGetError() << std::dec << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void destroy()
+    {
+        if (display == EGL_NO_DISPLAY)
+            return;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT)
+            eglDestroyContext(display, context);
+        eglTerminate(display);
+        display = EGL_NO_DISPLAY;
+        context = EGL_NO_CONTEXT;
+    }
+
+    // Para gladLoadGLLoader (EGL 1.5 devolve também as funções do núcleo)
+    static void* getProcAddress(const char* name)
+    {
+        return (void*)eglGetProcAddress(name);
+    }
+
+private:
+    EGLDisplay display;
+    EGLContext context;
+};
+#endif
+
+class OffscreenTarget
+{
+public:
+    OffscreenTarget() : fbo(0), colorBuffer(0), depthBuffer(0), width(0), height(0) {}
+
+    bool init(int w, int h)
+    {
+        width = w;
+        height = h;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+        glGenRenderbuffers(1, &colorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "ERROR::HEADLESS::FRAMEBUFFER_INCOMPLETE 0x" << std::hex << status << std::dec << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void destroy()
+    {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &colorBuffer);
+        glDeleteRenderbuffers(1, &depthBuffer);
+        fbo = colorBuffer = depthBuffer = 0;
+    }
+
+    GLuint getFramebuffer() const { return fbo; }
+
+    // Lê a cor (RGB, a primeira linha é a de cima) e grava em PNG
+    bool savePNG(GLStateCache& state, const std::string& path)
+    {
+        state.bindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        pixels.resize((size_t)width * height * 3);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+        stbi_flip_vertically_on_write(1); // O GL lê de baixo para cima
+        return stbi_write_png(path.c_str(), width, height, 3, pixels.data(), width * 3) != 0;
+    }
+
+private:
+    GLuint fbo;
+    GLuint colorBuffer;
+    GLuint depthBuffer;
+    int width, height;
+    std::vector<unsigned char> pixels;
+};
+
+#endif
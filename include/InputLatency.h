@@ -0,0 +1,253 @@
+// Latência do input até a imagem e limite de frames na fila da GPU
+//
+// A thread de eventos chama noteInput() a cada movimento do mouse: guarda o instante do
+// primeiro evento ainda não usado por um frame e a última orientação da câmera (yaw e
+// pitch num único atômico de 64 bits, para nunca misturar valores de eventos diferentes).
+// Quem monta o frame consome o instante com takeInput() e o passa a setFrameInput().
+//
+// Depois da troca de buffers, endFrame() põe um glQueryCounter(GL_TIMESTAMP) e um
+// glFenceSync atrás do comando de apresentação. Quando a fence sinaliza, o timestamp da
+// GPU, convertido para o relógio da CPU por uma calibração com glGetInteger64v
+// (GL_TIMESTAMP) refeita a cada segundo, marca o fim do frame na GPU. A latência vai do
+// evento até aí. A varredura da tela e o compositor ficam de fora: é um limite inferior
+// do tempo até a imagem aparecer, bom para comparar configurações na mesma máquina.
+//
+// beginFrame() recolhe os frames já terminados sem esperar. Com setMaxQueuedFrames(n),
+// espera na fence mais antiga até haver menos de n frames em voo. Assim o driver não
+// enfileira frames à frente, e cada frame é montado com um input mais novo.
+//
+// Tudo, menos noteInput/takeInput/latestOrientation, roda na thread dona do contexto GL.
+
+#ifndef INPUT_LATENCY_H
+#define INPUT_LATENCY_H
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include "FrameTiming.h"
+
+class InputLatency
+{
+public:
+    static const int MAX_FRAMES_IN_FLIGHT = 8;
+
+    struct Stats
+    {
+        uint64_t frames = 0;       // Frames cujo fim na GPU já foi lido
+        uint64_t inputFrames = 0;  // Desses, os que levaram um evento de mouse
+        uint64_t cappedFrames = 0; // Frames que esperaram o limite de fila
+        double queueWaitMs = 0.0;  // Espera total da CPU pelo limite de fila
+        int maxInFlight = 0;       // Maior número de frames em voo visto
+    };
+
+    InputLatency()
+        : pendingInput(0), orientation(0), hasOrientation(false), enabled(false), maxQueued(0), frameInput(0),
+          head(0), inFlight(0), gpuOffsetNs(0), lastCalibrationNs(0), lastLatencyMs(-1.0)
+    {
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+            queries[i] = 0;
+    }
+
+    static int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Thread de eventos: movimento do mouse que já mudou a câmera para (yaw, pitch)
+    void noteInput(float yaw, float pitch)
+    {
+        uint32_t yawBits, pitchBits;
+        memcpy(&yawBits, &yaw, sizeof(yawBits));
+        memcpy(&pitchBits, &pitch, sizeof(pitchBits));
+        orientation.store(((uint64_t)yawBits << 32) | pitchBits, std::memory_order_relaxed);
+        hasOrientation.store(true, std::memory_order_release); // Publica a orientação acima
+        // A orientação vai antes do instante: quem consome o instante já vê este evento
+        int64_t expected = 0;
+        pendingInput.compare_exchange_strong(expected, nowNs(), std::memory_order_release, std::memory_order_relaxed);
+    }
+
+    // Instante do evento mais antigo ainda não usado por um frame (0 = nenhum); o consome
+    int64_t takeInput() { return pendingInput.exchange(0, std::memory_order_acq_rel); }
+
+    // Orientação do último evento (false = o mouse ainda não se moveu)
+    bool latestOrientation(float& yaw, float& pitch) const
+    {
+        if (!hasOrientation.load(std::memory_order_acquire))
+            return false;
+        uint64_t packed = orientation.load(std::memory_order_acquire);
+        uint32_t yawBits = (uint32_t)(packed >> 32), pitchBits = (uint32_t)packed;
+        memcpy(&yaw, &yawBits, sizeof(yaw));
+        memcpy(&pitch, &pitchBits, sizeof(pitch));
+        return true;
+    }
+
+    // Configuração (antes do primeiro frame)
+    void setEnabled(bool measure) { enabled = measure; }
+    void setMaxQueuedFrames(int frames) { maxQueued = std::min(std::max(frames, 0), MAX_FRAMES_IN_FLIGHT); }
+    int getMaxQueuedFrames() const { return maxQueued; }
+    bool isActive() const { return enabled || maxQueued > 0; }
+
+    // Início do frame: recolhe os terminados e aplica o limite de fila
+    void beginFrame()
+    {
+        if (!isActive())
+            return;
+        while (inFlight > 0 && retireOldest(false))
+        {
+        }
+        if (maxQueued == 0 || inFlight < maxQueued)
+            return;
+        int64_t start = nowNs();
+        while (inFlight >= maxQueued && retireOldest(true))
+        {
+        }
+        stats.cappedFrames++;
+        stats.queueWaitMs += (nowNs() - start) / 1e6;
+    }
+
+    // Instante do input que o frame atual mostra (0 = nenhum)
+    void setFrameInput(int64_t inputNs) { frameInput = inputNs; }
+
+    // Logo depois da troca de buffers
+    void endFrame()
+    {
+        if (!isActive())
+            return;
+        int64_t submitNs = nowNs();
+        if (queries[0] == 0)
+            glGenQueries(MAX_FRAMES_IN_FLIGHT, queries);
+        if (submitNs - lastCalibrationNs > 1000000000LL)
+            calibrate();
+        if (inFlight == MAX_FRAMES_IN_FLIGHT)
+            retireOldest(true);
+        if (inFlight == MAX_FRAMES_IN_FLIGHT)
+            return; // GPU presa há mais de 100 ms: este frame fica sem medição
+
+        int slot = (head + inFlight) % MAX_FRAMES_IN_FLIGHT;
+        Frame& frame = frames[slot];
+        frame.inputNs = frameInput;
+        frame.submitNs = submitNs;
+        glQueryCounter(queries[slot], GL_TIMESTAMP);
+        frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        inFlight++;
+        stats.maxInFlight = std::max(stats.maxInFlight, inFlight);
+        if (frameInput != 0)
+            inputToSubmit.add((submitNs - frameInput) / 1e6);
+        frameInput = 0;
+    }
+
+    // Libera fences e queries (contexto GL atual)
+    void destroy()
+    {
+        for (; inFlight > 0; --inFlight, head = (head + 1) % MAX_FRAMES_IN_FLIGHT)
+            glDeleteSync(frames[head].fence);
+        if (queries[0] != 0)
+            glDeleteQueries(MAX_FRAMES_IN_FLIGHT, queries);
+        queries[0] = 0;
+    }
+
+    const Stats& getStats() const { return stats; }
+    FrameTimeStats::Percentiles getInputToGpu() const { return inputToGpu.compute(); }
+    double getLastLatencyMs() const { return lastLatencyMs; } // -1 = nenhuma medição
+
+    void report(std::ostream& out, bool lateLatch) const
+    {
+        if (stats.frames == 0)
+            return;
+        out << "Latência do input (late latch " << (lateLatch ? "ligado" : "desligado") << ", fila da GPU "
+            << (maxQueued > 0 ? "limitada a " + std::to_string(maxQueued) + " frames" : std::string("sem limite"))
+            << "): " << stats.inputFrames << " de " << stats.frames << " frames com movimento do mouse" << std::endl;
+        printPercentiles(out, "input até a troca de buffers", inputToSubmit.compute());
+        printPercentiles(out, "input até o fim do frame na GPU", inputToGpu.compute());
+        printPercentiles(out, "troca de buffers até o fim na GPU", submitToGpu.compute());
+        out << "  Frames em voo: máx. " << stats.maxInFlight;
+        if (maxQueued > 0)
+            out << ", " << stats.cappedFrames << " frames esperaram a fila (" << stats.queueWaitMs << " ms no total)";
+        out << std::endl;
+    }
+
+private:
+    struct Frame
+    {
+        int64_t inputNs = 0;
+        int64_t submitNs = 0;
+        GLsync fence = nullptr;
+    };
+
+    // Escritos pela thread de eventos
+    std::atomic<int64_t> pendingInput;
+    std::atomic<uint64_t> orientation;
+    std::atomic<bool> hasOrientation;
+
+    // Só a thread GL
+    bool enabled;
+    int maxQueued;
+    int64_t frameInput;
+    Frame frames[MAX_FRAMES_IN_FLIGHT];
+    GLuint queries[MAX_FRAMES_IN_FLIGHT];
+    int head;
+    int inFlight;
+    int64_t gpuOffsetNs;       // Relógio da CPU menos relógio da GPU
+    int64_t lastCalibrationNs;
+    double lastLatencyMs;
+    Stats stats;
+    FrameTimeStats inputToSubmit;
+    FrameTimeStats inputToGpu;
+    FrameTimeStats submitToGpu;
+
+    void calibrate()
+    {
+        GLint64 gpuNs = 0;
+        int64_t before = nowNs();
+        glGetInteger64v(GL_TIMESTAMP, &gpuNs);
+        int64_t after = nowNs();
+        gpuOffsetNs = (before + after) / 2 - (int64_t)gpuNs;
+        lastCalibrationNs = after;
+    }
+
+    // Lê o frame mais antigo se a fence já passou (wait: espera até 100 ms por ela)
+    bool retireOldest(bool wait)
+    {
+        Frame& frame = frames[head];
+        GLenum result = glClientWaitSync(frame.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 100000000 : 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+            return false;
+        glDeleteSync(frame.fence);
+        frame.fence = nullptr;
+
+        if (result != GL_WAIT_FAILED)
+        {
+            GLuint64 gpuNs = 0;
+            glGetQueryObjectui64v(queries[head], GL_QUERY_RESULT, &gpuNs);
+            int64_t doneNs = (int64_t)gpuNs + gpuOffsetNs;
+            stats.frames++;
+            submitToGpu.add(std::max<int64_t>(doneNs - frame.submitNs, 0) / 1e6);
+            if (frame.inputNs != 0)
+            {
+                lastLatencyMs = std::max<int64_t>(doneNs - frame.inputNs, 0) / 1e6;
+                inputToGpu.add(lastLatencyMs);
+                stats.inputFrames++;
+            }
+        }
+        head = (head + 1) % MAX_FRAMES_IN_FLIGHT;
+        inFlight--;
+        return true;
+    }
+
+    static void printPercentiles(std::ostream& out, const char* name, const FrameTimeStats::Percentiles& p)
+    {
+        if (p.samples == 0)
+            return;
+        out << "  " << name << ": média " << p.averageMs << " ms, p50 " << p.p50 << ", p90 " << p.p90 << ", p99 "
+            << p.p99 << ", máx. " << p.maxMs << " ms" << std::endl;
+    }
+};
+
+#endif
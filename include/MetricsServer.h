@@ -0,0 +1,260 @@
+// Métricas ao vivo num socket Unix local
+//
+// MetricsRegistry guarda valores numéricos com nome (tempo de frame, desenhos, memória de
+// vídeo, trajetórias...) em atômicos: quem mede só faz um store relaxado por valor, sem
+// trava e sem esperar o servidor. O registro de nomes também não trava (um fetch_add no
+// índice); os nomes precisam ser literais, porque só o ponteiro é guardado. Valores
+// ainda não medidos saem como null.
+//
+// MetricsServer roda numa thread própria: aceita clientes num socket AF_UNIX e, na
+// frequência pedida, manda a todos uma linha de JSON com todas as métricas
+// ({"t":segundos,"nome":valor,...}). Não faz chamada GL nem espera as threads que medem.
+// O envio não bloqueia: um cliente que não lê rápido o bastante para caber a linha
+// inteira no buffer do socket é desconectado (uma linha cortada quebraria o JSON).
+//
+// O cliente de linha de comando é o cg_metrics (src/cg_metrics.cpp). Fora de sistemas
+// Unix o servidor não inicia.
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CG_METRICS_HAVE_UNIX_SOCKETS
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+class MetricsRegistry
+{
+public:
+    static const int MAX_METRICS = 64;
+    typedef int Handle; // -1 = não registrada (set() ignora)
+
+    MetricsRegistry() : count(0)
+    {
+        for (int i = 0; i < MAX_METRICS; ++i)
+        {
+            names[i] = nullptr;
+            values[i].store(std::numeric_limits<double>::quiet_NaN(), std::memory_order_relaxed);
+            published[i].store(false, std::memory_order_relaxed);
+        }
+    }
+
+    Handle add(const char* name)
+    {
+        int index = count.fetch_add(1, std::memory_order_relaxed);
+        if (index >= MAX_METRICS)
+            return -1;
+        names[index] = name;
+        published[index].store(true, std::memory_order_release); // O nome fica visível junto
+        return index;
+    }
+
+    void set(Handle handle, double value)
+    {
+        if (handle >= 0)
+            values[handle].store(value, std::memory_order_relaxed);
+    }
+
+    // Uma linha de JSON com todas as métricas publicadas; devolve o tamanho (0 = não coube)
+    size_t writeJsonLine(char* buffer, size_t size, double seconds) const
+    {
+        int used = snprintf(buffer, size, "{\"t\":%.3f", seconds);
+        int total = std::min(count.load(std::memory_order_relaxed), MAX_METRICS);
+        for (int i = 0; i < total && used > 0 && (size_t)used < size; ++i)
+        {
+            if (!published[i].load(std::memory_order_acquire))
+                continue;
+            double value = values[i].load(std::memory_order_relaxed);
+            if (std::isfinite(value))
+                used += snprintf(buffer + used, size - used, ",\"%s\":%.6g", names[i], value);
+            else
+                used += snprintf(buffer + used, size - used, ",\"%s\":null", names[i]);
+        }
+        if (used <= 0 || (size_t)used + 2 >= size)
+            return 0;
+        buffer[used++] = '}';
+        buffer[used++] = '\n';
+        return (size_t)used;
+    }
+
+private:
+    std::atomic<int> count;
+    const char* names[MAX_METRICS];
+    std::atomic<double> values[MAX_METRICS];
+    std::atomic<bool> published[MAX_METRICS];
+};
+
+class MetricsServer
+{
+public:
+    MetricsServer() : registry(nullptr), listenFd(-1), intervalSeconds(0.1), running(false), clientCount(0), linesSent(0) {}
+    ~MetricsServer() { stop(); }
+
+    // Cria o socket em path (um arquivo antigo no caminho é removido) e começa a enviar
+    // hz linhas por segundo
+    bool start(const MetricsRegistry& metrics, const std::string& socketPath, double hz)
+    {
+#ifdef CG_METRICS_HAVE_UNIX_SOCKETS
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+        {
+            fprintf(stderr, "ERROR::METRICS::INVALID_PATH %s\n", socketPath.c_str());
+            return false;
+        }
+        memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0)
+        {
+            fprintf(stderr, "ERROR::METRICS::SOCKET_FAILED %s\n", strerror(errno));
+            return false;
+        }
+        unlink(socketPath.c_str());
+        if (bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, 8) != 0)
+        {
+            fprintf(stderr, "ERROR::METRICS::BIND_FAILED %s: %s\n", socketPath.c_str(), strerror(errno));
+            close(listenFd);
+            listenFd = -1;
+            return false;
+        }
+        fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL, 0) | O_NONBLOCK);
+
+        registry = &metrics;
+        path = socketPath;
+        intervalSeconds = 1.0 / std::max(0.1, hz);
+        running.store(true);
+        thread = std::thread(&MetricsServer::serverLoop, this);
+        return true;
+#else
+        (void)metrics;
+        (void)socketPath;
+        (void)hz;
+        fprintf(stderr, "ERROR::METRICS::UNSUPPORTED sockets Unix indisponíveis nesta plataforma\n");
+        return false;
+#endif
+    }
+
+    void stop()
+    {
+        if (!running.exchange(false))
+            return;
+        thread.join();
+#ifdef CG_METRICS_HAVE_UNIX_SOCKETS
+        for (int fd : clients)
+            close(fd);
+        clients.clear();
+        close(listenFd);
+        listenFd = -1;
+        unlink(path.c_str());
+#endif
+    }
+
+    bool isRunning() const { return running.load(); }
+    int getClientCount() const { return clientCount.load(std::memory_order_relaxed); }
+    uint64_t getLinesSent() const { return linesSent.load(std::memory_order_relaxed); }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    const MetricsRegistry* registry;
+    std::string path;
+    int listenFd;
+    double intervalSeconds;
+    std::atomic<bool> running;
+    std::atomic<int> clientCount;
+    std::atomic<uint64_t> linesSent;
+    std::vector<int> clients; // Só a thread do servidor mexe
+    std::thread thread;
+
+#ifdef CG_METRICS_HAVE_UNIX_SOCKETS
+    void serverLoop()
+    {
+        char line[8192];
+        Clock::time_point origin = Clock::now();
+        Clock::time_point nextSend = origin;
+        while (running.load(std::memory_order_relaxed))
+        {
+            // Espera conexões até o próximo envio (no máximo 100 ms, para stop() responder)
+            double waitMs = std::chrono::duration<double, std::milli>(nextSend - Clock::now()).count();
+            pollfd listening = { listenFd, POLLIN, 0 };
+            if (poll(&listening, 1, (int)std::max(0.0, std::min(waitMs, 100.0))) > 0)
+                acceptClients();
+            if (Clock::now() < nextSend)
+                continue;
+            nextSend += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(intervalSeconds));
+            if (nextSend < Clock::now())
+                nextSend = Clock::now(); // Atrasou (suspensão, depurador): não manda em rajada
+
+            if (clients.empty())
+                continue;
+            double seconds = std::chrono::duration<double>(Clock::now() - origin).count();
+            size_t length = registry->writeJsonLine(line, sizeof(line), seconds);
+            if (length == 0)
+                continue;
+            for (size_t i = 0; i < clients.size();)
+            {
+                if (sendLine(clients[i], line, length))
+                {
+                    ++i;
+                    continue;
+                }
+                close(clients[i]);
+                clients.erase(clients.begin() + i);
+            }
+            clientCount.store((int)clients.size(), std::memory_order_relaxed);
+            linesSent.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void acceptClients()
+    {
+        for (;;)
+        {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0)
+                break;
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+            clients.push_back(fd);
+        }
+        clientCount.store((int)clients.size(), std::memory_order_relaxed);
+    }
+
+    // Linha inteira ou nada: envio parcial, buffer cheio ou cliente fechado desconectam
+    static bool sendLine(int fd, const char* line, size_t length)
+    {
+#ifdef MSG_NOSIGNAL
+        int flags = MSG_NOSIGNAL;
+#else
+        int flags = 0;
+#endif
+        ssize_t sent = send(fd, line, length, flags);
+        return sent == (ssize_t)length;
+    }
+#else
+    void serverLoop() {}
+#endif
+};
+
+#endif
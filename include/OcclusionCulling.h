@@ -0,0 +1,504 @@
+// Culling de oclusão por software (CPU)
+//
+// Rasteriza a profundidade de oclusores de poucos polígonos (ex.: as paredes do
+// WallCorner) em um depth buffer pequeno (256x128), monta uma hierarquia min/max
+// por tiles e testa a caixa envolvente de cada objeto contra ela antes do loop de
+// desenho. A rasterização usa AVX2/SSE quando disponível e roda em threads de
+// trabalho, em paralelo com o que a GPU ainda processa do frame anterior.
+
+#ifndef OCCLUSION_CULLING_H
+#define OCCLUSION_CULLING_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "CpuTracer.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OCCLUSION_SIMD_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_SIMD_LANES 4
+#else
+#define OCCLUSION_SIMD_LANES 1
+#endif
+
+// Oclusor: triângulos em espaço de objeto (3 vértices por triângulo) + matriz de modelo
+struct OccluderInstance
+{
+    const std::vector<glm::vec3>* triangles;
+    glm::mat4 model;
+};
+
+// Objeto a ser testado: caixa envolvente em espaço de objeto + matriz de modelo
+struct OccludeeBounds
+{
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    glm::mat4 model;
+};
+
+class OcclusionCuller
+{
+public:
+    static const int BUFFER_WIDTH = 256;
+    static const int BUFFER_HEIGHT = 128;
+    static const int TILE_SIZE = 8;         // Nível 1 da hierarquia: tiles de 8x8 pixels
+    static const int SUPER_TILE = 4;        // Nível 2: blocos de 4x4 tiles (32x32 pixels)
+    static const int TILES_X = BUFFER_WIDTH / TILE_SIZE;
+    static const int TILES_Y = BUFFER_HEIGHT / TILE_SIZE;
+    static const int SUPER_X = TILES_X / SUPER_TILE;
+    static const int SUPER_Y = TILES_Y / SUPER_TILE;
+
+    explicit OcclusionCuller(int workerCount = 0)
+        : depth(BUFFER_WIDTH * BUFFER_HEIGHT, 1.0f),
+          tileMin(TILES_X * TILES_Y, 1.0f), tileMax(TILES_X * TILES_Y, 1.0f),
+          superMin(SUPER_X * SUPER_Y, 1.0f), superMax(SUPER_X * SUPER_Y, 1.0f),
+          generation(0), rasterDone(0), finished(0), stopping(false),
+          lastCullTimeMs(0.0f), lastCulledCount(0), totalFrames(0), totalCulled(0), totalCullTimeMs(0.0)
+    {
+        if (workerCount <= 0)
+        {
+            int hw = (int)std::thread::hardware_concurrency();
+            workerCount = std::max(1, std::min(4, hw - 1));
+        }
+        // Cada worker é dono de uma faixa de linhas de tiles do depth buffer
+        workerCount = std::min(workerCount, (int)TILES_Y);
+
+        for (int i = 0; i < workerCount; ++i)
+        {
+            workers.emplace_back(&OcclusionCuller::workerLoop, this, i);
+        }
+    }
+
+    ~OcclusionCuller()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        startCondition.notify_all();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    // Dispara o culling do frame. Retorna imediatamente; os resultados são obtidos
+    // com waitResults(). Os vetores de triângulos dos oclusores devem continuar
+    // válidos até lá.
+    void beginFrame(const glm::mat4& viewProjection,
+                    const std::vector<OccluderInstance>& occluders,
+                    const std::vector<OccludeeBounds>& objects)
+    {
+        frameStart = std::chrono::steady_clock::now();
+
+        // Transformação e clipping dos oclusores (poucos triângulos, feito aqui mesmo)
+        screenTriangles.clear();
+        for (const auto& occluder : occluders)
+        {
+            glm::mat4 mvp = viewProjection * occluder.model;
+            const auto& tris = *occluder.triangles;
+            for (size_t i = 0; i + 2 < tris.size(); i += 3)
+            {
+                setupTriangle(mvp * glm::vec4(tris[i], 1.0f),
+                              mvp * glm::vec4(tris[i + 1], 1.0f),
+                              mvp * glm::vec4(tris[i + 2], 1.0f));
+            }
+        }
+
+        this->viewProjection = viewProjection;
+        testObjects.assign(objects.begin(), objects.end());
+        visibility.assign(objects.size(), 1);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            rasterDone.store(0);
+            finished = 0;
+            generation++;
+        }
+        startCondition.notify_all();
+    }
+
+    // Espera os workers terminarem e devolve 1 (visível) ou 0 (oculto) por objeto
+    const std::vector<uint8_t>& waitResults()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCondition.wait(lock, [this]() { return finished == (int)workers.size(); });
+        lock.unlock();
+
+        int culled = 0;
+        for (uint8_t v : visibility)
+        {
+            if (!v)
+                culled++;
+        }
+        lastCulledCount = culled;
+        lastCullTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        totalFrames++;
+        totalCulled += culled;
+        totalCullTimeMs += lastCullTimeMs;
+        return visibility;
+    }
+
+    int getWorkerCount() const { return (int)workers.size(); }
+    int getLastCulledCount() const { return lastCulledCount; }
+    float getLastCullTimeMs() const { return lastCullTimeMs; }
+    long long getTotalFrames() const { return totalFrames; }
+    double getAverageCulled() const { return totalFrames ? (double)totalCulled / totalFrames : 0.0; }
+    double getAverageCullTimeMs() const { return totalFrames ? totalCullTimeMs / totalFrames : 0.0; }
+    const std::vector<float>& getDepthBuffer() const { return depth; }
+
+private:
+    // Triângulo em espaço de tela com equações de aresta e plano de profundidade
+    struct ScreenTriangle
+    {
+        float edgeA[3], edgeB[3], edgeC[3];
+        float depthDx, depthDy, depthC;
+        int minX, maxX, minY, maxY;
+    };
+
+    std::vector<float> depth;
+    std::vector<float> tileMin, tileMax;
+    std::vector<float> superMin, superMax;
+    std::vector<ScreenTriangle> screenTriangles;
+    std::vector<OccludeeBounds> testObjects;
+    std::vector<uint8_t> visibility;
+    glm::mat4 viewProjection;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+    unsigned long long generation;
+    std::atomic<int> rasterDone;
+    int finished;
+    bool stopping;
+
+    std::chrono::steady_clock::time_point frameStart;
+    float lastCullTimeMs;
+    int lastCulledCount;
+    long long totalFrames;
+    long long totalCulled;
+    double totalCullTimeMs;
+
+    void workerLoop(int index)
+    {
+        CG_TRACE_THREAD("culling de oclusão");
+        unsigned long long seenGeneration = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                startCondition.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+                if (stopping)
+                    return;
+                seenGeneration = generation;
+            }
+
+            CG_TRACE_SCOPE("culling de oclusão");
+            int workerCount = (int)workers.size();
+
+            // Fase 1: cada worker rasteriza e monta a hierarquia da sua faixa
+            int tileRowBegin = (TILES_Y * index) / workerCount;
+            int tileRowEnd = (TILES_Y * (index + 1)) / workerCount;
+            rasterizeBand(tileRowBegin * TILE_SIZE, tileRowEnd * TILE_SIZE);
+            buildHierarchy(tileRowBegin, tileRowEnd);
+
+            // Barreira: os testes leem o buffer inteiro
+            rasterDone.fetch_add(1);
+            while (rasterDone.load() < workerCount)
+            {
+                std::this_thread::yield();
+            }
+            buildSuperTiles(index, workerCount);
+            rasterDone.fetch_add(1);
+            while (rasterDone.load() < 2 * workerCount)
+            {
+                std::this_thread::yield();
+            }
+
+            // Fase 2: testes dos objetos intercalados entre os workers
+            for (size_t i = index; i < testObjects.size(); i += workerCount)
+            {
+                visibility[i] = testBounds(testObjects[i]) ? 1 : 0;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished++;
+            }
+            doneCondition.notify_one();
+        }
+    }
+
+    // Recorta o triângulo contra o plano near (z > -w) e registra os resultantes
+    void setupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+    {
+        const glm::vec4 input[3] = { a, b, c };
+        glm::vec4 clipped[4];
+        int count = 0;
+
+        for (int i = 0; i < 3; ++i)
+        {
+            const glm::vec4& p = input[i];
+            const glm::vec4& q = input[(i + 1) % 3];
+            float dp = p.z + p.w;
+            float dq = q.z + q.w;
+
+            if (dp >= 0.0f)
+                clipped[count++] = p;
+            if ((dp >= 0.0f) != (dq >= 0.0f))
+            {
+                float t = dp / (dp - dq);
+                clipped[count++] = p + (q - p) * t;
+            }
+        }
+
+        if (count < 3)
+            return;
+
+        glm::vec3 screen[4];
+        for (int i = 0; i < count; ++i)
+        {
+            float invW = 1.0f / std::max(clipped[i].w, 1e-6f);
+            screen[i] = glm::vec3((clipped[i].x * invW * 0.5f + 0.5f) * BUFFER_WIDTH,
+                                  (clipped[i].y * invW * 0.5f + 0.5f) * BUFFER_HEIGHT,
+                                  clipped[i].z * invW * 0.5f + 0.5f);
+        }
+
+        addScreenTriangle(screen[0], screen[1], screen[2]);
+        if (count == 4)
+            addScreenTriangle(screen[0], screen[2], screen[3]);
+    }
+
+    void addScreenTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+    {
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+        if (std::fabs(area) < 1e-8f)
+            return;
+
+        ScreenTriangle tri;
+        tri.minX = std::max(0, (int)std::floor(std::min(v0.x, std::min(v1.x, v2.x))));
+        tri.maxX = std::min(BUFFER_WIDTH - 1, (int)std::ceil(std::max(v0.x, std::max(v1.x, v2.x))));
+        tri.minY = std::max(0, (int)std::floor(std::min(v0.y, std::min(v1.y, v2.y))));
+        tri.maxY = std::min(BUFFER_HEIGHT - 1, (int)std::ceil(std::max(v0.y, std::max(v1.y, v2.y))));
+        if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+            return;
+
+        // Arestas orientadas de forma que o interior seja positivo (as paredes são vistas dos dois lados)
+        float sign = area > 0.0f ? 1.0f : -1.0f;
+        const glm::vec3* v[3] = { &v0, &v1, &v2 };
+        for (int e = 0; e < 3; ++e)
+        {
+            const glm::vec3& p = *v[(e + 1) % 3];
+            const glm::vec3& q = *v[(e + 2) % 3];
+            tri.edgeA[e] = (p.y - q.y) * sign;
+            tri.edgeB[e] = (q.x - p.x) * sign;
+            tri.edgeC[e] = (p.x * q.y - p.y * q.x) * sign;
+        }
+
+        // Plano de profundidade z(x, y) = dzdx * x + dzdy * y + c
+        float invArea = 1.0f / area;
+        tri.depthDx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) * invArea;
+        tri.depthDy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) * invArea;
+        tri.depthC = v0.z - tri.depthDx * v0.x - tri.depthDy * v0.y;
+
+        screenTriangles.push_back(tri);
+    }
+
+    void rasterizeBand(int rowBegin, int rowEnd)
+    {
+        std::fill(depth.begin() + rowBegin * BUFFER_WIDTH, depth.begin() + rowEnd * BUFFER_WIDTH, 1.0f);
+
+        for (const auto& tri : screenTriangles)
+        {
+            int y0 = std::max(rowBegin, tri.minY);
+            int y1 = std::min(rowEnd - 1, tri.maxY);
+            int x0 = tri.minX & ~(OCCLUSION_SIMD_LANES - 1);
+
+            for (int y = y0; y <= y1; ++y)
+            {
+                float py = y + 0.5f;
+                float* row = &depth[y * BUFFER_WIDTH];
+                float rowE0 = tri.edgeB[0] * py + tri.edgeC[0];
+                float rowE1 = tri.edgeB[1] * py + tri.edgeC[1];
+                float rowE2 = tri.edgeB[2] * py + tri.edgeC[2];
+                float rowZ = tri.depthDy * py + tri.depthC;
+
+#if OCCLUSION_SIMD_LANES == 8
+                const __m256 lanes = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+                const __m256 zero = _mm256_setzero_ps();
+                for (int x = x0; x <= tri.maxX; x += 8)
+                {
+                    __m256 px = _mm256_add_ps(_mm256_set1_ps((float)x), lanes);
+                    __m256 e0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(tri.edgeA[0]), px), _mm256_set1_ps(rowE0));
+                    __m256 e1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(tri.edgeA[1]), px), _mm256_set1_ps(rowE1));
+                    __m256 e2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(tri.edgeA[2]), px), _mm256_set1_ps(rowE2));
+                    __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ),
+                                                                _mm256_cmp_ps(e1, zero, _CMP_GE_OQ)),
+                                                  _mm256_cmp_ps(e2, zero, _CMP_GE_OQ));
+                    if (_mm256_movemask_ps(inside) == 0)
+                        continue;
+                    __m256 z = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(tri.depthDx), px), _mm256_set1_ps(rowZ));
+                    __m256 old = _mm256_loadu_ps(row + x);
+                    _mm256_storeu_ps(row + x, _mm256_blendv_ps(old, _mm256_min_ps(old, z), inside));
+                }
+#elif OCCLUSION_SIMD_LANES == 4
+                const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+                const __m128 zero = _mm_setzero_ps();
+                for (int x = x0; x <= tri.maxX; x += 4)
+                {
+                    __m128 px = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+                    __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.edgeA[0]), px), _mm_set1_ps(rowE0));
+                    __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.edgeA[1]), px), _mm_set1_ps(rowE1));
+                    __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.edgeA[2]), px), _mm_set1_ps(rowE2));
+                    __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                                               _mm_cmpge_ps(e2, zero));
+                    if (_mm_movemask_ps(inside) == 0)
+                        continue;
+                    __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.depthDx), px), _mm_set1_ps(rowZ));
+                    __m128 old = _mm_loadu_ps(row + x);
+                    __m128 nearer = _mm_min_ps(old, z);
+                    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+                }
+#else
+                for (int x = x0; x <= tri.maxX; ++x)
+                {
+                    float px = x + 0.5f;
+                    if (tri.edgeA[0] * px + rowE0 < 0.0f || tri.edgeA[1] * px + rowE1 < 0.0f || tri.edgeA[2] * px + rowE2 < 0.0f)
+                        continue;
+                    float z = tri.depthDx * px + rowZ;
+                    if (z < row[x])
+                        row[x] = z;
+                }
+#endif
+            }
+        }
+    }
+
+    // Nível 1: min/max por tile de 8x8
+    void buildHierarchy(int tileRowBegin, int tileRowEnd)
+    {
+        for (int ty = tileRowBegin; ty < tileRowEnd; ++ty)
+        {
+            for (int tx = 0; tx < TILES_X; ++tx)
+            {
+                float tMin = 1.0f, tMax = 0.0f;
+                for (int y = 0; y < TILE_SIZE; ++y)
+                {
+                    const float* row = &depth[(ty * TILE_SIZE + y) * BUFFER_WIDTH + tx * TILE_SIZE];
+                    for (int x = 0; x < TILE_SIZE; ++x)
+                    {
+                        tMin = std::min(tMin, row[x]);
+                        tMax = std::max(tMax, row[x]);
+                    }
+                }
+                tileMin[ty * TILES_X + tx] = tMin;
+                tileMax[ty * TILES_X + tx] = tMax;
+            }
+        }
+    }
+
+    // Nível 2: min/max por bloco de 4x4 tiles
+    void buildSuperTiles(int index, int workerCount)
+    {
+        for (int s = index; s < SUPER_X * SUPER_Y; s += workerCount)
+        {
+            int sx = s % SUPER_X, sy = s / SUPER_X;
+            float sMin = 1.0f, sMax = 0.0f;
+            for (int ty = sy * SUPER_TILE; ty < (sy + 1) * SUPER_TILE; ++ty)
+            {
+                for (int tx = sx * SUPER_TILE; tx < (sx + 1) * SUPER_TILE; ++tx)
+                {
+                    sMin = std::min(sMin, tileMin[ty * TILES_X + tx]);
+                    sMax = std::max(sMax, tileMax[ty * TILES_X + tx]);
+                }
+            }
+            superMin[s] = sMin;
+            superMax[s] = sMax;
+        }
+    }
+
+    // Retorna true se alguma parte da caixa pode estar visível
+    bool testBounds(const OccludeeBounds& object) const
+    {
+        glm::mat4 mvp = viewProjection * object.model;
+        float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+        float nearestDepth = 1.0f, farthestDepth = 0.0f;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            glm::vec3 corner((i & 1) ? object.boundsMax.x : object.boundsMin.x,
+                             (i & 2) ? object.boundsMax.y : object.boundsMin.y,
+                             (i & 4) ? object.boundsMax.z : object.boundsMin.z);
+            glm::vec4 clip = mvp * glm::vec4(corner, 1.0f);
+
+            // Caixa cruzando o plano near: conservadoramente visível
+            if (clip.z < -clip.w || clip.w <= 1e-6f)
+                return true;
+
+            float invW = 1.0f / clip.w;
+            float sx = (clip.x * invW * 0.5f + 0.5f) * BUFFER_WIDTH;
+            float sy = (clip.y * invW * 0.5f + 0.5f) * BUFFER_HEIGHT;
+            float sz = clip.z * invW * 0.5f + 0.5f;
+            minX = std::min(minX, sx);
+            maxX = std::max(maxX, sx);
+            minY = std::min(minY, sy);
+            maxY = std::max(maxY, sy);
+            nearestDepth = std::min(nearestDepth, sz);
+            farthestDepth = std::max(farthestDepth, sz);
+        }
+
+        int x0 = std::max(0, (int)std::floor(minX));
+        int x1 = std::min(BUFFER_WIDTH - 1, (int)std::floor(maxX));
+        int y0 = std::max(0, (int)std::floor(minY));
+        int y1 = std::min(BUFFER_HEIGHT - 1, (int)std::floor(maxY));
+
+        // Fora da tela
+        if (x0 > x1 || y0 > y1)
+            return false;
+
+        int tx0 = x0 / TILE_SIZE, tx1 = x1 / TILE_SIZE;
+        int ty0 = y0 / TILE_SIZE, ty1 = y1 / TILE_SIZE;
+
+        for (int sy = ty0 / SUPER_TILE; sy <= ty1 / SUPER_TILE; ++sy)
+        {
+            for (int sx = tx0 / SUPER_TILE; sx <= tx1 / SUPER_TILE; ++sx)
+            {
+                int s = sy * SUPER_X + sx;
+                if (nearestDepth > superMax[s])
+                    continue; // Bloco inteiro cobre o objeto
+                if (farthestDepth < superMin[s])
+                    return true; // Objeto inteiro na frente de tudo neste bloco
+
+                int bx0 = std::max(tx0, sx * SUPER_TILE), bx1 = std::min(tx1, (sx + 1) * SUPER_TILE - 1);
+                int by0 = std::max(ty0, sy * SUPER_TILE), by1 = std::min(ty1, (sy + 1) * SUPER_TILE - 1);
+                for (int ty = by0; ty <= by1; ++ty)
+                {
+                    for (int tx = bx0; tx <= bx1; ++tx)
+                    {
+                        if (nearestDepth <= tileMax[ty * TILES_X + tx])
+                            return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,286 @@
+// Culling de oclusão por GPU com occlusion queries
+//
+// Para objetos caros (ex.: SuzanneSubdiv1) a caixa envolvente é desenhada dentro de
+// uma query GL_ANY_SAMPLES_PASSED_CONSERVATIVE, sem escrever cor nem profundidade.
+// No estilo do CHC++, o resultado do frame anterior decide o que fazer:
+// - objeto visível: é desenhado direto e a query só é reemitida de tempos em tempos;
+// - objeto oculto: é desenhado com glBeginConditionalRender, e a própria GPU
+//   descarta o desenho se a query do frame atual não passar.
+// Os resultados só são lidos quando GL_QUERY_RESULT_AVAILABLE indica que estão
+// prontos, então a CPU nunca espera pela GPU.
+//
+// Um objeto que não chega às queries (rejeitado pelo culling da CPU, ou todos quando
+// as queries são desligadas) é invalidado: as queries em voo viram descartáveis e o
+// próximo desenho é direto, já com uma query nova, em vez de usar um resultado velho.
+
+#ifndef OCCLUSION_QUERIES_H
+#define OCCLUSION_QUERIES_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include <glad/glad.h>
+#include "GLStateCache.h"
+
+// GL 4.3 / ARB_ES3_compatibility
+#ifndef GL_ANY_SAMPLES_PASSED_CONSERVATIVE
+#define GL_ANY_SAMPLES_PASSED_CONSERVATIVE 0x8D6A
+#endif
+
+class OcclusionQuerySystem
+{
+public:
+    static const int QUERIES_PER_OBJECT = 3;   // Queries em voo por objeto
+    static const int VISIBLE_REQUERY_INTERVAL = 4; // Objetos visíveis são retestados a cada N frames
+    static const int MAX_TRACKED_LATENCY = 8;
+
+    struct Stats
+    {
+        long long frames = 0;
+        long long queriesIssued = 0;
+        long long resultsRead = 0;
+        long long directDraws = 0;        // Desenhados sem condição (visíveis no frame anterior)
+        long long conditionalDraws = 0;   // Desenhados com glBeginConditionalRender
+        long long skippedDraws = 0;       // Desenhos condicionais descartados pela GPU
+        long long starvedQueries = 0;     // Sem query livre para o objeto neste frame
+        long long lateFrames = 0;         // Soma dos frames de atraso além do primeiro
+        int maxLatencyFrames = 0;
+        long long latencyHistogram[MAX_TRACKED_LATENCY + 1] = {};
+    };
+
+    OcclusionQuerySystem() : boxVAO(0), boxVBO(0), target(GL_ANY_SAMPLES_PASSED), frame(0) {}
+
+    void init()
+    {
+        // Conservativo quando disponível (GL 4.3), senão a query exata
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        target = (major > 4 || (major == 4 && minor >= 3)) ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+
+        // Cubo unitário [0,1]^3, escalado para a caixa envolvente de cada objeto
+        const GLfloat c[8][3] = {
+            {0,0,0}, {1,0,0}, {1,1,0}, {0,1,0},
+            {0,0,1}, {1,0,1}, {1,1,1}, {0,1,1}
+        };
+        const int faces[36] = {
+            0,1,2, 0,2,3,  4,6,5, 4,7,6,  0,4,5, 0,5,1,
+            3,2,6, 3,6,7,  0,3,7, 0,7,4,  1,5,6, 1,6,2
+        };
+        GLfloat vertices[36 * 3];
+        for (int i = 0; i < 36; ++i)
+        {
+            vertices[i * 3 + 0] = c[faces[i]][0];
+            vertices[i * 3 + 1] = c[faces[i]][1];
+            vertices[i * 3 + 2] = c[faces[i]][2];
+        }
+
+        glGenBuffers(1, &boxVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, boxVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        glGenVertexArrays(1, &boxVAO);
+        glBindVertexArray(boxVAO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+        glEnableVertexAttribArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    void destroy()
+    {
+        reset(0);
+        glDeleteVertexArrays(1, &boxVAO);
+        glDeleteBuffers(1, &boxVBO);
+        boxVAO = boxVBO = 0;
+    }
+
+    // Ajusta o número de objetos acompanhados (ex.: após recarregar a cena)
+    void reset(size_t objectCount)
+    {
+        for (auto& obj : objects)
+        {
+            glDeleteQueries(QUERIES_PER_OBJECT, obj.queries);
+        }
+        objects.assign(objectCount, ObjectState());
+        for (auto& obj : objects)
+        {
+            glGenQueries(QUERIES_PER_OBJECT, obj.queries);
+        }
+    }
+
+    size_t getObjectCount() const { return objects.size(); }
+
+    // Lê, sem bloquear, todos os resultados que a GPU já terminou
+    void beginFrame()
+    {
+        frame++;
+        stats.frames++;
+
+        for (auto& obj : objects)
+        {
+            for (int q = 0; q < QUERIES_PER_OBJECT; ++q)
+            {
+                if (!obj.pending[q])
+                    continue;
+
+                GLuint available = 0;
+                glGetQueryObjectuiv(obj.queries[q], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    continue;
+
+                // Emitida antes de invalidate(): só libera a query, fora das estatísticas
+                if (obj.stale[q])
+                {
+                    obj.pending[q] = false;
+                    obj.stale[q] = false;
+                    continue;
+                }
+
+                GLuint passed = 0;
+                glGetQueryObjectuiv(obj.queries[q], GL_QUERY_RESULT, &passed);
+                obj.pending[q] = false;
+                stats.resultsRead++;
+
+                int latency = (int)(frame - obj.issueFrame[q]);
+                stats.latencyHistogram[std::min(latency, (int)MAX_TRACKED_LATENCY)]++;
+                stats.maxLatencyFrames = std::max(stats.maxLatencyFrames, latency);
+                if (latency > 1)
+                    stats.lateFrames += latency - 1;
+
+                if (obj.conditional[q] && passed == 0)
+                    stats.skippedDraws++;
+
+                // Resultados podem chegar fora de ordem: só o mais recente vale
+                if (obj.issueFrame[q] >= obj.resultFrame)
+                {
+                    obj.resultFrame = obj.issueFrame[q];
+                    obj.visible = passed != 0;
+                }
+            }
+        }
+    }
+
+    // Desenha o objeto index aplicando a query. boxObjectIndex aponta para a entrada do
+    // SSBO de objetos cuja matriz leva o cubo unitário para a caixa envolvente em espaço
+    // de mundo; drawObject() faz o desenho real (inclusive selecionar a própria entrada).
+    template <typename DrawFn>
+    void drawObject(GLStateCache& state, size_t index, GLint objectIndexLoc, GLint boxObjectIndex, bool cameraInsideBox, DrawFn drawObject)
+    {
+        ObjectState& obj = objects[index];
+
+        // Com a câmera dentro da caixa a query falharia: sempre visível
+        if (cameraInsideBox)
+        {
+            obj.visible = true;
+            obj.lastQueryFrame = frame;
+            stats.directDraws++;
+            drawObject();
+            return;
+        }
+
+        bool wantQuery = !obj.visible || frame - obj.lastQueryFrame >= VISIBLE_REQUERY_INTERVAL;
+        int slot = -1;
+        if (wantQuery)
+        {
+            for (int q = 0; q < QUERIES_PER_OBJECT; ++q)
+            {
+                if (!obj.pending[q])
+                {
+                    slot = q;
+                    break;
+                }
+            }
+            if (slot < 0)
+                stats.starvedQueries++;
+        }
+
+        if (slot >= 0)
+        {
+            // Caixa envolvente só contra o depth buffer, sem escrever nada
+            state.colorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            state.depthMask(GL_FALSE);
+            glBeginQuery(target, obj.queries[slot]);
+            state.uniform1i(objectIndexLoc, boxObjectIndex);
+            state.bindVertexArray(boxVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+            glEndQuery(target);
+            state.colorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            state.depthMask(GL_TRUE);
+            stats.queriesIssued++;
+
+            obj.pending[slot] = true;
+            obj.issueFrame[slot] = frame;
+            obj.conditional[slot] = !obj.visible;
+            obj.lastQueryFrame = frame;
+        }
+
+        if (slot >= 0 && !obj.visible)
+        {
+            // Espera é feita pela GPU, não pela CPU
+            glBeginConditionalRender(obj.queries[slot], GL_QUERY_WAIT);
+            drawObject();
+            glEndConditionalRender();
+            stats.conditionalDraws++;
+        }
+        else
+        {
+            // Visível no frame anterior (ou sem query livre): desenho conservador
+            drawObject();
+            stats.directDraws++;
+        }
+    }
+
+    // Esquece o estado de um objeto que não passou pelas queries neste frame
+    void invalidate(size_t index)
+    {
+        ObjectState& obj = objects[index];
+        for (int q = 0; q < QUERIES_PER_OBJECT; ++q)
+        {
+            if (obj.pending[q])
+                obj.stale[q] = true;
+        }
+        obj.visible = true;
+        obj.lastQueryFrame = frame - VISIBLE_REQUERY_INTERVAL;
+    }
+
+    void invalidateAll()
+    {
+        for (size_t i = 0; i < objects.size(); ++i)
+            invalidate(i);
+    }
+
+    const Stats& getStats() const { return stats; }
+
+    double getAverageLatencyFrames() const
+    {
+        long long total = 0, count = 0;
+        for (int i = 0; i <= MAX_TRACKED_LATENCY; ++i)
+        {
+            total += stats.latencyHistogram[i] * i;
+            count += stats.latencyHistogram[i];
+        }
+        return count ? (double)total / count : 0.0;
+    }
+
+private:
+    struct ObjectState
+    {
+        GLuint queries[QUERIES_PER_OBJECT] = {};
+        bool pending[QUERIES_PER_OBJECT] = {};
+        bool conditional[QUERIES_PER_OBJECT] = {};
+        bool stale[QUERIES_PER_OBJECT] = {}; // Resultado descartado ao chegar (invalidate)
+        long long issueFrame[QUERIES_PER_OBJECT] = {};
+        long long resultFrame = -1;
+        long long lastQueryFrame = -VISIBLE_REQUERY_INTERVAL;
+        bool visible = true;
+    };
+
+    std::vector<ObjectState> objects;
+    GLuint boxVAO, boxVBO;
+    GLenum target;
+    long long frame;
+    Stats stats;
+};
+
+#endif
@@ -0,0 +1,329 @@
+// Contadores de hardware (Linux, perf_event_open) em escopos nomeados
+//
+// Cada thread abre na primeira medição um grupo de contadores do próprio processo, só
+// em modo usuário: ciclos (líder), instruções, cache misses, branch misses e dTLB
+// misses de leitura. Um grupo é lido de uma vez (PERF_FORMAT_GROUP), então todos os
+// valores de um escopo cobrem o mesmo intervalo; se o kernel multiplexar os contadores,
+// os valores são escalados por tempo habilitado / tempo rodando.
+//
+// PerfCounters::Scope mede um bloco e soma no escopo de mesmo nome, junto com a
+// quantidade de elementos processados (vértices, objetos, desenhos...), para o relatório
+// mostrar IPC e eventos por elemento. Sem enable() (ou fora do Linux) os escopos não
+// fazem nada. Se o kernel recusar (perf_event_paranoid, contêiner sem PMU, VM), o motivo
+// é mostrado uma vez e as medições seguem desligadas; contadores que faltarem sozinhos
+// (dTLB em muitas VMs) aparecem como indisponíveis.
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <ostream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <cerrno>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+class PerfCounters
+{
+public:
+    enum Counter
+    {
+        CYCLES,
+        INSTRUCTIONS,
+        CACHE_MISSES,
+        BRANCH_MISSES,
+        DTLB_MISSES,
+        COUNTER_COUNT
+    };
+
+    struct ScopeStats
+    {
+        std::string name;
+        uint64_t calls = 0;
+        uint64_t elements = 0;
+        double values[COUNTER_COUNT] = {};
+    };
+
+    static PerfCounters& instance()
+    {
+        static PerfCounters counters;
+        return counters;
+    }
+
+    static const char* counterName(int counter)
+    {
+        static const char* names[COUNTER_COUNT] = { "ciclos", "instruções", "cache misses", "branch misses", "dTLB misses" };
+        return names[counter];
+    }
+
+    // Liga as medições (os grupos são abertos por thread, na primeira medição)
+    void enable()
+    {
+#ifdef __linux__
+        enabled.store(true, std::memory_order_relaxed);
+#else
+        reportFailure("perf_event_open só existe no Linux");
+#endif
+    }
+
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Contadores que o kernel aceitou (na primeira thread que abriu o grupo)
+    bool isCounterAvailable(int counter) const { return (availableMask.load() >> counter) & 1u; }
+
+    // Escopos na ordem em que apareceram pela primeira vez (cópia feita sob o mutex)
+    std::vector<ScopeStats> getScopes()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return scopes;
+    }
+
+    // Relatório por escopo: IPC e eventos por elemento
+    void report(std::ostream& out)
+    {
+        std::vector<ScopeStats> snapshot = getScopes();
+        if (snapshot.empty())
+            return;
+        out << "Contadores de hardware (modo usuário):" << std::endl;
+        for (const auto& scope : snapshot)
+        {
+            double perElement = scope.elements > 0 ? 1.0 / (double)scope.elements : 0.0;
+            out << "  " << scope.name << ": " << scope.calls << " medições, " << scope.elements << " elementos";
+            if (isCounterAvailable(CYCLES) && isCounterAvailable(INSTRUCTIONS) && scope.values[CYCLES] > 0.0)
+                out << ", IPC " << scope.values[INSTRUCTIONS] / scope.values[CYCLES];
+            out << std::endl << "    por elemento:";
+            for (int c = 0; c < COUNTER_COUNT; ++c)
+            {
+                if (isCounterAvailable(c))
+                    out << " " << counterName(c) << " " << scope.values[c] * perElement << ";";
+                else
+                    out << " " << counterName(c) << " indisponível;";
+            }
+            out << std::endl;
+        }
+    }
+
+private:
+    // Leitura de um grupo: valores brutos + tempos para a escala de multiplexação
+    struct Sample
+    {
+        uint64_t values[COUNTER_COUNT] = {};
+        uint64_t timeEnabled = 0;
+        uint64_t timeRunning = 0;
+    };
+
+    // Grupo de contadores de uma thread
+    struct Group
+    {
+        int fds[COUNTER_COUNT];
+        int slot[COUNTER_COUNT]; // Posição do contador na leitura do grupo (-1 = não aberto)
+        int opened = 0;
+        int leader = -1;
+
+        Group()
+        {
+            for (int c = 0; c < COUNTER_COUNT; ++c)
+            {
+                fds[c] = -1;
+                slot[c] = -1;
+            }
+        }
+
+        ~Group()
+        {
+#ifdef __linux__
+            for (int fd : fds)
+            {
+                if (fd >= 0)
+                    close(fd);
+            }
+#endif
+        }
+
+        bool read(Sample& sample)
+        {
+#ifdef __linux__
+            uint64_t buffer[3 + COUNTER_COUNT];
+            ssize_t bytes = ::read(leader, buffer, sizeof(buffer));
+            if (bytes < (ssize_t)(3 * sizeof(uint64_t)))
+                return false;
+            sample.timeEnabled = buffer[1];
+            sample.timeRunning = buffer[2];
+            for (int c = 0; c < COUNTER_COUNT; ++c)
+                sample.values[c] = slot[c] >= 0 && (uint64_t)slot[c] < buffer[0] ? buffer[3 + slot[c]] : 0;
+            return true;
+#else
+            (void)sample;
+            return false;
+#endif
+        }
+    };
+
+public:
+    // Mede o bloco; setElements() pode ser chamado quando a quantidade só é conhecida no fim
+    class Scope
+    {
+    public:
+        Scope(const char* scopeName, uint64_t elementCount = 0) : name(scopeName), elements(elementCount), group(nullptr)
+        {
+            PerfCounters& counters = PerfCounters::instance();
+            if (!counters.isEnabled())
+                return;
+            group = counters.threadGroup();
+            if (group && !group->read(start))
+                group = nullptr;
+        }
+        ~Scope()
+        {
+            if (!group)
+                return;
+            Sample end;
+            if (group->read(end))
+                PerfCounters::instance().accumulate(name, elements, start, end);
+        }
+        void setElements(uint64_t elementCount) { elements = elementCount; }
+
+    private:
+        const char* name;
+        uint64_t elements;
+        Group* group;
+        Sample start;
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+private:
+    std::atomic<bool> enabled{ false };
+    std::atomic<bool> failed{ false };
+    std::atomic<uint32_t> availableMask{ 0 };
+    std::mutex mutex;
+    std::vector<ScopeStats> scopes;
+    std::vector<std::unique_ptr<Group>> groups; // Donos dos grupos (as threads guardam ponteiros)
+
+    PerfCounters() {}
+
+    void reportFailure(const std::string& reason)
+    {
+        if (failed.exchange(true))
+            return;
+        enabled.store(false, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex);
+        fprintf(stderr, "ERROR::PERF::UNAVAILABLE %s: medições de hardware desligadas\n", reason.c_str());
+    }
+
+    // Grupo da thread atual (aberto na primeira chamada; nullptr se o kernel recusar)
+    Group* threadGroup()
+    {
+        thread_local Group* group = nullptr;
+        thread_local bool attempted = false;
+        if (attempted)
+            return group;
+        attempted = true;
+#ifdef __linux__
+        std::unique_ptr<Group> created(new Group());
+        int firstError = 0;
+        for (int c = 0; c < COUNTER_COUNT; ++c)
+        {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.disabled = created->leader < 0 ? 1 : 0; // O grupo é ligado de uma vez pelo líder
+            configure(attr, c);
+
+            int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, created->leader, 0);
+            if (fd < 0)
+            {
+                if (!firstError)
+                    firstError = errno;
+                continue;
+            }
+            if (created->leader < 0)
+                created->leader = fd;
+            created->fds[c] = fd;
+            created->slot[c] = created->opened++;
+        }
+        if (created->leader < 0)
+        {
+            const char* hint = "";
+            if (firstError == EACCES || firstError == EPERM)
+                hint = " (veja /proc/sys/kernel/perf_event_paranoid)";
+            else if (firstError == ENOENT || firstError == EOPNOTSUPP)
+                hint = " (CPU ou VM sem contadores de hardware expostos)";
+            reportFailure(std::string("perf_event_open: ") + strerror(firstError) + hint);
+            return nullptr;
+        }
+        ioctl(created->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(created->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+        uint32_t mask = 0;
+        for (int c = 0; c < COUNTER_COUNT; ++c)
+            mask |= created->fds[c] >= 0 ? (1u << c) : 0u;
+        availableMask.fetch_or(mask);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        group = created.get();
+        groups.push_back(std::move(created));
+#endif
+        return group;
+    }
+
+#ifdef __linux__
+    static void configure(perf_event_attr& attr, int counter)
+    {
+        attr.type = PERF_TYPE_HARDWARE;
+        switch (counter)
+        {
+        case CYCLES: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case INSTRUCTIONS: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case CACHE_MISSES: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+        case BRANCH_MISSES: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        case DTLB_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        }
+    }
+#endif
+
+    void accumulate(const char* name, uint64_t elements, const Sample& start, const Sample& end)
+    {
+        // Escala de multiplexação: fração do intervalo em que o grupo esteve na PMU
+        uint64_t enabledDelta = end.timeEnabled - start.timeEnabled;
+        uint64_t runningDelta = end.timeRunning - start.timeRunning;
+        double scale = runningDelta > 0 ? (double)enabledDelta / (double)runningDelta : 0.0;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ScopeStats* stats = nullptr;
+        for (auto& scope : scopes)
+        {
+            if (scope.name == name)
+                stats = &scope;
+        }
+        if (!stats)
+        {
+            scopes.push_back(ScopeStats());
+            stats = &scopes.back();
+            stats->name = name;
+        }
+        stats->calls++;
+        stats->elements += elements;
+        for (int c = 0; c < COUNTER_COUNT; ++c)
+            stats->values[c] += (double)(end.values[c] - start.values[c]) * scale;
+    }
+};
+
+#endif
@@ -0,0 +1,243 @@
+// Cache em disco de binários de programas de shader
+//
+// Depois de linkar um programa, o binário devolvido por glGetProgramBinary é salvo em
+// shader_cache/<chave>.bin. A chave é um FNV-1a de 64 bits sobre todas as partes do
+// código fonte (inclusive #defines) e as strings GL_VENDOR/GL_RENDERER/GL_VERSION,
+// então trocar de driver ou de shader gera outra chave. Na próxima execução o binário
+// é recarregado com glProgramBinary; se o driver o rejeitar, o arquivo é apagado e o
+// programa é compilado normalmente.
+//
+// As funções de binário de programa são do GL 4.1 e a GLAD do projeto só vai até 4.0,
+// por isso são carregadas aqui. Sem suporte (ou sem formatos de binário) o cache
+// simplesmente não faz nada.
+
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+#include <cstdint>
+#include <cstring>
+
+#include <glad/glad.h>
+
+// GL 4.1 / ARB_get_program_binary
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+class ProgramCache
+{
+public:
+    struct Stats
+    {
+        int hits = 0;      // Programas carregados do disco
+        int misses = 0;    // Sem arquivo no cache: compilados
+        int rejected = 0;  // Arquivo encontrado mas recusado pelo driver
+        int stored = 0;    // Binários gravados
+    };
+
+    ProgramCache() : getProgramBinary(nullptr), programBinary(nullptr), programParameteri(nullptr), enabled(false) {}
+
+    // Carrega as funções do GL 4.1 e prepara o diretório. Retorna se o cache está ativo
+    bool init(GLADloadproc loader, const std::string& cacheDirectory = "shader_cache")
+    {
+        directory = cacheDirectory;
+        getProgramBinary = (GetProgramBinaryFn)loader("glGetProgramBinary");
+        programBinary = (ProgramBinaryFn)loader("glProgramBinary");
+        programParameteri = (ProgramParameteriFn)loader("glProgramParameteri");
+
+        GLint formats = 0;
+        if (getProgramBinary && programBinary && programParameteri)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        enabled = formats > 0;
+        if (!enabled)
+            return false;
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+
+        // O binário só vale para o mesmo driver
+        driverSignature.clear();
+        const GLenum strings[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+        for (GLenum name : strings)
+        {
+            const GLubyte* value = glGetString(name);
+            driverSignature += value ? (const char*)value : "";
+            driverSignature += '\n';
+        }
+        return true;
+    }
+
+    bool isEnabled() const { return enabled; }
+
+    uint64_t makeKey(GLsizei vertexCount, const GLchar* const* vertexParts,
+                     GLsizei fragmentCount, const GLchar* const* fragmentParts) const
+    {
+        uint64_t hash = FNV_OFFSET;
+        hash = fnv1a(hash, driverSignature.data(), driverSignature.size());
+        for (GLsizei i = 0; i < vertexCount; ++i)
+            hash = fnv1a(hash, vertexParts[i], std::strlen(vertexParts[i]));
+        // Separador: a mesma fonte não pode migrar de um estágio para o outro
+        hash = fnv1a(hash, "\x01", 1);
+        for (GLsizei i = 0; i < fragmentCount; ++i)
+            hash = fnv1a(hash, fragmentParts[i], std::strlen(fragmentParts[i]));
+        return hash;
+    }
+
+    // Deve ser chamado antes de glLinkProgram para o binário poder ser lido depois
+    void markRetrievable(GLuint program) const
+    {
+        if (enabled)
+            programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // Tenta criar o programa a partir do disco; retorna 0 se não houver binário válido
+    GLuint load(uint64_t key)
+    {
+        if (!enabled)
+            return 0;
+
+        std::ifstream file(pathFor(key), std::ios::binary);
+        if (!file)
+        {
+            stats.misses++;
+            return 0;
+        }
+
+        FileHeader header;
+        std::vector<char> binary;
+        bool valid = (bool)file.read((char*)&header, sizeof(header)) &&
+                     std::memcmp(header.magic, MAGIC, sizeof(header.magic)) == 0 &&
+                     header.key == key && header.length > 0;
+        if (valid)
+        {
+            binary.resize(header.length);
+            valid = (bool)file.read(binary.data(), header.length);
+        }
+        file.close();
+
+        GLuint program = 0;
+        if (valid)
+        {
+            program = glCreateProgram();
+            programBinary(program, header.format, binary.data(), (GLsizei)header.length);
+            GLint success = 0;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            if (!success)
+            {
+                glDeleteProgram(program);
+                program = 0;
+            }
+        }
+
+        if (program == 0)
+        {
+            // Driver atualizado ou arquivo corrompido: descarta e compila de novo
+            stats.rejected++;
+            std::error_code error;
+            std::filesystem::remove(pathFor(key), error);
+            return 0;
+        }
+
+        stats.hits++;
+        return program;
+    }
+
+    // Grava o binário de um programa recém-linkado
+    void store(uint64_t key, GLuint program)
+    {
+        if (!enabled)
+            return;
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+
+        std::vector<char> binary(length);
+        FileHeader header;
+        std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.key = key;
+        GLsizei written = 0;
+        getProgramBinary(program, length, &written, &header.format, binary.data());
+        if (written <= 0)
+            return;
+        header.length = (uint32_t)written;
+
+        // Escreve num temporário e renomeia, para nunca deixar um arquivo pela metade
+        std::string path = pathFor(key);
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file)
+                return;
+            file.write((const char*)&header, sizeof(header));
+            file.write(binary.data(), written);
+            if (!file)
+                return;
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        if (!error)
+            stats.stored++;
+    }
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    typedef void (APIENTRYP GetProgramBinaryFn)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+    typedef void (APIENTRYP ProgramBinaryFn)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+    typedef void (APIENTRYP ProgramParameteriFn)(GLuint program, GLenum pname, GLint value);
+
+    static constexpr uint64_t FNV_OFFSET = 1469598103934665603ull;
+    static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+    static constexpr char MAGIC[4] = { 'C', 'G', 'P', 'B' };
+
+    struct FileHeader
+    {
+        char magic[4];
+        GLenum format;
+        uint64_t key;
+        uint32_t length;
+        uint32_t padding = 0;
+    };
+
+    GetProgramBinaryFn getProgramBinary;
+    ProgramBinaryFn programBinary;
+    ProgramParameteriFn programParameteri;
+    bool enabled;
+    std::string directory;
+    std::string driverSignature;
+    Stats stats;
+
+    static uint64_t fnv1a(uint64_t hash, const void* data, size_t size)
+    {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    std::string pathFor(uint64_t key) const
+    {
+        std::ostringstream name;
+        name << directory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+        return name.str();
+    }
+};
+
+#endif
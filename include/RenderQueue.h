@@ -0,0 +1,179 @@
+// Fila de renderização ordenada por chaves de 64 bits
+//
+// Cada desenho visível do frame vira uma chave que agrupa os desenhos pelo estado
+// que eles exigem, do campo mais caro de trocar para o mais barato:
+//
+//   bits 63..60  camada (ex.: objetos testados por occlusion query vêm depois)
+//   bit  59      translucidez (translúcidos depois dos opacos)
+//   bits 58..49  shader
+//   bits 48..37  material / textura
+//   bits 36..24  VAO
+//   bits 23..0   profundidade (opacos: frente para trás; translúcidos: trás para frente)
+//
+// Para translúcidos a profundidade sobe para logo abaixo do bit de translucidez,
+// porque a ordem correta de blending vale mais que evitar trocas de estado.
+// As chaves são ordenadas com radix sort (LSD, dígitos de 8 bits). Os campos de
+// estado são truncados nos bits disponíveis; uma colisão só piora o agrupamento,
+// já que a execução compara os identificadores reais.
+
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+struct RenderItem
+{
+    uint64_t key;
+    uint32_t command;
+};
+
+// Estado exigido por um desenho e o objeto da cena correspondente
+struct DrawCommand
+{
+    uint32_t objectIndex;
+    GLuint program;
+    GLuint texture;
+    GLuint vao;
+};
+
+class RenderQueue
+{
+public:
+    enum Layer
+    {
+        LAYER_DEFAULT = 0,
+        LAYER_OCCLUSION_TESTED = 1
+    };
+
+    struct Stats
+    {
+        long long frames = 0;
+        long long draws = 0;
+        long long stateChangesUnsorted = 0; // Na ordem de submissão (ordem de sceneObjects)
+        long long stateChangesSorted = 0;   // Na ordem das chaves
+        int lastDraws = 0;
+        int lastStateChangesUnsorted = 0;
+        int lastStateChangesSorted = 0;
+    };
+
+    static uint64_t makeKey(unsigned layer, bool translucent, GLuint program, GLuint material, GLuint vao, float depth01)
+    {
+        depth01 = std::min(std::max(depth01, 0.0f), 1.0f);
+        uint64_t depth = (uint64_t)(depth01 * 16777215.0f);
+        uint64_t key = ((uint64_t)(layer & 0xF) << 60) | ((uint64_t)(translucent ? 1 : 0) << 59);
+
+        uint64_t state = ((uint64_t)(program & 0x3FF) << 25) | ((uint64_t)(material & 0xFFF) << 13) | (uint64_t)(vao & 0x1FFF);
+        if (translucent)
+        {
+            // Trás para frente: profundidade invertida acima do estado
+            key |= ((0xFFFFFFull - depth) << 35) | (state >> 11);
+        }
+        else
+        {
+            key |= (state << 24) | depth;
+        }
+        return key;
+    }
+
+    void clear()
+    {
+        items.clear();
+        commands.clear();
+    }
+
+    void push(uint64_t key, const DrawCommand& command)
+    {
+        items.push_back({ key, (uint32_t)commands.size() });
+        commands.push_back(command);
+    }
+
+    // Ordena as chaves e contabiliza as trocas de estado antes/depois
+    void sort()
+    {
+        int unsorted = countStateChanges();
+        radixSort();
+        int sorted = countStateChanges();
+
+        stats.frames++;
+        stats.draws += items.size();
+        stats.stateChangesUnsorted += unsorted;
+        stats.stateChangesSorted += sorted;
+        stats.lastDraws = (int)items.size();
+        stats.lastStateChangesUnsorted = unsorted;
+        stats.lastStateChangesSorted = sorted;
+    }
+
+    const std::vector<RenderItem>& getItems() const { return items; }
+    const DrawCommand& getCommand(const RenderItem& item) const { return commands[item.command]; }
+    const Stats& getStats() const { return stats; }
+
+private:
+    std::vector<RenderItem> items;
+    std::vector<RenderItem> scratch;
+    std::vector<DrawCommand> commands;
+    Stats stats;
+
+    // Trocas de programa, textura e VAO executando os itens na ordem atual
+    int countStateChanges() const
+    {
+        int changes = 0;
+        const DrawCommand* previous = nullptr;
+        for (const auto& item : items)
+        {
+            const DrawCommand& cmd = commands[item.command];
+            if (!previous || cmd.program != previous->program)
+                changes++;
+            if (!previous || cmd.texture != previous->texture)
+                changes++;
+            if (!previous || cmd.vao != previous->vao)
+                changes++;
+            previous = &cmd;
+        }
+        return changes;
+    }
+
+    // Radix sort LSD de 8 bits; dígitos iguais em todas as chaves são pulados
+    void radixSort()
+    {
+        size_t n = items.size();
+        if (n < 2)
+            return;
+
+        scratch.resize(n);
+        RenderItem* src = items.data();
+        RenderItem* dst = scratch.data();
+
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            size_t count[256];
+            std::memset(count, 0, sizeof(count));
+            for (size_t i = 0; i < n; ++i)
+                count[(src[i].key >> shift) & 0xFF]++;
+
+            if (count[(src[0].key >> shift) & 0xFF] == n)
+                continue;
+
+            size_t offset = 0;
+            for (int b = 0; b < 256; ++b)
+            {
+                size_t c = count[b];
+                count[b] = offset;
+                offset += c;
+            }
+            for (size_t i = 0; i < n; ++i)
+                dst[count[(src[i].key >> shift) & 0xFF]++] = src[i];
+
+            std::swap(src, dst);
+        }
+
+        if (src != items.data())
+            std::memcpy(items.data(), src, n * sizeof(RenderItem));
+    }
+};
+
+#endif
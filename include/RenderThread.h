@@ -0,0 +1,224 @@
+// Thread de renderização dona do contexto GL da janela
+//
+// A thread principal (eventos da GLFW, input e simulação) monta um snapshot imutável
+// do frame e o publica num TripleBuffer; esta thread pega sempre o mais recente, chama
+// render() com o contexto atual e troca os buffers (presented(), se houver, roda logo
+// depois da troca). Assim a simulação do frame N+1 roda enquanto o frame N é submetido
+// ao driver.
+//
+// A entrega dos dados não usa trava. O mutex e a condition_variable servem só para as
+// threads dormirem: a de renderização enquanto não há snapshot novo, a principal em
+// waitConsumed() (para não produzir snapshots que seriam descartados).
+//
+// pause() devolve o contexto para a thread principal (recarga de cena, estatísticas
+// dos objetos da renderização); resume() o leva de volta. Snapshots publicados antes
+// da pausa são descartados, porque podem apontar para geometrias que a pausa recriou.
+
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+
+#include <GLFW/glfw3.h>
+
+#include "TripleBuffer.h"
+#include "CpuTracer.h"
+
+template <typename Snapshot>
+class RenderThread
+{
+public:
+    struct Stats
+    {
+        uint64_t published = 0;
+        uint64_t rendered = 0;
+        uint64_t dropped = 0;       // Snapshots substituídos antes de serem desenhados
+        double renderMs = 0.0;      // Tempo total dentro de render() (inclui a troca de buffers)
+        double maxRenderMs = 0.0;
+        double waitMs = 0.0;        // Tempo da thread principal em waitConsumed()
+    };
+
+    typedef std::function<void(const Snapshot&)> RenderFunction;
+
+    RenderThread() : window(nullptr), running(false), stopping(false), pauseRequested(false), paused(false) {}
+    ~RenderThread() { stop(); }
+
+    // O contexto de window deve estar liberado (glfwMakeContextCurrent(nullptr)) na chamadora
+    void start(GLFWwindow* targetWindow, RenderFunction renderFunction, RenderFunction presentedFunction = nullptr)
+    {
+        window = targetWindow;
+        render = renderFunction;
+        presented = presentedFunction;
+        stopping = false;
+        running = true;
+        thread = std::thread(&RenderThread::loop, this);
+    }
+
+    // Termina o frame em andamento e libera o contexto (a chamadora pode torná-lo atual)
+    void stop()
+    {
+        if (!thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        thread.join();
+        running = false;
+    }
+
+    bool isRunning() const { return running; }
+
+    // Thread principal: snapshot a preencher e publicação
+    Snapshot& beginSnapshot() { return snapshots.writeBuffer(); }
+
+    void publish()
+    {
+        bool dropped = snapshots.publish();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.published++;
+            if (dropped)
+                stats.dropped++;
+        }
+        wake.notify_all();
+    }
+
+    // Thread principal: espera a renderização pegar o último snapshot publicado. O limite
+    // de tempo mantém os eventos da janela respondendo se um frame demorar muito
+    bool waitConsumed(double timeoutSeconds)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex);
+        bool done = wake.wait_for(lock, std::chrono::duration<double>(timeoutSeconds),
+                                  [this] { return !snapshots.hasNew() || stopping || paused; });
+        stats.waitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return done;
+    }
+
+    // Thread principal: para a renderização ao fim do frame atual e torna o contexto atual aqui
+    void pause()
+    {
+        if (!running)
+            return;
+        std::unique_lock<std::mutex> lock(mutex);
+        pauseRequested = true;
+        wake.notify_all();
+        wake.wait(lock, [this] { return paused; });
+        // A renderização está parada: descartar o snapshot pendente é seguro
+        if (snapshots.acquire())
+            stats.dropped++;
+        lock.unlock();
+        glfwMakeContextCurrent(window);
+    }
+
+    void resume()
+    {
+        if (!running)
+            return;
+        glfwMakeContextCurrent(nullptr);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pauseRequested = false;
+        }
+        wake.notify_all();
+    }
+
+    // Pausa durante o escopo (nullptr = nada a pausar)
+    class Pause
+    {
+    public:
+        explicit Pause(RenderThread* renderThread) : owner(renderThread)
+        {
+            if (owner)
+                owner->pause();
+        }
+        ~Pause()
+        {
+            if (owner)
+                owner->resume();
+        }
+
+    private:
+        RenderThread* owner;
+        Pause(const Pause&) = delete;
+        Pause& operator=(const Pause&) = delete;
+    };
+
+    // Cópia feita sob o mutex (a renderização atualiza os contadores)
+    Stats getStats()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+private:
+    GLFWwindow* window;
+    RenderFunction render;
+    RenderFunction presented;
+    TripleBuffer<Snapshot> snapshots;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool running;
+    bool stopping;
+    bool pauseRequested;
+    bool paused;
+    Stats stats;
+
+    void loop()
+    {
+        CG_TRACE_THREAD("renderização");
+        glfwMakeContextCurrent(window);
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            wake.wait(lock, [this] { return stopping || pauseRequested || snapshots.hasNew(); });
+            if (stopping)
+                break;
+
+            if (pauseRequested)
+            {
+                glfwMakeContextCurrent(nullptr);
+                paused = true;
+                wake.notify_all();
+                wake.wait(lock, [this] { return stopping || !pauseRequested; });
+                paused = false;
+                if (stopping)
+                    break;
+                glfwMakeContextCurrent(window);
+                continue;
+            }
+
+            snapshots.acquire(); // Sob o mutex: waitConsumed() não perde o aviso
+            lock.unlock();
+            wake.notify_all(); // A simulação já pode montar o próximo
+
+            auto start = std::chrono::steady_clock::now();
+            render(snapshots.readBuffer());
+            {
+                CG_TRACE_SCOPE("glfwSwapBuffers");
+                glfwSwapBuffers(window);
+            }
+            if (presented)
+                presented(snapshots.readBuffer());
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            lock.lock();
+            stats.rendered++;
+            stats.renderMs += ms;
+            stats.maxRenderMs = std::max(stats.maxRenderMs, ms);
+        }
+        lock.unlock();
+        glfwMakeContextCurrent(nullptr);
+    }
+};
+
+#endif
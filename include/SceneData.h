@@ -0,0 +1,557 @@
+// Dados da cena que não dependem de GL
+//
+// Configuração da cena (scene_config.txt), leitura de OBJ e MTL, trajetórias dos
+// objetos e montagem das matrizes de modelo. Fica separado do GrauBProva para que o
+// cg_bench meça estes caminhos de CPU sem janela nem contexto GL.
+
+#ifndef SCENE_DATA_H
+#define SCENE_DATA_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "CpuTracer.h"
+#include "PerfCounters.h"
+#include "AllocationTracker.h"
+
+const float defaultLightRange = 20.0f; // Alcance quando LIGHT não informa o 8º campo
+
+// Coeficientes de Phong de um material (lidos do MTL; sem MTL ficam os valores padrão)
+struct Material
+{
+    glm::vec3 ambient = glm::vec3(0.2f);
+    glm::vec3 diffuse = glm::vec3(0.7f);
+    glm::vec3 specular = glm::vec3(0.5f);
+    glm::vec3 emissive = glm::vec3(0.0f);
+    float shininess = 16.0f;
+};
+
+// Estrutura para representar um ponto de controle da trajetória
+struct ControlPoint
+{
+    glm::vec3 position;
+    float time; // Tempo para chegar neste ponto (em segundos)
+    
+    ControlPoint(glm::vec3 pos = glm::vec3(0.0f), float t = 1.0f) 
+        : position(pos), time(t) {}
+};
+
+// Classe para gerenciar trajetórias
+class Trajectory
+{
+private:
+    std::vector<ControlPoint> controlPoints;
+    float totalTime;
+    float currentTime;
+    int currentSegment;
+    bool isActive;
+    
+public:
+    Trajectory() : totalTime(0.0f), currentTime(0.0f), currentSegment(0), isActive(false) {}
+    
+    void addControlPoint(const glm::vec3& position, float time = 1.0f)
+    {
+        AllocationTracker::Scope allocationScope(AllocationTracker::TRAJECTORIES);
+        controlPoints.push_back(ControlPoint(position, time));
+        updateTotalTime();
+    }
+    
+    void clearControlPoints()
+    {
+        controlPoints.clear();
+        totalTime = 0.0f;
+        currentTime = 0.0f;
+        currentSegment = 0;
+        isActive = false;
+    }
+    
+    void start()
+    {
+        if (controlPoints.size() >= 2)
+        {
+            isActive = true;
+            currentTime = 0.0f;
+            currentSegment = 0;
+        }
+    }
+    
+    void stop()
+    {
+        isActive = false;
+    }
+    
+    void update(float deltaTime)
+    {
+        if (!isActive || controlPoints.size() < 2)
+            return;
+            
+        currentTime += deltaTime;
+        
+        // Verifica se chegou ao final do segmento atual
+        if (currentTime >= controlPoints[currentSegment].time)
+        {
+            currentTime = 0.0f;
+            currentSegment++;
+            
+            // Se chegou ao final da trajetória, volta ao início (cíclica)
+            if (currentSegment >= controlPoints.size())
+            {
+                currentSegment = 0;
+            }
+        }
+    }
+    
+    glm::vec3 getCurrentPosition()
+    {
+        if (controlPoints.size() < 2)
+            return glm::vec3(0.0f);
+            
+        if (controlPoints.size() == 1)
+            return controlPoints[0].position;
+            
+        // Interpolação linear entre pontos
+        int nextSegment = (currentSegment + 1) % controlPoints.size();
+        float t = currentTime / controlPoints[currentSegment].time;
+        
+        return glm::mix(controlPoints[currentSegment].position, 
+                       controlPoints[nextSegment].position, t);
+    }
+    
+    bool isRunning() const { return isActive; }
+    size_t getPointCount() const { return controlPoints.size(); }
+    
+    // Método para acessar um ponto de controle específico
+    const ControlPoint& getControlPoint(size_t index) const 
+    { 
+        if (index < controlPoints.size())
+            return controlPoints[index];
+        static ControlPoint defaultPoint;
+        return defaultPoint;
+    }
+    
+    // Método para obter todos os pontos de controle
+    const std::vector<ControlPoint>& getControlPoints() const { return controlPoints; }
+    
+    // Salvar trajetória em arquivo
+    bool saveToFile(const std::string& filename)
+    {
+        std::ofstream file(filename);
+        if (!file.is_open())
+            return false;
+            
+        file << controlPoints.size() << std::endl;
+        for (const auto& point : controlPoints)
+        {
+            file << point.position.x << " " << point.position.y << " " << point.position.z 
+                 << " " << point.time << std::endl;
+        }
+        file.close();
+        return true;
+    }
+    
+    // Carregar trajetória de arquivo
+    bool loadFromFile(const std::string& filename)
+    {
+        AllocationTracker::Scope allocationScope(AllocationTracker::TRAJECTORIES);
+        std::ifstream file(filename);
+        if (!file.is_open())
+            return false;
+            
+        clearControlPoints();
+        
+        int pointCount;
+        file >> pointCount;
+        
+        for (int i = 0; i < pointCount; ++i)
+        {
+            glm::vec3 pos;
+            float time;
+            file >> pos.x >> pos.y >> pos.z >> time;
+            addControlPoint(pos, time);
+        }
+        
+        file.close();
+        return true;
+    }
+    
+private:
+    void updateTotalTime()
+    {
+        totalTime = 0.0f;
+        for (const auto& point : controlPoints)
+        {
+            totalTime += point.time;
+        }
+    }
+};
+
+// Estrutura para configuração de objeto da cena
+struct ObjectConfig
+{
+    std::string name;
+    std::string objFilePath;
+    glm::vec3 position;
+    glm::vec3 rotation;
+    glm::vec3 scale;
+    std::string texturePath;
+    bool hasTrajectory;
+    std::vector<glm::vec3> trajectoryPoints;
+    std::vector<float> trajectoryTimes;
+    bool isOccluder = false; // Marcado com OCCLUDER nome na seção [OBJECTS]
+    bool quantize = false;   // Marcado com QUANTIZE nome na seção [OBJECTS]
+    bool hasBounds = false;  // Caixa em espaço de objeto dada por BOUNDS (permite carregar sob demanda)
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+};
+
+// Estrutura para configuração de luz
+struct LightConfig
+{
+    glm::vec3 position;
+    glm::vec3 color;
+    float intensity;
+    float range; // Alcance da luz (8º campo opcional de LIGHT)
+};
+
+// Estrutura para configuração de câmera
+struct CameraConfig
+{
+    glm::vec3 position;
+    glm::vec3 target;
+    float fov;
+    float nearPlane;
+    float farPlane;
+};
+
+// Estrutura para configuração completa da cena
+struct SceneConfig
+{
+    std::vector<ObjectConfig> objects;
+    std::vector<LightConfig> lights;
+    CameraConfig camera;
+};
+
+// Função para carregar configuração de cena de arquivo
+inline SceneConfig loadSceneConfig(const std::string& filename)
+{
+    CG_TRACE_FUNCTION();
+    PerfCounters::Scope perfScope("loadSceneConfig");
+    AllocationTracker::Scope allocationScope(AllocationTracker::SCENE_CONFIG);
+    SceneConfig config;
+    std::ifstream file(filename);
+    
+    if (!file.is_open()) {
+        std::cout << "Erro ao abrir arquivo de configuração: " << filename << std::endl;
+        return config;
+    }
+    
+    std::string line;
+    std::string currentSection = "";
+    
+    while (std::getline(file, line)) {
+        // Remove espaços em branco no início e fim
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t") + 1);
+        
+        // Pula linhas vazias e comentários
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        
+        // Verifica se é uma seção
+        if (line[0] == '[' && line[line.length()-1] == ']') {
+            currentSection = line.substr(1, line.length()-2);
+            continue;
+        }
+        
+        std::istringstream iss(line);
+        std::string keyword;
+        iss >> keyword;
+        
+        if (currentSection == "OBJECTS") {
+            if (keyword == "OBJECT") {
+                ObjectConfig obj;
+                iss >> obj.name >> obj.objFilePath;
+                
+                // Lê transformações
+                float px, py, pz, rx, ry, rz, sx, sy, sz;
+                iss >> px >> py >> pz >> rx >> ry >> rz >> sx >> sy >> sz;
+                obj.position = glm::vec3(px, py, pz);
+                obj.rotation = glm::vec3(rx, ry, rz);
+                obj.scale = glm::vec3(sx, sy, sz);
+                
+                // Lê textura (opcional)
+                iss >> obj.texturePath;
+                
+                // Lê trajetória (opcional)
+                iss >> obj.hasTrajectory;
+                if (obj.hasTrajectory) {
+                    int numPoints;
+                    iss >> numPoints;
+                    for (int i = 0; i < numPoints; ++i) {
+                        float x, y, z, time;
+                        iss >> x >> y >> z >> time;
+                        obj.trajectoryPoints.push_back(glm::vec3(x, y, z));
+                        obj.trajectoryTimes.push_back(time);
+                    }
+                }
+                
+                config.objects.push_back(obj);
+            }
+            else if (keyword == "QUANTIZE") {
+                // Marca um objeto já declarado para usar vértices compactados
+                std::string name;
+                iss >> name;
+                for (auto& obj : config.objects) {
+                    if (obj.name == name)
+                        obj.quantize = true;
+                }
+            }
+            else if (keyword == "BOUNDS") {
+                // Caixa envolvente de um objeto já declarado, em espaço de objeto
+                std::string name;
+                glm::vec3 boundsMin, boundsMax;
+                iss >> name >> boundsMin.x >> boundsMin.y >> boundsMin.z >> boundsMax.x >> boundsMax.y >> boundsMax.z;
+                for (auto& obj : config.objects) {
+                    if (obj.name == name && iss) {
+                        obj.hasBounds = true;
+                        obj.boundsMin = boundsMin;
+                        obj.boundsMax = boundsMax;
+                    }
+                }
+            }
+            else if (keyword == "OCCLUDER") {
+                // Marca um objeto já declarado como oclusor para o culling por CPU
+                std::string name;
+                iss >> name;
+                for (auto& obj : config.objects) {
+                    if (obj.name == name)
+                        obj.isOccluder = true;
+                }
+            }
+        }
+        else if (currentSection == "LIGHTS") {
+            if (keyword == "LIGHT") {
+                LightConfig light;
+                float px, py, pz, cx, cy, cz, intensity;
+                iss >> px >> py >> pz >> cx >> cy >> cz >> intensity;
+                light.position = glm::vec3(px, py, pz);
+                light.color = glm::vec3(cx, cy, cz);
+                light.intensity = intensity;
+                if (!(iss >> light.range))
+                    light.range = defaultLightRange;
+                config.lights.push_back(light);
+            }
+        }
+        else if (currentSection == "CAMERA") {
+            if (keyword == "POSITION") {
+                float px, py, pz;
+                iss >> px >> py >> pz;
+                config.camera.position = glm::vec3(px, py, pz);
+            }
+            else if (keyword == "TARGET") {
+                float tx, ty, tz;
+                iss >> tx >> ty >> tz;
+                config.camera.target = glm::vec3(tx, ty, tz);
+            }
+            else if (keyword == "FRUSTUM") {
+                iss >> config.camera.fov >> config.camera.nearPlane >> config.camera.farPlane;
+            }
+        }
+    }
+    
+    file.close();
+    std::cout << "Configuração de cena carregada de: " << filename << std::endl;
+    std::cout << "Objetos: " << config.objects.size() << std::endl;
+    std::cout << "Luzes: " << config.lights.size() << std::endl;
+    
+    perfScope.setElements(config.objects.size());
+    return config;
+}
+
+// Função para carregar arquivo OBJ (out_mtlLibrary recebe o nome do mtllib, se houver)
+inline bool loadObject(
+    const char* path,
+    std::vector<glm::vec3>& out_vertices,
+    std::vector<glm::vec2>& out_uvs,
+    std::vector<glm::vec3>& out_normals,
+    std::string* out_mtlLibrary = nullptr)
+{
+    CG_TRACE_FUNCTION();
+    PerfCounters::Scope perfScope("loadObject"); // Elementos: vértices lidos
+    AllocationTracker::Scope allocationScope(AllocationTracker::LOADING);
+    std::ifstream file(path);
+
+    if (!file)
+    {
+        std::cerr << "Failed to open file: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
+    std::vector<glm::vec3> temp_vertices;
+    std::vector<glm::vec2> temp_uvs;
+    std::vector<glm::vec3> temp_normals;
+
+    // Linha, tipo e stream reaproveitados: só alocam quando uma linha maior aparece
+    std::string line;
+    std::string type;
+    std::string corner;
+    std::istringstream iss;
+
+    while (std::getline(file, line))
+    {
+        iss.clear();
+        iss.str(line);
+        type.clear();
+        iss >> type;
+
+        if (type == "v") 
+        {
+            glm::vec3 vertex;
+            iss >> vertex.x >> vertex.y >> vertex.z;
+            temp_vertices.push_back(vertex);
+        }
+        else if (type == "vt") 
+        {
+            glm::vec2 uv;
+            iss >> uv.x >> uv.y;
+            temp_uvs.push_back(uv);
+        }
+        else if (type == "vn") 
+        {
+            glm::vec3 normal;
+            iss >> normal.x >> normal.y >> normal.z;
+            temp_normals.push_back(normal);
+        }
+        else if (type == "f")
+        {
+            // v/vt/vn, v//vn, v/vt ou v; índice 0 = ausente (resolvido com o valor padrão)
+            for (int i = 0; i < 3; ++i)
+            {
+                unsigned int vertexIndex = 0, uvIndex = 0, normalIndex = 0;
+                corner.clear();
+                iss >> corner;
+                if (sscanf(corner.c_str(), "%u/%u/%u", &vertexIndex, &uvIndex, &normalIndex) != 3 &&
+                    sscanf(corner.c_str(), "%u//%u", &vertexIndex, &normalIndex) != 2)
+                {
+                    sscanf(corner.c_str(), "%u/%u", &vertexIndex, &uvIndex);
+                }
+                vertexIndices.push_back(vertexIndex);
+                uvIndices.push_back(uvIndex);
+                normalIndices.push_back(normalIndex);
+            }
+        }
+        else if (type == "mtllib")
+        {
+            std::string library;
+            iss >> library;
+            if (out_mtlLibrary)
+                *out_mtlLibrary = library;
+        }
+    }
+
+    out_vertices.reserve(out_vertices.size() + vertexIndices.size());
+    out_uvs.reserve(out_uvs.size() + vertexIndices.size());
+    out_normals.reserve(out_normals.size() + vertexIndices.size());
+    for (unsigned int i = 0; i < vertexIndices.size(); ++i)
+    {
+        unsigned int vertexIndex = vertexIndices[i];
+        unsigned int uvIndex = uvIndices[i];
+        unsigned int normalIndex = normalIndices[i];
+
+        // Índices ausentes ou fora do arquivo viram os valores padrão em vez de ler fora dos vetores
+        glm::vec3 vertex = vertexIndex >= 1 && vertexIndex <= temp_vertices.size() ? temp_vertices[vertexIndex - 1] : glm::vec3(0.0f);
+        glm::vec2 uv = uvIndex >= 1 && uvIndex <= temp_uvs.size() ? temp_uvs[uvIndex - 1] : glm::vec2(0.0f);
+        glm::vec3 normal = normalIndex >= 1 && normalIndex <= temp_normals.size() ? temp_normals[normalIndex - 1] : glm::vec3(0.0f, 0.0f, 1.0f);
+
+        out_vertices.push_back(vertex);
+        out_uvs.push_back(uv);
+        out_normals.push_back(normal);
+    }
+    perfScope.setElements(vertexIndices.size());
+
+    file.close();
+
+    return true;
+}
+
+// Função para carregar arquivo MTL
+inline std::string loadMTL(const std::string& path, Material& material)
+{
+    CG_TRACE_FUNCTION();
+    AllocationTracker::Scope allocationScope(AllocationTracker::LOADING);
+    std::ifstream mtlFile(path);
+    if (!mtlFile)
+    {
+        std::cerr << "Failed to open MTL file: " << path << std::endl;
+        return "";
+    }
+
+    std::string line, texturePath;
+    while (std::getline(mtlFile, line))
+    {
+        std::istringstream iss(line);
+        std::string keyword;
+        iss >> keyword;
+
+        if (keyword == "map_Kd")
+        {
+            iss >> texturePath;
+        }
+        else if (keyword == "Ka")
+        {
+            iss >> material.ambient.r >> material.ambient.g >> material.ambient.b;
+        }
+        else if (keyword == "Kd")
+        {
+            iss >> material.diffuse.r >> material.diffuse.g >> material.diffuse.b;
+        }
+        else if (keyword == "Ks")
+        {
+            iss >> material.specular.r >> material.specular.g >> material.specular.b;
+        }
+        else if (keyword == "Ns")
+        {
+            iss >> material.shininess;
+        }
+        else if (keyword == "Ke")
+        {
+            iss >> material.emissive.r >> material.emissive.g >> material.emissive.b;
+        }
+    }
+    mtlFile.close();
+
+    if (texturePath.empty())
+    {
+        std::cerr << "No diffuse texture found in MTL file: " << path << std::endl;
+    }
+    return texturePath;
+}
+
+// Matriz de modelo: translação, escala, giro fixo em Y (yawDegrees) e rotação animada
+// de angle radianos em torno do eixo spinAxis (0 = X, 1 = Y, 2 = Z, -1 = nenhum)
+inline glm::mat4 composeModelMatrix(const glm::vec3& position, const glm::vec3& scale, float yawDegrees, int spinAxis, float angle)
+{
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, position);
+    model = glm::scale(model, scale);
+    if (yawDegrees != 0.0f)
+        model = glm::rotate(model, glm::radians(yawDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
+    if (spinAxis >= 0 && spinAxis < 3)
+    {
+        glm::vec3 axis(0.0f);
+        axis[spinAxis] = 1.0f;
+        model = glm::rotate(model, angle, axis);
+    }
+    return model;
+}
+
+#endif
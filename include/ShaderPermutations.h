@@ -0,0 +1,275 @@
+// Permutações de shader por #define
+//
+// Uma única fonte GLSL é especializada por flags de recurso, que viram #defines no
+// início de cada estágio. Cada combinação é compilada na primeira vez que algum
+// material precisa dela e fica guardada, então cada desenho executa só a matemática
+// que usa:
+//   SHADER_TEXTURED      amostra tex_buffer (sem ela a cor base é 1 ou a cor do vértice)
+//   SHADER_SPECULAR      termo especular (materiais com ks = 0 não pagam por ele)
+//   SHADER_VERTEX_COLOR  multiplica pela cor do vértice
+//   SHADER_QUANTIZED     vértices compactados (posição snorm16, normal octaédrica snorm16)
+//   SHADER_GBUFFER       passo de geometria do deferred em vez do Phong forward
+//   bits 8..15           número de luzes: 0 = sem iluminação, 1..MAX_DIRECT_LIGHTS =
+//                        laço fixo sobre as primeiras luzes, LIGHTS_CLUSTERED = clusters
+//
+// A compilação é assíncrona (AsyncProgramCompiler): enquanto a permutação de um
+// material não fica pronta, getOrFallback() devolve uma variante simples já
+// compilada no início (mesmo layout de vértice e mesmo destino, forward ou G-buffer),
+// e o frame segue sem esperar o driver.
+
+#ifndef SHADER_PERMUTATIONS_H
+#define SHADER_PERMUTATIONS_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+#include "AsyncProgramCompiler.h"
+
+enum ShaderFeature : uint32_t
+{
+    SHADER_TEXTURED = 1u << 0,
+    SHADER_SPECULAR = 1u << 1,
+    SHADER_VERTEX_COLOR = 1u << 2,
+    SHADER_QUANTIZED = 1u << 3,
+    SHADER_GBUFFER = 1u << 4
+};
+
+// Programa que desenha os objetos da cena e as localizações dos seus uniforms
+struct SceneProgram
+{
+    GLuint id = 0;
+    uint32_t features = 0;
+    GLint objectIndex = -1;
+    GLint ka = -1, kd = -1, ks = -1, q = -1;
+    GLint texBuffer = -1;
+};
+
+class ShaderPermutations
+{
+public:
+    static const uint32_t LIGHT_COUNT_SHIFT = 8;
+    static const uint32_t LIGHT_COUNT_MASK = 0xFFu << LIGHT_COUNT_SHIFT;
+    static const uint32_t MAX_DIRECT_LIGHTS = 4;
+    static const uint32_t LIGHTS_CLUSTERED = 0xFF;
+
+    struct Stats
+    {
+        int compiled = 0;
+        int pending = 0;
+        double compileMs = 0.0;  // Tempo em que a thread principal ficou presa compilando
+        int fallbackDraws = 0;   // Desenhos feitos com a variante simples
+        int stalledFrames = 0;   // Frames que teriam esperado uma compilação
+    };
+
+    static uint32_t withLightCount(uint32_t features, uint32_t lightCount)
+    {
+        uint32_t count = lightCount <= MAX_DIRECT_LIGHTS ? lightCount : LIGHTS_CLUSTERED;
+        return (features & ~LIGHT_COUNT_MASK) | (count << LIGHT_COUNT_SHIFT);
+    }
+
+    // vertexParts / forwardParts / gBufferParts: fontes sem a linha #version, que é
+    // inserida aqui antes dos #defines
+    void init(const std::vector<const GLchar*>& vertexSourceParts,
+              const std::vector<const GLchar*>& forwardSourceParts,
+              const std::vector<const GLchar*>& gBufferSourceParts,
+              AsyncProgramCompiler& programCompiler)
+    {
+        vertexParts = vertexSourceParts;
+        forwardParts = forwardSourceParts;
+        gBufferParts = gBufferSourceParts;
+        compiler = &programCompiler;
+    }
+
+    // Variante simples usada no lugar de features enquanto ela compila: só preserva
+    // o que muda o layout de vértice e o destino (G-buffer ou forward com uma luz)
+    static uint32_t fallbackFor(uint32_t features)
+    {
+        return withLightCount(features & (SHADER_QUANTIZED | SHADER_GBUFFER), 1);
+    }
+
+    // Compila de forma bloqueante as variantes simples de todas as combinações de layout
+    void prepareFallbacks()
+    {
+        const uint32_t layouts[4] = { 0u, SHADER_QUANTIZED, SHADER_GBUFFER, SHADER_QUANTIZED | SHADER_GBUFFER };
+        for (uint32_t layout : layouts)
+            get(fallbackFor(layout));
+    }
+
+    // Início de frame: recolhe as compilações que terminaram, sem esperar nenhuma
+    void beginFrame()
+    {
+        frameFellBack = false;
+        for (auto& entry : entries)
+        {
+            if (!entry.second.ready)
+                poll(entry.second);
+        }
+    }
+
+    // Saída determinística (modo headless): getOrFallback espera a compilação em vez
+    // de desenhar com a variante simples
+    void setWaitForPrograms(bool wait) { waitForPrograms = wait; }
+
+    // Programa da permutação se já estiver pronto; senão inicia a compilação (na
+    // primeira vez) e devolve a variante simples
+    const SceneProgram& getOrFallback(uint32_t features)
+    {
+        Entry& entry = request(normalize(features));
+        if (!entry.ready && waitForPrograms)
+            get(features);
+        if (entry.ready || poll(entry))
+        {
+            if (entry.program.id != 0)
+                return entry.program;
+        }
+
+        stats.fallbackDraws++;
+        if (!frameFellBack)
+        {
+            frameFellBack = true;
+            stats.stalledFrames++;
+        }
+        return get(fallbackFor(features));
+    }
+
+    // Programa da permutação, esperando a compilação se preciso
+    const SceneProgram& get(uint32_t features)
+    {
+        Entry& entry = request(normalize(features));
+        if (!entry.ready)
+        {
+            auto start = std::chrono::steady_clock::now();
+            finish(entry, compiler->wait(entry.job));
+            stats.compileMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        return entry.program;
+    }
+
+    size_t getProgramCount() const { return entries.size(); }
+    const Stats& getStats() const { return stats; }
+
+    void destroy()
+    {
+        for (auto& entry : entries)
+        {
+            // Os pendentes são terminados para não apagar um programa em uso pela thread de compilação
+            if (!entry.second.ready)
+                finish(entry.second, compiler->wait(entry.second.job));
+            glDeleteProgram(entry.second.program.id);
+        }
+        entries.clear();
+    }
+
+    static std::string describe(uint32_t features)
+    {
+        std::string text;
+        if (features & SHADER_GBUFFER) text += "GBUFFER ";
+        if (features & SHADER_TEXTURED) text += "TEXTURED ";
+        if (features & SHADER_SPECULAR) text += "SPECULAR ";
+        if (features & SHADER_VERTEX_COLOR) text += "VERTEX_COLOR ";
+        if (features & SHADER_QUANTIZED) text += "QUANTIZED ";
+        uint32_t lights = (features & LIGHT_COUNT_MASK) >> LIGHT_COUNT_SHIFT;
+        text += lights == LIGHTS_CLUSTERED ? "LIGHTS=clusters" : "LIGHTS=" + std::to_string(lights);
+        return text;
+    }
+
+private:
+    static constexpr const GLchar* VERSION_LINE = "#version 450\n";
+
+    struct Entry
+    {
+        SceneProgram program;
+        AsyncProgramCompiler::Job job = 0;
+        bool ready = false;
+    };
+
+    std::vector<const GLchar*> vertexParts, forwardParts, gBufferParts;
+    AsyncProgramCompiler* compiler = nullptr;
+    // Nós do unordered_map não mudam de endereço: ponteiros para program continuam válidos
+    std::unordered_map<uint32_t, Entry> entries;
+    Stats stats;
+    bool frameFellBack = false;
+    bool waitForPrograms = false;
+
+    // Entrada da permutação, submetendo a compilação na primeira vez
+    Entry& request(uint32_t features)
+    {
+        auto found = entries.find(features);
+        if (found != entries.end())
+            return found->second;
+
+        auto start = std::chrono::steady_clock::now();
+        std::string defines = makeDefines(features);
+
+        std::vector<const GLchar*> vertex = { VERSION_LINE, defines.c_str() };
+        vertex.insert(vertex.end(), vertexParts.begin(), vertexParts.end());
+        const std::vector<const GLchar*>& body = (features & SHADER_GBUFFER) ? gBufferParts : forwardParts;
+        std::vector<const GLchar*> fragment = { VERSION_LINE, defines.c_str() };
+        fragment.insert(fragment.end(), body.begin(), body.end());
+
+        Entry& entry = entries[features];
+        entry.program.features = features;
+        entry.job = compiler->submit((GLsizei)vertex.size(), vertex.data(), (GLsizei)fragment.size(), fragment.data());
+        stats.pending++;
+        stats.compileMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return entry;
+    }
+
+    bool poll(Entry& entry)
+    {
+        GLuint id = 0;
+        if (!compiler->poll(entry.job, id))
+            return false;
+        finish(entry, id);
+        return true;
+    }
+
+    // Compilação terminada (id = 0 se falhou: a entrada fica para sempre na variante simples)
+    void finish(Entry& entry, GLuint id)
+    {
+        SceneProgram& program = entry.program;
+        program.id = id;
+        entry.ready = true;
+        stats.pending--;
+        stats.compiled++;
+        if (id == 0)
+            return;
+        program.objectIndex = glGetUniformLocation(id, "objectIndex");
+        program.ka = glGetUniformLocation(id, "ka");
+        program.kd = glGetUniformLocation(id, "kd");
+        program.ks = glGetUniformLocation(id, "ks");
+        program.q = glGetUniformLocation(id, "q");
+        program.texBuffer = glGetUniformLocation(id, "tex_buffer");
+    }
+
+    // O G-buffer não ilumina: o número de luzes não muda o código dele
+    static uint32_t normalize(uint32_t features)
+    {
+        if (features & SHADER_GBUFFER)
+            features &= ~LIGHT_COUNT_MASK;
+        return features;
+    }
+
+    static std::string makeDefines(uint32_t features)
+    {
+        std::string defines;
+        if (features & SHADER_TEXTURED) defines += "#define TEXTURED\n";
+        if (features & SHADER_SPECULAR) defines += "#define SPECULAR\n";
+        if (features & SHADER_VERTEX_COLOR) defines += "#define VERTEX_COLOR\n";
+        if (features & SHADER_QUANTIZED) defines += "#define QUANTIZED\n";
+        uint32_t lights = (features & LIGHT_COUNT_MASK) >> LIGHT_COUNT_SHIFT;
+        // LIGHT_COUNT sempre definido para poder ser usado em #if
+        if (lights == LIGHTS_CLUSTERED)
+            defines += "#define CLUSTERED_LIGHTS\n#define LIGHT_COUNT 0\n";
+        else
+            defines += "#define LIGHT_COUNT " + std::to_string(lights) + "\n";
+        return defines;
+    }
+};
+
+#endif
@@ -0,0 +1,245 @@
+// Buffer de streaming para os dados que mudam a cada frame
+//
+// Um único buffer criado com glBufferStorage e mapeado uma vez só
+// (GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT), dividido em REGION_COUNT regiões.
+// Cada frame escreve na sua região com memcpy comum e vincula faixas dela
+// (glBindBufferRange); no fim do frame um glFenceSync marca a região, e ela só é
+// reescrita REGION_COUNT frames depois, quando o fence já passou. Assim o upload não
+// passa pelo driver nem sincroniza com a GPU, a não ser que ela esteja mais de
+// REGION_COUNT - 1 frames atrasada: esse tempo de espera é medido em getStats().
+//
+// glBufferStorage é do GL 4.4 e a GLAD do projeto só vai até 4.0, por isso é carregada
+// aqui. Sem ela (ou se o mapeamento falhar), as alocações vão para uma cópia na CPU
+// enviada com glBufferSubData em flush() a um buffer mutável (mesmas regiões e fences,
+// só sem o mapeamento persistente).
+
+#ifndef STREAMING_BUFFER_H
+#define STREAMING_BUFFER_H
+
+#include <vector>
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+#include "GLStateCache.h"
+
+// GL 4.4 / ARB_buffer_storage
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+// GL 4.3
+#ifndef GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#endif
+
+class StreamingBuffer
+{
+public:
+    static const int REGION_COUNT = 3;
+
+    struct Allocation
+    {
+        void* data;       // Onde escrever (memória mapeada ou cópia na CPU)
+        GLintptr offset;  // Posição no buffer, para glBindBufferRange
+        GLsizeiptr size;
+    };
+
+    struct Stats
+    {
+        uint64_t frames = 0;
+        uint64_t stalledFrames = 0; // Frames em que a região ainda estava em uso pela GPU
+        double stallMs = 0.0;
+        double maxStallMs = 0.0;
+        GLsizeiptr lastFrameBytes = 0;
+        int reallocations = 0;
+    };
+
+    StreamingBuffer()
+        : bufferStorage(nullptr), buffer(0), mapped(nullptr), persistent(false),
+          regionSize(0), alignment(16), region(0), used(0)
+    {
+        for (int i = 0; i < REGION_COUNT; ++i)
+            fences[i] = 0;
+    }
+
+    // Cria o buffer com regionBytes por região (cresce sozinho se um frame precisar de mais)
+    void init(GLStateCache& state, GLADloadproc loader, GLsizeiptr regionBytes)
+    {
+        bufferStorage = (BufferStorageFn)loader("glBufferStorage");
+
+        // Faixas de UBO e SSBO precisam começar em múltiplos destes alinhamentos
+        GLint uniformAlignment = 16, storageAlignment = 16;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+        alignment = (GLsizeiptr)std::max(16, std::max(uniformAlignment, storageAlignment));
+
+        allocateStorage(state, alignUp(regionBytes));
+    }
+
+    void destroy(GLStateCache& state)
+    {
+        waitAll();
+        releaseStorage(state);
+    }
+
+    bool isPersistent() const { return persistent; }
+    GLuint getBuffer() const { return buffer; }
+    const Stats& getStats() const { return stats; }
+
+    // Tamanho que uma alocação de size bytes ocupa na região
+    GLsizeiptr alignedSize(GLsizeiptr size) const { return alignUp(std::max<GLsizeiptr>(size, 16)); }
+
+    // Passa para a próxima região, esperando a GPU terminar de ler dela se preciso.
+    // bytesNeeded (soma de alignedSize das alocações do frame) faz o buffer crescer
+    // antes de qualquer alocação, nunca no meio do frame
+    void beginFrame(GLStateCache& state, GLsizeiptr bytesNeeded)
+    {
+        if (bytesNeeded > regionSize)
+        {
+            // Recriar o buffer exige que nenhuma região esteja em uso
+            waitAll();
+            releaseStorage(state);
+            allocateStorage(state, alignUp(bytesNeeded * 2));
+            state.invalidate(); // Faixas vinculadas ao buffer antigo deixaram de existir
+            stats.reallocations++;
+        }
+
+        region = (region + 1) % REGION_COUNT;
+        used = 0;
+        waitRegion(region);
+        stats.frames++;
+    }
+
+    // Reserva size bytes na região do frame (alinhados para UBO/SSBO)
+    Allocation allocate(GLsizeiptr size)
+    {
+        GLsizeiptr bytes = alignedSize(size);
+        if (used + bytes > regionSize)
+            return Allocation{ nullptr, 0, 0 }; // beginFrame recebeu um bytesNeeded menor que o usado
+
+        GLintptr offset = (GLintptr)region * regionSize + used;
+        // A cópia na CPU guarda só a região atual
+        void* data = persistent ? (char*)mapped + offset : staging.data() + used;
+        used += bytes;
+        return Allocation{ data, offset, bytes };
+    }
+
+    // Dados do frame visíveis para a GPU. Mapeamento coerente: nada a fazer
+    void flush(GLStateCache& state)
+    {
+        if (!persistent && used > 0)
+        {
+            state.bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)region * regionSize, used, staging.data());
+        }
+    }
+
+    // Depois do último comando que lê a região do frame
+    void endFrame()
+    {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        stats.lastFrameBytes = used;
+    }
+
+private:
+    typedef void (APIENTRYP BufferStorageFn)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+    BufferStorageFn bufferStorage;
+    GLuint buffer;
+    void* mapped;
+    bool persistent;
+    std::vector<char> staging;
+    GLsizeiptr regionSize;
+    GLsizeiptr alignment;
+    int region;
+    GLsizeiptr used;
+    GLsync fences[REGION_COUNT];
+    Stats stats;
+
+    GLsizeiptr alignUp(GLsizeiptr size) const { return (size + alignment - 1) / alignment * alignment; }
+
+    void allocateStorage(GLStateCache& state, GLsizeiptr bytes)
+    {
+        regionSize = bytes;
+        GLsizeiptr total = regionSize * REGION_COUNT;
+
+        glGenBuffers(1, &buffer);
+        state.bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        if (bufferStorage)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            bufferStorage(GL_COPY_WRITE_BUFFER, total, nullptr, flags);
+            mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags);
+            if (!mapped)
+            {
+                // O armazenamento imutável não aceita glBufferSubData (sem GL_DYNAMIC_STORAGE_BIT):
+                // recria o buffer mutável para o caminho com cópia
+                std::cout << "ERROR::STREAMING_BUFFER::MAP_FAILED 0x" << std::hex << glGetError() << std::dec
+                          << " (usando glBufferSubData)" << std::endl;
+                glDeleteBuffers(1, &buffer);
+                state.invalidate(); // glDeleteBuffers desfaz os binds do buffer por fora do cache
+                glGenBuffers(1, &buffer);
+                state.bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            }
+        }
+        persistent = mapped != nullptr;
+        if (!persistent)
+        {
+            glBufferData(GL_COPY_WRITE_BUFFER, total, nullptr, GL_DYNAMIC_DRAW);
+            staging.assign((size_t)regionSize, 0);
+        }
+    }
+
+    void releaseStorage(GLStateCache& state)
+    {
+        if (buffer == 0)
+            return;
+        if (mapped)
+        {
+            state.bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            mapped = nullptr;
+        }
+        glDeleteBuffers(1, &buffer);
+        state.invalidate(); // glDeleteBuffers desfaz os binds do buffer por fora do cache
+        buffer = 0;
+        staging.clear();
+    }
+
+    // Espera (e mede) a GPU liberar a região
+    void waitRegion(int index)
+    {
+        if (fences[index] == 0)
+            return;
+
+        GLenum result = glClientWaitSync(fences[index], 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            auto start = std::chrono::steady_clock::now();
+            do
+            {
+                result = glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+            } while (result == GL_TIMEOUT_EXPIRED);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            stats.stalledFrames++;
+            stats.stallMs += ms;
+            stats.maxStallMs = std::max(stats.maxStallMs, ms);
+        }
+        glDeleteSync(fences[index]);
+        fences[index] = 0;
+    }
+
+    void waitAll()
+    {
+        for (int i = 0; i < REGION_COUNT; ++i)
+            waitRegion(i);
+    }
+};
+
+#endif
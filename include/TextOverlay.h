@@ -0,0 +1,117 @@
+// Texto na tela para o overlay de estatísticas
+//
+// As letras vêm da stb_easy_font (mesmo repositório da stb_image): cada caractere vira
+// alguns retângulos coloridos, sem textura de fonte. Os retângulos do frame são
+// acumulados com addText() e desenhados de uma vez em draw(), em coordenadas de pixel
+// (origem no canto superior esquerdo), sem teste de profundidade. Só ASCII.
+//
+// O programa (posição em pixels + cor por vértice) é compilado por quem usa a classe.
+
+#ifndef TEXT_OVERLAY_H
+#define TEXT_OVERLAY_H
+
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <stb_easy_font.h>
+
+#include "GLStateCache.h"
+
+class TextOverlay
+{
+public:
+    static const int MAX_QUADS = 8192;
+
+    TextOverlay() : vao(0), vbo(0), ebo(0), program(0), screenSizeLoc(-1), quadCount(0) {}
+
+    void init(GLStateCache& state, GLuint overlayProgram)
+    {
+        program = overlayProgram;
+        screenSizeLoc = glGetUniformLocation(program, "screenSize");
+
+        // Índices fixos: dois triângulos por retângulo (a stb_easy_font gera quads)
+        std::vector<GLuint> indices((size_t)MAX_QUADS * 6);
+        for (GLuint q = 0; q < (GLuint)MAX_QUADS; ++q)
+        {
+            const GLuint corner[6] = { 0, 1, 2, 0, 2, 3 };
+            for (int i = 0; i < 6; ++i)
+                indices[q * 6 + i] = q * 4 + corner[i];
+        }
+
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)MAX_QUADS * 4 * VERTEX_SIZE, nullptr, GL_STREAM_DRAW);
+        glGenBuffers(1, &ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+        // Vértice da stb_easy_font: x, y, z em float e cor RGBA em bytes
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, VERTEX_SIZE, (GLvoid*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, VERTEX_SIZE, (GLvoid*)(3 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(1);
+
+        glBindVertexArray(0);
+        state.invalidate(); // Binds feitos por fora do cache
+    }
+
+    void destroy()
+    {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &vbo);
+        glDeleteBuffers(1, &ebo);
+        vao = vbo = ebo = 0;
+    }
+
+    // Altura de uma linha de texto em pixels (escala 1)
+    static float lineHeight() { return 12.0f; }
+
+    // Texto em const char*: montar a linha num buffer da pilha não aloca a cada frame
+    void addText(float x, float y, const char* text, unsigned char r = 255, unsigned char g = 255, unsigned char b = 255)
+    {
+        unsigned char color[4] = { r, g, b, 255 };
+        int freeQuads = MAX_QUADS - quadCount;
+        if (freeQuads <= 0)
+            return;
+        vertices.resize((size_t)MAX_QUADS * 4 * VERTEX_SIZE);
+        quadCount += stb_easy_font_print(x, y, const_cast<char*>(text), color,
+                                         vertices.data() + (size_t)quadCount * 4 * VERTEX_SIZE,
+                                         freeQuads * 4 * VERTEX_SIZE);
+    }
+
+    // Desenha o texto acumulado por cima do framebuffer atual e esvazia o acumulado
+    void draw(GLStateCache& state, int width, int height)
+    {
+        if (quadCount == 0)
+            return;
+
+        state.bindBuffer(GL_ARRAY_BUFFER, vbo);
+        // Orfana o armazenamento anterior: o driver não espera o frame que ainda o lê
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)MAX_QUADS * 4 * VERTEX_SIZE, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)quadCount * 4 * VERTEX_SIZE, vertices.data());
+
+        state.disable(GL_DEPTH_TEST);
+        state.enable(GL_BLEND);
+        state.useProgram(program);
+        glUniform2f(screenSizeLoc, (GLfloat)width, (GLfloat)height);
+        state.bindVertexArray(vao);
+        glDrawElements(GL_TRIANGLES, quadCount * 6, GL_UNSIGNED_INT, 0);
+        state.enable(GL_DEPTH_TEST);
+
+        quadCount = 0;
+    }
+
+private:
+    static const int VERTEX_SIZE = 16;
+
+    GLuint vao, vbo, ebo;
+    GLuint program;
+    GLint screenSizeLoc;
+    int quadCount;
+    std::vector<char> vertices;
+};
+
+#endif
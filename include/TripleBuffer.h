@@ -0,0 +1,59 @@
+// Troca de dados sem trava entre uma thread produtora e uma consumidora
+//
+// Três cópias de T: a de escrita (só da produtora), a de leitura (só da consumidora)
+// e a do meio, trocada por exchange atômico. publish() entrega a cópia escrita e
+// recebe a do meio para o próximo frame; acquire() pega a do meio se ela for mais nova
+// que a lida. Nenhum lado espera o outro: se a produtora publica duas vezes antes de a
+// consumidora ler, a mais antiga é descartada (a consumidora sempre vê a mais recente).
+// As cópias são reutilizadas, então vetores dentro de T mantêm a capacidade entre frames.
+
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : writeIndex(0), readIndex(1), middle(2) {}
+
+    // Produtora: cópia a preencher antes de publish()
+    T& writeBuffer() { return buffers[writeIndex]; }
+
+    // Produtora: entrega a cópia escrita. Devolve true se a anterior não chegou a ser
+    // lida (foi descartada)
+    bool publish()
+    {
+        uint8_t previous = middle.exchange(writeIndex | NEW_BIT, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+        return (previous & NEW_BIT) != 0;
+    }
+
+    // Consumidora: há cópia publicada ainda não lida?
+    bool hasNew() const { return (middle.load(std::memory_order_acquire) & NEW_BIT) != 0; }
+
+    // Consumidora: passa a ler a cópia mais recente, se houver uma nova
+    bool acquire()
+    {
+        if (!hasNew())
+            return false;
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    // Consumidora: cópia atual (a última obtida com acquire)
+    const T& readBuffer() const { return buffers[readIndex]; }
+
+private:
+    static const uint8_t INDEX_MASK = 0x3;
+    static const uint8_t NEW_BIT = 0x4;
+
+    T buffers[3];
+    uint8_t writeIndex;          // Só a produtora
+    uint8_t readIndex;           // Só a consumidora
+    std::atomic<uint8_t> middle; // Índice da cópia do meio + NEW_BIT
+};
+
+#endif
@@ -7,6 +7,9 @@
 #include <sstream>
 #include <map>
 #include <cmath>
+#include <cstddef>
+#include <thread>
+#include <optional>
 
 using namespace std;
 
@@ -28,12 +31,132 @@ using namespace std;
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+// Alocações do heap por subsistema (operator new substituído só com CG_TRACK_ALLOCATIONS)
+#define CG_ALLOCATION_TRACKER_IMPLEMENTATION
+#include "AllocationTracker.h"
+
+// Culling de oclusão por software e por occlusion queries
+#include "OcclusionCulling.h"
+#include "OcclusionQueries.h"
+
+// Fila de renderização ordenada por estado
+#include "RenderQueue.h"
+
+// Cache do estado OpenGL
+#include "GLStateCache.h"
+
+// Iluminação clusterizada (todas as luzes da cena)
+#include "ClusteredLighting.h"
+
+// Caminho deferred (G-buffer + passo de iluminação)
+#include "DeferredRenderer.h"
+
+// Buffer persistente mapeado para os dados de cada frame
+#include "StreamingBuffer.h"
+
+// Contexto EGL sem janela e FBO de saída do modo --headless
+#include "HeadlessContext.h"
+
+// Passo fixo da simulação, limitador de FPS e percentis de tempo de frame
+#include "FrameTiming.h"
+
+// Thread de renderização alimentada por snapshots do frame
+#include "RenderThread.h"
+
+// Latência do input até a imagem (fence + timestamp depois da troca) e limite de fila da GPU
+#include "InputLatency.h"
+
+// Tempos de GPU por escopo e overlay de texto
+#include "GpuProfiler.h"
+#include "TextOverlay.h"
+
+// Contadores de chamadas GL por frame (ponteiros da GLAD instrumentados)
+#include "GLCallStats.h"
+
+// Zonas de CPU (só com CG_ENABLE_TRACING) e exportação para chrome://tracing
+#include "CpuTracer.h"
+
+// Contadores de hardware (perf_event_open) por escopo: IPC e misses por elemento
+#include "PerfCounters.h"
+
+// Métricas ao vivo num socket Unix (--metrics-socket), lidas pelo cg_metrics
+#include "MetricsServer.h"
+
+// Configuração da cena, OBJ/MTL, trajetórias e matrizes de modelo (sem GL; também usado pelo cg_bench)
+#include "SceneData.h"
+
+// Cache em disco dos binários de programas de shader
+#include "ProgramCache.h"
+
+// Compilação de shaders sem bloquear o frame
+#include "AsyncProgramCompiler.h"
+
+// Programas especializados por #define (permutações por material)
+#include "ShaderPermutations.h"
+
+// Opções de linha de comando (--headless e afins)
+struct AppOptions
+{
+    bool headless = false;
+    int frames = 120;                // Frames renderizados no headless (medidos no benchmark)
+    int width = 1000, height = 1000; // Tamanho da janela ou do FBO headless
+    string outputDir = "frames";
+    int saveEvery = 1;               // Um PNG a cada N frames (0 = nenhum)
+    float frameTime = 1.0f / 60.0f;  // Tempo entre frames do headless: saída independente da máquina
+    double simulationHz = 60.0;      // Passos de simulação por segundo
+    double fpsLimit = 0.0;           // Limite de FPS da janela (0 = sem limite)
+    bool deferred = false;
+    bool singleThread = false;       // Simulação e desenho na mesma thread (para comparação)
+    bool gpuOverlay = false;         // Overlay do profiler de GPU ligado desde o início
+    string gpuCsvPath;               // Tempos de GPU por escopo em CSV (vazio = não grava)
+    bool glStats = false;            // Conta as chamadas GL por frame
+    string glCallLogPath;            // Log das chamadas GL por frame (implica glStats)
+    string traceStartupPath;         // Trace de CPU da inicialização (vazio = não grava)
+    long long traceFirstFrame = -1;  // Intervalo de frames do trace de CPU (-1 = nenhum)
+    long long traceLastFrame = -1;
+    string traceOutputPath = "trace_frames.json";
+    bool perfCounters = false;       // Contadores de hardware nos escopos medidos (só Linux)
+    bool allocStrict = false;        // Aborta em alocações no loop do frame depois do aquecimento
+    bool lazyLoading = false;        // Objetos com BOUNDS fora do frustum inicial só carregam ao aparecer
+    string metricsSocketPath;        // Socket Unix das métricas ao vivo (vazio = sem servidor)
+    double metricsHz = 10.0;         // Linhas de métricas por segundo
+    bool inputLatency = false;       // Mede a latência do input até o fim do frame na GPU
+    bool lateLatch = false;          // Orientação do mouse lida de novo no início do desenho
+    int maxQueuedFrames = 0;         // Frames em voo na GPU antes de a CPU esperar (0 = sem limite)
+    string scenePath = "scene_config.txt";
+    string benchmarkCameraPath;      // Trajetória da câmera do benchmark (vazio = sem benchmark)
+    int warmupFrames = 60;           // Frames do benchmark descartados antes da medição
+    string benchmarkOutputPath = "benchmark.json";
+    size_t simulateCount = 0;        // Objetos do modo --simulate (0 = sem simulação)
+    int simulateTicks = 1000;        // Passos de simulação do --simulate
+    int simulateThreads = 0;         // Threads do --simulate (0 = uma por núcleo)
+    string simulateDumpPath;         // Posições amostradas em binário (vazio = não grava)
+    int simulateDumpEvery = 10;      // Ticks entre duas amostras gravadas
+};
+
+// Etapas da aplicação, compartilhadas pela janela e pelo modo headless
+AppOptions parseArguments(int argc, char** argv);
+void initScene(int width, int height, GLFWwindow* compileContext);
+void updateScene(float step, GLFWwindow* window);
+struct FrameSnapshot;
+void buildSnapshot(FrameSnapshot& snapshot, float time, float alpha, float frameDelta);
+void renderFrame(const FrameSnapshot& snapshot, int width, int height, GLuint targetFramebuffer);
+void shutdownScene();
+int runHeadless(const AppOptions& options);
+int runBenchmark(const AppOptions& options);
+int runSimulation(const AppOptions& options);
 
 // Protótipo da função de callback de teclado
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 
 // Protótipos das funções
 int setupShader();
+GLuint setupDeferredLightingShader();
+GLuint setupOverlayShader();
+GLuint compileProgram(GLsizei vertexCount, const GLchar** vertexParts, GLsizei fragmentCount, const GLchar** fragmentParts);
 int setupGeometry();
 
 // Protótipos para controle de câmera
@@ -48,163 +171,12 @@ struct Geometry
 	GLuint vertexCount;
 	GLuint textureID = 0;
 	string textureFilePath;
-};
-
-// Estrutura para representar um ponto de controle da trajetória
-struct ControlPoint
-{
-	glm::vec3 position;
-	float time; // Tempo para chegar neste ponto (em segundos)
-	
-	ControlPoint(glm::vec3 pos = glm::vec3(0.0f), float t = 1.0f) 
-		: position(pos), time(t) {}
-};
-
-// Classe para gerenciar trajetórias
-class Trajectory
-{
-private:
-	vector<ControlPoint> controlPoints;
-	float totalTime;
-	float currentTime;
-	int currentSegment;
-	bool isActive;
-	
-public:
-	Trajectory() : totalTime(0.0f), currentTime(0.0f), currentSegment(0), isActive(false) {}
-	
-	void addControlPoint(const glm::vec3& position, float time = 1.0f)
-	{
-		controlPoints.push_back(ControlPoint(position, time));
-		updateTotalTime();
-	}
-	
-	void clearControlPoints()
-	{
-		controlPoints.clear();
-		totalTime = 0.0f;
-		currentTime = 0.0f;
-		currentSegment = 0;
-		isActive = false;
-	}
-	
-	void start()
-	{
-		if (controlPoints.size() >= 2)
-		{
-			isActive = true;
-			currentTime = 0.0f;
-			currentSegment = 0;
-		}
-	}
-	
-	void stop()
-	{
-		isActive = false;
-	}
-	
-	void update(float deltaTime)
-	{
-		if (!isActive || controlPoints.size() < 2)
-			return;
-			
-		currentTime += deltaTime;
-		
-		// Verifica se chegou ao final do segmento atual
-		if (currentTime >= controlPoints[currentSegment].time)
-		{
-			currentTime = 0.0f;
-			currentSegment++;
-			
-			// Se chegou ao final da trajetória, volta ao início (cíclica)
-			if (currentSegment >= controlPoints.size())
-			{
-				currentSegment = 0;
-			}
-		}
-	}
-	
-	glm::vec3 getCurrentPosition()
-	{
-		if (controlPoints.size() < 2)
-			return glm::vec3(0.0f);
-			
-		if (controlPoints.size() == 1)
-			return controlPoints[0].position;
-			
-		// Interpolação linear entre pontos
-		int nextSegment = (currentSegment + 1) % controlPoints.size();
-		float t = currentTime / controlPoints[currentSegment].time;
-		
-		return glm::mix(controlPoints[currentSegment].position, 
-					   controlPoints[nextSegment].position, t);
-	}
-	
-	bool isRunning() const { return isActive; }
-	size_t getPointCount() const { return controlPoints.size(); }
-	
-	// Método para acessar um ponto de controle específico
-	const ControlPoint& getControlPoint(size_t index) const 
-	{ 
-		if (index < controlPoints.size())
-			return controlPoints[index];
-		static ControlPoint defaultPoint;
-		return defaultPoint;
-	}
-	
-	// Método para obter todos os pontos de controle
-	const vector<ControlPoint>& getControlPoints() const { return controlPoints; }
-	
-	// Salvar trajetória em arquivo
-	bool saveToFile(const string& filename)
-	{
-		ofstream file(filename);
-		if (!file.is_open())
-			return false;
-			
-		file << controlPoints.size() << endl;
-		for (const auto& point : controlPoints)
-		{
-			file << point.position.x << " " << point.position.y << " " << point.position.z 
-				 << " " << point.time << endl;
-		}
-		file.close();
-		return true;
-	}
-	
-	// Carregar trajetória de arquivo
-	bool loadFromFile(const string& filename)
-	{
-		ifstream file(filename);
-		if (!file.is_open())
-			return false;
-			
-		clearControlPoints();
-		
-		int pointCount;
-		file >> pointCount;
-		
-		for (int i = 0; i < pointCount; ++i)
-		{
-			glm::vec3 pos;
-			float time;
-			file >> pos.x >> pos.y >> pos.z >> time;
-			addControlPoint(pos, time);
-		}
-		
-		file.close();
-		return true;
-	}
-	
-private:
-	void updateTotalTime()
-	{
-		totalTime = 0.0f;
-		for (const auto& point : controlPoints)
-		{
-			totalTime += point.time;
-		}
-	}
+	Material material;
+	bool quantized = false;                // Vértices compactados (permutação SHADER_QUANTIZED)
+	glm::mat4 dequantize = glm::mat4(1.0f); // Leva as posições snorm16 de volta ao espaço de objeto
+	glm::vec3 boundsMin = glm::vec3(0.0f); // Caixa envolvente em espaço de objeto
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+	vector<glm::vec3> occluderTriangles;   // Posições mantidas na CPU apenas para oclusores
 };
 
 // Estrutura da câmera em primeira pessoa
@@ -240,7 +212,7 @@ struct FirstPersonCamera
 		up = glm::normalize(glm::cross(right, front));
 	}
 	
-	glm::mat4 getViewMatrix()
+	glm::mat4 getViewMatrix() const
 	{
 		return glm::lookAt(position, position + front, up);
 	}
@@ -289,73 +261,136 @@ struct SceneObject
 	Geometry geometry;
 	Trajectory trajectory;
 	glm::vec3 position;
+	glm::vec3 previousPosition; // Posição no passo de simulação anterior (interpolação)
 	glm::vec3 rotation;
 	glm::vec3 scale;
 	string name;
+	bool isOccluder;
+	bool loaded;     // Geometria carregada (false = adiada pelo --lazy, só com a caixa do BOUNDS)
+	int configIndex; // Entrada em sceneConfig.objects (para carregar depois)
 	
 	SceneObject(const string& objName = "Object") 
-		: position(0.0f), rotation(0.0f), scale(1.0f), name(objName) {}
+		: position(0.0f), previousPosition(0.0f), rotation(0.0f), scale(1.0f), name(objName), isOccluder(false),
+		  loaded(false), configIndex(-1) {}
 };
 
-// Estrutura para configuração de objeto da cena
-struct ObjectConfig
+// Dados por frame compartilhados por todos os programas (bloco std140, binding 0)
+struct FrameUniforms
 {
-    string name;
-    string objFilePath;
-    glm::vec3 position;
-    glm::vec3 rotation;
-    glm::vec3 scale;
-    string texturePath;
-    bool hasTrajectory;
-    vector<glm::vec3> trajectoryPoints;
-    vector<float> trajectoryTimes;
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 cameraPos;
+    glm::vec4 ambientLight;  // rgb = luz ambiente (cor da primeira luz)
+    glm::vec4 screenSize;    // largura, altura, 1/largura, 1/altura
+    glm::vec4 clusterParams; // escala e bias da fatia: log(profundidade) * x + y
+    glm::uvec4 clusterGrid;  // dimensões da grade de clusters e número de luzes
 };
 
-// Estrutura para configuração de luz
-struct LightConfig
+// Dados por desenho lidos do SSBO (std430, binding 1), indexados por objectIndex.
+// A matriz normal é calculada uma vez por objeto na CPU (mat3 guardada como mat4)
+struct ObjectUniforms
 {
-    glm::vec3 position;
-    glm::vec3 color;
-    float intensity;
+    glm::mat4 model;
+    glm::mat4 normalMatrix;
 };
 
-// Estrutura para configuração de câmera
-struct CameraConfig
+const GLuint FRAME_UBO_BINDING = 0;
+const GLuint OBJECT_SSBO_BINDING = 1;
+
+// Objeto da cena como a renderização o vê: geometria (só lida) e matriz de modelo já
+// interpolada
+struct SnapshotObject
 {
-    glm::vec3 position;
-    glm::vec3 target;
-    float fov;
-    float nearPlane;
-    float farPlane;
+    const Geometry* geometry;
+    glm::mat4 model;
+    bool isOccluder;
 };
 
-// Estrutura para configuração completa da cena
-struct SceneConfig
+// Tudo o que um frame precisa da simulação, montado pela thread principal em
+// buildSnapshot(). A thread de renderização só lê isto (e os recursos GL que são dela),
+// nunca sceneObjects, camera ou sceneConfig
+struct FrameSnapshot
 {
-    vector<ObjectConfig> objects;
-    vector<LightConfig> lights;
-    CameraConfig camera;
+    uint64_t sequence = 0;
+    vector<SnapshotObject> objects;
+    FirstPersonCamera camera;           // Posição interpolada
+    vector<GPULight> lights;
+    vector<glm::vec3> controlPoints;    // Pontos de trajetória visíveis (vazio se escondidos)
+    bool deferred = false;
+    bool occlusionCulling = false;
+    bool occlusionQueries = false;
+    bool gpuOverlay = false;
+    float frameDelta = 0.0f;
+    int64_t inputTime = 0;              // Evento de mouse mais antigo que o frame mostra (0 = nenhum)
 };
 
 // Funções para carregamento de objeto OBJ
-Geometry setupGeometryFromFile(const char* filepath);
-bool loadObject(
-    const char* path,
-    std::vector<glm::vec3>& out_vertices,
-    std::vector<glm::vec2>& out_uvs,
-    std::vector<glm::vec3>& out_normals);
+Geometry setupGeometryFromFile(const char* filepath, bool keepPositions = false, bool quantize = false);
+Geometry setupFullGeometry(const vector<glm::vec3>& vert, const vector<glm::vec2>& uvs, const vector<glm::vec3>& normals);
+Geometry setupQuantizedGeometry(const vector<glm::vec3>& vert, const vector<glm::vec2>& uvs, const vector<glm::vec3>& normals,
+                                const glm::vec3& boundsMin, const glm::vec3& boundsMax);
 int loadTexture(const string& path);
-string loadMTL(const string& path);
 
 // Função para renderizar pontos de controle da trajetória
-void renderTrajectoryPoints(const Trajectory& trajectory, GLuint shaderID, 
-                           const glm::mat4& view, const glm::mat4& projection);
+void renderTrajectoryPoints(const vector<glm::vec3>& points, const SceneProgram& program, GLint firstObjectIndex);
+
+// Funções para os dados por frame (UBO) e por objeto (SSBO), escritos no buffer de streaming
+void createFrameBuffers();
+void uploadFrameBuffers(const FrameUniforms& frame, const vector<ObjectUniforms>& objects);
+ObjectUniforms makeObjectUniforms(const glm::mat4& model);
+ObjectUniforms makeObjectUniforms(const glm::mat4& model, const Geometry& geometry);
+
+// Funções para escolher a permutação de shader de um material e enviar seus coeficientes
+uint32_t materialShaderFeatures(const Geometry& geometry);
+void applyMaterialUniforms(const SceneProgram& program, const Material& material);
 
 // Função para criar geometria de pontos de controle
 GLuint createControlPointGeometry();
 
+// Funções para criação de objetos da cena e da matriz de modelo
+SceneObject createSceneObject(const ObjectConfig& objConfig);
+void loadSceneObjectGeometry(SceneObject& obj, const ObjectConfig& objConfig);
+void createSceneObjects(const SceneConfig& config);
+void loadVisibleObjects(float time, float alpha);
+bool isPotentiallyVisible(const glm::mat4& viewProjection, const glm::mat4& model, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+glm::mat4 buildModelMatrix(const SceneObject& obj, float angle, float alpha = 1.0f);
+
+// Função para mostrar as estatísticas das occlusion queries
+void printOcclusionQueryStats();
+
+// Função para mostrar os percentis de tempo de frame
+void printFrameTimeStats();
+
+// Função para gravar as posições amostradas do --simulate em binário
+bool writeSimulationSamples(const string& path, const vector<glm::vec3>& samples, size_t sampleCount, size_t sampleStride,
+                            int dumpEvery, float step, size_t objectCount);
+
+// Função para gravar o resultado do --benchmark em JSON
+bool writeBenchmarkJson(const AppOptions& options, const string& renderer, int width, int height,
+                        const FrameTimeStats::Percentiles& frame, const FrameTimeStats::Percentiles& cpu,
+                        const FrameTimeStats::Percentiles& gpu);
+
+// Função para mostrar a sobreposição entre simulação e renderização
+void printRenderThreadStats();
+
+// Capturas do tracer de CPU: por intervalo de frames e da inicialização
+void updateTraceCapture(long long frame);
+void updateAllocationStrict(long long frame);
+void registerMetrics();
+void publishRenderMetrics(const FrameSnapshot& snapshot);
+void finishTraceCapture(const string& path);
+
+// Funções do profiler de GPU: texto do overlay e estatísticas no console
+void drawGpuOverlay(int width, int height, float frameDelta);
+void printGpuProfilerStats();
+
+// Funções dos contadores de chamadas GL: instalação (logo após a GLAD) e estatísticas
+void installGLCallStats(const AppOptions& options);
+void printGLCallStats();
+
 // Função para criar geometria de 3 quadrados conectados (canto de parede)
-Geometry createThreeWallCornerGeometry(const std::string& texturePath) {
+Geometry createThreeWallCornerGeometry(const std::string& texturePath, bool keepPositions = false) {
     float size = 1.0f;
     std::vector<GLfloat> vertices = {
         // Face 1: XY (Z=0)
@@ -412,6 +447,13 @@ Geometry createThreeWallCornerGeometry(const std::string& texturePath) {
     geom.vertexCount = 6 * 3; // 3 faces, 2 triangles each
     geom.textureID = loadTexture("assets/tex/pixelWall.png");
     geom.textureFilePath = "assets/tex/pixelWall.png";
+    geom.boundsMin = glm::vec3(0.0f);
+    geom.boundsMax = glm::vec3(size);
+    if (keepPositions) {
+        for (size_t i = 0; i < vertices.size(); i += 11) {
+            geom.occluderTriangles.push_back(glm::vec3(vertices[i], vertices[i + 1], vertices[i + 2]));
+        }
+    }
     return geom;
 }
 
@@ -419,15 +461,35 @@ Geometry createThreeWallCornerGeometry(const std::string& texturePath) {
 const GLuint WIDTH = 1000, HEIGHT = 1000;
 
 // Código fonte do Vertex Shader (em GLSL): ainda hardcoded
-const GLchar* vertexShaderSource = "#version 450\n"
+// A linha #version e os #defines da permutação são inseridos por ShaderPermutations
+const GLchar* vertexShaderSource =
 "layout (location = 0) in vec3 position;\n"
 "layout (location = 1) in vec3 color;\n"
 "layout (location = 2) in vec2 tex_coord;\n"
+"#ifdef QUANTIZED\n"
+"layout (location = 3) in vec2 normal; // Octaédrica\n"
+"#else\n"
 "layout (location = 3) in vec3 normal;\n"
+"#endif\n"
 "\n"
-"uniform mat4 model;\n"
-"uniform mat4 view;\n"
-"uniform mat4 projection;\n"
+"layout (std140, binding = 0) uniform FrameData {\n"
+"    mat4 view;\n"
+"    mat4 projection;\n"
+"    mat4 viewProjection;\n"
+"    vec4 cameraPos;\n"
+"    vec4 ambientLight;\n"
+"    vec4 screenSize;\n"
+"    vec4 clusterParams;\n"
+"    uvec4 clusterGrid;\n"
+"};\n"
+"struct ObjectData {\n"
+"    mat4 model;\n"
+"    mat4 normalMatrix;\n"
+"};\n"
+"layout (std430, binding = 1) readonly buffer ObjectBuffer {\n"
+"    ObjectData objects[];\n"
+"};\n"
+"uniform int objectIndex;\n"
 "\n"
 "out vec4 finalColor;\n"
 "out vec2 texCoord;\n"
@@ -436,61 +498,195 @@ const GLchar* vertexShaderSource = "#version 450\n"
 "\n"
 "void main()\n"
 "{\n"
-"    vec4 worldPos = model * vec4(position, 1.0);\n"
-"    gl_Position = projection * view * worldPos;\n"
+"    // Nos vértices quantizados a matriz de modelo já inclui a descompactação da posição\n"
+"    vec4 worldPos = objects[objectIndex].model * vec4(position, 1.0);\n"
+"    gl_Position = viewProjection * worldPos;\n"
 "    finalColor = vec4(color, 1.0);\n"
 "    texCoord = vec2(tex_coord.x, 1 - tex_coord.y);\n"
 "    fragPos = vec3(worldPos);\n"
-"    fragNormal = mat3(transpose(inverse(model))) * normal;\n"
+"#ifdef QUANTIZED\n"
+"    vec3 objectNormal = decodeOctahedral(normal);\n"
+"#else\n"
+"    vec3 objectNormal = normal;\n"
+"#endif\n"
+"    fragNormal = mat3(objects[objectIndex].normalMatrix) * objectNormal;\n"
 "}\0";
 
+// Codificação octaédrica de normais (vértices quantizados e G-buffer)
+const GLchar* octahedralSource =
+"vec2 signNotZero(vec2 v) { return vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0); }\n"
+"// Normal unitária -> octaedro projetado em [-1,1]^2\n"
+"vec2 encodeOctahedral(vec3 n)\n"
+"{\n"
+"    vec2 p = n.xy / (abs(n.x) + abs(n.y) + abs(n.z));\n"
+"    return n.z >= 0.0 ? p : (1.0 - abs(p.yx)) * signNotZero(p);\n"
+"}\n"
+"vec3 decodeOctahedral(vec2 e)\n"
+"{\n"
+"    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n"
+"    if (v.z < 0.0)\n"
+"        v.xy = (1.0 - abs(v.yx)) * signNotZero(v.xy);\n"
+"    return normalize(v);\n"
+"}\n";
+
 //Códifo fonte do Fragment Shader (em GLSL): ainda hardcoded
-const GLchar* fragmentShaderSource = "#version 450\n"
+// Compilado em partes: cabeçalho, bloco FrameData, declarações de LightClusterer e o corpo
+const GLchar* fragmentShaderHeader =
 "in vec4 finalColor;\n"
 "in vec2 texCoord;\n"
 "in vec3 fragPos;\n"
 "in vec3 fragNormal;\n"
-"out vec4 color;\n"
 "uniform sampler2D tex_buffer;\n"
 "uniform vec3 ka;\n"
 "uniform vec3 kd;\n"
 "uniform vec3 ks;\n"
 "uniform float q;\n"
-"uniform vec3 lightPos;\n"
-"uniform vec3 lightColor;\n"
-"uniform vec3 cameraPos;\n"
+"vec3 baseColor()\n"
+"{\n"
+"#ifdef TEXTURED\n"
+"    vec3 base = texture(tex_buffer, texCoord).rgb;\n"
+"#else\n"
+"    vec3 base = vec3(1.0);\n"
+"#endif\n"
+"#ifdef VERTEX_COLOR\n"
+"    base *= finalColor.rgb;\n"
+"#endif\n"
+"    return base;\n"
+"}\n";
+
+// Bloco de dados por frame, igual em todos os programas que iluminam
+const GLchar* frameDataBlockSource =
+"layout (std140, binding = 0) uniform FrameData {\n"
+"    mat4 view;\n"
+"    mat4 projection;\n"
+"    mat4 viewProjection;\n"
+"    vec4 cameraPos;\n"
+"    vec4 ambientLight;\n"
+"    vec4 screenSize;\n"
+"    vec4 clusterParams;\n"
+"    uvec4 clusterGrid;\n"
+"};\n";
+
+// Caminho forward: Phong completo em cada fragmento desenhado
+const GLchar* fragmentShaderSource =
+"out vec4 color;\n"
 "void main()\n"
 "{\n"
-"    vec3 ambient = lightColor * ka;\n"
+"    vec3 base = baseColor();\n"
+"#if defined(CLUSTERED_LIGHTS) || LIGHT_COUNT > 0\n"
 "    vec3 N = normalize(fragNormal);\n"
-"    vec3 L = normalize(lightPos - fragPos);\n"
-"    float diff = max(dot(N, L), 0.0);\n"
-"    vec3 diffuse = diff * lightColor * kd;\n"
-"    vec3 R = reflect(-L, N);\n"
-"    vec3 V = normalize(cameraPos - fragPos);\n"
-"    float spec = pow(max(dot(R, V), 0.0), q);\n"
-"    vec3 specular = spec * ks * lightColor;\n"
-"    vec3 texColor = texture(tex_buffer, texCoord).rgb;\n"
-"    vec3 result = (ambient + diffuse) * texColor + specular;\n"
+"    vec3 V = normalize(cameraPos.xyz - fragPos);\n"
+"    vec3 diffuseLight = vec3(0.0);\n"
+"    vec3 specularLight = vec3(0.0);\n"
+"#ifdef CLUSTERED_LIGHTS\n"
+"    // Só as luzes do cluster deste fragmento\n"
+"    float viewDepth = -(view * vec4(fragPos, 1.0)).z;\n"
+"    accumulateClusterLights(fragPos, N, V, gl_FragCoord.xy, viewDepth, q, diffuseLight, specularLight);\n"
+"#else\n"
+"    // Poucas luzes: laço de tamanho fixo, sem busca de cluster\n"
+"    for (int i = 0; i < LIGHT_COUNT; ++i)\n"
+"        accumulateLight(lights[i], fragPos, N, V, q, diffuseLight, specularLight);\n"
+"#endif\n"
+"    vec3 result = (ambientLight.rgb * ka + diffuseLight * kd) * base;\n"
+"#ifdef SPECULAR\n"
+"    result += specularLight * ks;\n"
+"#endif\n"
 "    color = vec4(result, 1.0f);\n"
+"#else\n"
+"    color = vec4(base, 1.0f); // Sem iluminação\n"
+"#endif\n"
 "}\n\0";
 
-bool rotateX=false, rotateY=false, rotateZ=false;
+// Caminho deferred, passo de geometria: só grava os dados de superfície no G-buffer
+const GLchar* gBufferFragmentSource =
+"layout (location = 0) out vec4 gAlbedo;\n"
+"layout (location = 1) out vec2 gNormal;\n"
+"layout (location = 2) out vec4 gMaterial;\n"
+"layout (location = 3) out vec4 gAmbient;\n"
+"void main()\n"
+"{\n"
+"    vec3 base = baseColor();\n"
+"    gAlbedo = vec4(base * kd, 1.0);\n"
+"    gNormal = encodeOctahedral(normalize(fragNormal));\n"
+"#ifdef SPECULAR\n"
+"    gMaterial = vec4(ks, q);\n"
+"#else\n"
+"    gMaterial = vec4(0.0, 0.0, 0.0, 1.0);\n"
+"#endif\n"
+"    gAmbient = vec4(base * ka, 1.0);\n"
+"}\n\0";
+
+// Caminho deferred, passo de iluminação: triângulo de tela cheia gerado por gl_VertexID
+const GLchar* lightingVertexSource = "#version 450\n"
+"void main()\n"
+"{\n"
+"    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+"    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);\n"
+"}\n\0";
+
+const GLchar* lightingFragmentHeader = "#version 450\n"
+"#define SPECULAR\n"
+"uniform sampler2D gAlbedo;\n"
+"uniform sampler2D gNormal;\n"
+"uniform sampler2D gMaterial;\n"
+"uniform sampler2D gAmbient;\n"
+"uniform sampler2D gDepth;\n"
+"uniform mat4 invViewProjection;\n";
+
+const GLchar* lightingFragmentSource =
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"    ivec2 pixel = ivec2(gl_FragCoord.xy);\n"
+"    float depth = texelFetch(gDepth, pixel, 0).r;\n"
+"    if (depth >= 1.0)\n"
+"        discard; // Fundo: nada foi desenhado neste pixel\n"
+"    // Posição em mundo reconstruída a partir da profundidade\n"
+"    vec4 ndc = vec4(gl_FragCoord.xy * screenSize.zw * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);\n"
+"    vec4 world = invViewProjection * ndc;\n"
+"    vec3 fragPos = world.xyz / world.w;\n"
+"    vec3 N = decodeOctahedral(texelFetch(gNormal, pixel, 0).xy);\n"
+"    vec3 V = normalize(cameraPos.xyz - fragPos);\n"
+"    vec4 material = texelFetch(gMaterial, pixel, 0);\n"
+"    float viewDepth = -(view * vec4(fragPos, 1.0)).z;\n"
+"    vec3 diffuseLight = vec3(0.0);\n"
+"    vec3 specularLight = vec3(0.0);\n"
+"    accumulateClusterLights(fragPos, N, V, gl_FragCoord.xy, viewDepth, material.a, diffuseLight, specularLight);\n"
+"    vec3 result = ambientLight.rgb * texelFetch(gAmbient, pixel, 0).rgb\n"
+"                + diffuseLight * texelFetch(gAlbedo, pixel, 0).rgb\n"
+"                + specularLight * material.rgb;\n"
+"    color = vec4(result, 1.0);\n"
+"}\n\0";
+
+// Overlay de texto: retângulos em pixels (origem no canto superior esquerdo) com cor por vértice
+const GLchar* overlayVertexSource = "#version 450\n"
+"layout (location = 0) in vec2 position;\n"
+"layout (location = 1) in vec4 vertexColor;\n"
+"uniform vec2 screenSize;\n"
+"out vec4 overlayColor;\n"
+"void main()\n"
+"{\n"
+"    vec2 ndc = position / screenSize * 2.0 - 1.0;\n"
+"    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);\n"
+"    overlayColor = vertexColor;\n"
+"}\n\0";
 
-string mtlFilePath = "";
+const GLchar* overlayFragmentSource = "#version 450\n"
+"in vec4 overlayColor;\n"
+"out vec4 color;\n"
+"void main()\n"
+"{\n"
+"    color = overlayColor;\n"
+"}\n\0";
 
-// Variáveis para iluminação de Phong
-glm::vec3 ambientColor(0.2f, 0.2f, 0.2f), diffuseColor(0.7f, 0.7f, 0.7f), specularColor(0.5f, 0.5f, 0.5f), emissiveColor(0.0f);
-float     diffuseScalar = 0.8f;
-float     shininess     = 16.0f;
+bool rotateX=false, rotateY=false, rotateZ=false;
 
 // Variáveis para controle de câmera em primeira pessoa
 FirstPersonCamera camera(glm::vec3(0.0f, 0.0f, 5.0f));
 bool firstMouse = true;
 float lastX = WIDTH / 2.0f;
 float lastY = HEIGHT / 2.0f;
-float deltaTime = 0.0f;
-float lastFrame = 0.0f;
+float deltaTime = 0.0f; // Passo da simulação (fixo, ver FixedTimestep)
 
 // Variáveis para sistema de trajetórias
 vector<SceneObject> sceneObjects;
@@ -498,6 +694,117 @@ int selectedObjectIndex = 0;
 bool trajectoryMode = false;
 bool showTrajectoryPoints = false;
 
+// Variáveis para o culling de oclusão por CPU
+bool occlusionCullingEnabled = true;
+OcclusionCuller* occlusionCuller = nullptr;
+vector<OccluderInstance> frameOccluders;
+vector<OccludeeBounds> frameOccludees;
+
+// Variáveis para as occlusion queries por GPU (objetos com muitos vértices)
+bool occlusionQueriesEnabled = true;
+bool occlusionQueriesActive = true; // Estado usado no último frame desenhado (thread de renderização)
+const GLuint occlusionQueryMinVertices = 3000;
+OcclusionQuerySystem occlusionQueries;
+
+// Fila de renderização do frame
+RenderQueue renderQueue;
+
+// Cache do estado OpenGL (descarta binds e uniforms redundantes)
+GLStateCache glState;
+
+// UBO com câmera/luz e SSBO com as matrizes por desenho
+StreamingBuffer frameStream;
+
+// Carregador de funções GL do contexto atual (GLFW ou EGL)
+GLADloadproc glLoader = nullptr;
+
+// Arquivo de configuração de cena (--scene), relido pela tecla H
+string sceneConfigPath = "scene_config.txt";
+vector<ObjectUniforms> frameObjectData;
+vector<const SceneProgram*> frameObjectPrograms; // Programa de cada objeto no frame (reaproveitado)
+vector<GLint> frameBoxObjectIndex;                // Índice da caixa de cada objeto no SSBO (-1 = sem query)
+const float farPlane = 100.0f;
+
+// Cache de binários de programas (shader_cache/)
+ProgramCache programCache;
+
+// Compilação assíncrona (paralela no driver ou em contexto compartilhado)
+AsyncProgramCompiler programCompiler;
+
+// Permutações de shader compiladas sob demanda
+ShaderPermutations shaderPermutations;
+
+// Caminho deferred, alternável em tempo de execução contra o forward (tecla N)
+DeferredRenderer deferredRenderer;
+bool deferredAvailable = false;
+bool deferredEnabled = false;
+double pathFrameTime[2] = { 0.0, 0.0 }; // Tempo acumulado por caminho (0 = forward, 1 = deferred)
+long long pathFrames[2] = { 0, 0 };
+
+// Simulação em passo fixo, limitador de FPS (tecla U) e tempos de frame
+FixedTimestep simulation;
+FramePacer framePacer;
+FrameTimeStats frameTimeStats;
+
+// Fases da inicialização até o primeiro frame (relatório no fim do primeiro renderFrame)
+StartupTimeline startupTimeline;
+void printStartupTimeline();
+
+// Carga sob demanda (--lazy): objetos com BOUNDS fora do frustum ficam para quando entrarem nele
+bool lazyLoading = false;
+size_t pendingObjects = 0;      // Objetos ainda sem geometria
+float viewAspect = 1.0f;        // Proporção do framebuffer, para o frustum da carga sob demanda
+glm::vec3 previousCameraPosition(0.0f);
+
+// Profiler de GPU (escopos por passo) e o overlay que mostra as médias
+GpuProfiler gpuProfiler;
+TextOverlay textOverlay;
+bool gpuOverlayEnabled = false;
+string gpuProfilerCsvPath;
+
+// Contadores de chamadas GL (--gl-stats / --gl-call-log)
+GLCallStats glCallStats;
+
+// Métricas ao vivo (--metrics-socket): as threads do frame gravam, a do servidor lê
+MetricsRegistry metrics;
+MetricsServer metricsServer;
+struct MetricHandles
+{
+    MetricsRegistry::Handle frame = -1, frameMs = -1, gpuMs = -1, draws = -1, glCalls = -1, streamKb = -1;
+    MetricsRegistry::Handle objects = -1, trajectories = -1, lights = -1, vramUsedMb = -1, vramFreeMb = -1;
+    MetricsRegistry::Handle inputLatencyMs = -1;
+} metricHandles;
+
+// Memória de vídeo pelas extensões de informação do driver (NVIDIA: usada e livre; AMD: só livre)
+enum VideoMemoryInfo { VIDEO_MEMORY_NONE, VIDEO_MEMORY_NVX, VIDEO_MEMORY_ATI };
+VideoMemoryInfo videoMemoryInfo = VIDEO_MEMORY_NONE;
+
+// Tracer de CPU: frames capturados (--trace-frames ou tecla E) e trace da inicialização
+long long traceFirstFrame = -1, traceLastFrame = -1;
+string traceOutputPath;
+string traceStartupPath;
+long long currentFrame = 0;
+
+// Modo estrito de alocações (--alloc-strict): ligado a partir deste frame (-1 = nunca).
+// Cada tecla pressionada desliga e recomeça o aquecimento (novos caminhos de desenho
+// alocam no primeiro uso)
+long long allocationStrictFrame = -1;
+const int allocationWarmupFrames = 120;
+
+// Thread de renderização (janela) e snapshot usado quando tudo roda numa thread só
+RenderThread<FrameSnapshot> renderThread;
+FrameSnapshot singleThreadSnapshot;
+uint64_t snapshotSequence = 0;
+
+// Latência do input (--latency), limite de fila da GPU (--max-queued-frames) e late latch
+// (--late-latch: a thread de renderização troca a orientação do snapshot pela mais recente)
+InputLatency inputLatency;
+bool lateLatchEnabled = false;
+int64_t latchCameraOrientation(FirstPersonCamera& renderCamera);
+
+// Luzes do frame distribuídas nos clusters do frustum
+LightClusterer lightClusterer;
+
 // Variáveis para rotações individuais dos objetos
 bool suzanneRotateX = false, suzanneRotateY = false, suzanneRotateZ = false;
 bool cubeRotateX = false, cubeRotateY = false, cubeRotateZ = false;
@@ -509,107 +816,6 @@ glm::vec3 cubeInitialPosition = glm::vec3(2.0f, 0.0f, 0.0f);
 // Configuração global da cena
 SceneConfig sceneConfig;
 
-// Função para carregar configuração de cena de arquivo
-SceneConfig loadSceneConfig(const string& filename)
-{
-    SceneConfig config;
-    ifstream file(filename);
-    
-    if (!file.is_open()) {
-        cout << "Erro ao abrir arquivo de configuração: " << filename << endl;
-        return config;
-    }
-    
-    string line;
-    string currentSection = "";
-    
-    while (getline(file, line)) {
-        // Remove espaços em branco no início e fim
-        line.erase(0, line.find_first_not_of(" \t"));
-        line.erase(line.find_last_not_of(" \t") + 1);
-        
-        // Pula linhas vazias e comentários
-        if (line.empty() || line[0] == '#') {
-            continue;
-        }
-        
-        // Verifica se é uma seção
-        if (line[0] == '[' && line[line.length()-1] == ']') {
-            currentSection = line.substr(1, line.length()-2);
-            continue;
-        }
-        
-        istringstream iss(line);
-        string keyword;
-        iss >> keyword;
-        
-        if (currentSection == "OBJECTS") {
-            if (keyword == "OBJECT") {
-                ObjectConfig obj;
-                iss >> obj.name >> obj.objFilePath;
-                
-                // Lê transformações
-                float px, py, pz, rx, ry, rz, sx, sy, sz;
-                iss >> px >> py >> pz >> rx >> ry >> rz >> sx >> sy >> sz;
-                obj.position = glm::vec3(px, py, pz);
-                obj.rotation = glm::vec3(rx, ry, rz);
-                obj.scale = glm::vec3(sx, sy, sz);
-                
-                // Lê textura (opcional)
-                iss >> obj.texturePath;
-                
-                // Lê trajetória (opcional)
-                iss >> obj.hasTrajectory;
-                if (obj.hasTrajectory) {
-                    int numPoints;
-                    iss >> numPoints;
-                    for (int i = 0; i < numPoints; ++i) {
-                        float x, y, z, time;
-                        iss >> x >> y >> z >> time;
-                        obj.trajectoryPoints.push_back(glm::vec3(x, y, z));
-                        obj.trajectoryTimes.push_back(time);
-                    }
-                }
-                
-                config.objects.push_back(obj);
-            }
-        }
-        else if (currentSection == "LIGHTS") {
-            if (keyword == "LIGHT") {
-                LightConfig light;
-                float px, py, pz, cx, cy, cz, intensity;
-                iss >> px >> py >> pz >> cx >> cy >> cz >> intensity;
-                light.position = glm::vec3(px, py, pz);
-                light.color = glm::vec3(cx, cy, cz);
-                light.intensity = intensity;
-                config.lights.push_back(light);
-            }
-        }
-        else if (currentSection == "CAMERA") {
-            if (keyword == "POSITION") {
-                float px, py, pz;
-                iss >> px >> py >> pz;
-                config.camera.position = glm::vec3(px, py, pz);
-            }
-            else if (keyword == "TARGET") {
-                float tx, ty, tz;
-                iss >> tx >> ty >> tz;
-                config.camera.target = glm::vec3(tx, ty, tz);
-            }
-            else if (keyword == "FRUSTUM") {
-                iss >> config.camera.fov >> config.camera.nearPlane >> config.camera.farPlane;
-            }
-        }
-    }
-    
-    file.close();
-    cout << "Configuração de cena carregada de: " << filename << endl;
-    cout << "Objetos: " << config.objects.size() << endl;
-    cout << "Luzes: " << config.lights.size() << endl;
-    
-    return config;
-}
-
 // Função para mostrar instruções de uso
 void showInstructions()
 {
@@ -628,6 +834,13 @@ void showInstructions()
     cout << "L - Carregar trajetória de arquivo" << endl;
     cout << "O - Selecionar próximo objeto" << endl;
     cout << "V - Mostrar/Esconder pontos de controle" << endl;
+    cout << "K - Ativar/Desativar culling de oclusão por CPU" << endl;
+    cout << "J - Ativar/Desativar occlusion queries por GPU" << endl;
+    cout << "N - Alternar entre renderização forward e deferred" << endl;
+    cout << "U - Alternar limite de FPS (desligado, 30, 60, 144)" << endl;
+    cout << "M - Mostrar/Esconder overlay com os tempos de GPU por passo" << endl;
+    cout << "E - Gravar trace de CPU dos próximos 120 frames (JSON do chrome://tracing)" << endl;
+    cout << "B - Mostrar estatísticas da fila de renderização, do cache de estado GL e das luzes" << endl;
     cout << "I - Mostrar informações da trajetória" << endl;
     cout << "1 - Criar trajetória circular" << endl;
     cout << "2 - Criar trajetória quadrada" << endl;
@@ -639,8 +852,71 @@ void showInstructions()
 }
 
 // Função MAIN
-int main()
+int main(int argc, char** argv)
 {
+    AppOptions options = parseArguments(argc, argv);
+    sceneConfigPath = options.scenePath;
+    gpuOverlayEnabled = options.gpuOverlay;
+    gpuProfilerCsvPath = options.gpuCsvPath;
+    simulation.setRate(options.simulationHz);
+    deferredEnabled = options.deferred;
+    lazyLoading = options.lazyLoading;
+
+    // Tracer de CPU: a captura da inicialização termina no fim de initScene
+    CG_TRACE_THREAD("principal");
+    traceFirstFrame = options.traceFirstFrame;
+    traceLastFrame = options.traceLastFrame;
+    traceOutputPath = options.traceOutputPath;
+    traceStartupPath = options.traceStartupPath;
+    bool traceRequested = !traceStartupPath.empty() || traceFirstFrame >= 0;
+    if (traceRequested && !CpuTracer::compiledIn())
+    {
+        cout << "ERROR::TRACER::NOT_COMPILED: configure com -DCG_ENABLE_TRACING=ON para gravar traces de CPU" << endl;
+    }
+    if (!traceStartupPath.empty())
+    {
+        CpuTracer::instance().startCapture();
+    }
+    if (options.perfCounters)
+    {
+        PerfCounters::instance().enable();
+    }
+    if (!options.metricsSocketPath.empty() && options.simulateCount == 0)
+    {
+        registerMetrics();
+        if (metricsServer.start(metrics, options.metricsSocketPath, options.metricsHz))
+            cout << "Métricas: " << options.metricsHz << " linhas por segundo em " << options.metricsSocketPath
+                 << " (cliente: cg_metrics " << options.metricsSocketPath << ")" << endl;
+    }
+    if (options.allocStrict)
+    {
+        if (AllocationTracker::compiledIn())
+            allocationStrictFrame = allocationWarmupFrames;
+        else
+            cout << "ERROR::ALLOC::NOT_COMPILED: configure com -DCG_TRACK_ALLOCATIONS=ON para o modo estrito de alocações" << endl;
+    }
+    startupTimeline.mark("argumentos e opções");
+
+    if (options.simulateCount > 0)
+    {
+        return runSimulation(options);
+    }
+    if (!options.benchmarkCameraPath.empty())
+    {
+        return runBenchmark(options);
+    }
+    if (options.headless)
+    {
+        return runHeadless(options);
+    }
+
+    // Latência e late latch só fazem sentido com a janela (o headless não tem input)
+    inputLatency.setEnabled(options.inputLatency);
+    inputLatency.setMaxQueuedFrames(options.maxQueuedFrames);
+    lateLatchEnabled = options.lateLatch && !options.singleThread;
+    if (options.lateLatch && options.singleThread)
+        cout << "Late latch ignorado com --single-thread: o input já é lido logo antes do desenho" << endl;
+
     // Inicialização da GLFW
     glfwInit();
 
@@ -650,7 +926,7 @@ int main()
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
     // Criação da janela
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Ola 3D -- Eduardo!", nullptr, nullptr);
+    GLFWwindow* window = glfwCreateWindow(options.width, options.height, "Ola 3D -- Eduardo!", nullptr, nullptr);
     glfwMakeContextCurrent(window);
 
     // Callback de teclado
@@ -660,12 +936,16 @@ int main()
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    startupTimeline.mark("GLFW e janela");
 
     // Inicializa GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    glLoader = (GLADloadproc)glfwGetProcAddress;
+    if (!gladLoadGLLoader(glLoader)) {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    installGLCallStats(options);
+    startupTimeline.mark("GLAD");
 
     // Informações da GPU
     std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
@@ -673,227 +953,1128 @@ int main()
 
     // Mostrar instruções de uso
     showInstructions();
+    startupTimeline.mark("instruções");
 
     // Configuração da viewport
     int width, height;
     glfwGetFramebufferSize(window, &width, &height);
-    glViewport(0, 0, width, height);
 
-    // Compilação dos shaders e geometria
-    GLuint shaderID = setupShader();
-    
-    // Carregar configuração de cena de arquivo
-    sceneConfig = loadSceneConfig("scene_config.txt");
-    
-    // Criar objetos da cena baseado na configuração
-    for (const auto& objConfig : sceneConfig.objects) {
-        SceneObject obj(objConfig.name);
-        
-        // Carregar geometria do arquivo OBJ
-        if (objConfig.objFilePath.find(".obj") != string::npos) {
-            obj.geometry = setupGeometryFromFile(objConfig.objFilePath.c_str());
-        } else {
-            // Se não for OBJ, criar geometria padrão (cubo)
-            obj.geometry = createThreeWallCornerGeometry(objConfig.texturePath);
-        }
-        
-        // Aplicar transformações iniciais
-        obj.position = objConfig.position;
-        obj.rotation = objConfig.rotation;
-        obj.scale = objConfig.scale;
-        
-        // Configurar trajetória se especificada
-        if (objConfig.hasTrajectory) {
-            for (size_t i = 0; i < objConfig.trajectoryPoints.size(); ++i) {
-                float time = (i < objConfig.trajectoryTimes.size()) ? objConfig.trajectoryTimes[i] : 2.0f;
-                obj.trajectory.addControlPoint(objConfig.trajectoryPoints[i], time);
-            }
-        }
-        
-        sceneObjects.push_back(obj);
-        cout << "Objeto criado: " << objConfig.name << endl;
-    }
-    
-    // Configurar câmera baseado na configuração
-    if (sceneConfig.camera.position != glm::vec3(0.0f)) {
-        camera = FirstPersonCamera(sceneConfig.camera.position);
+    // Sem GL_KHR_parallel_shader_compile, os shaders são compilados numa thread com um
+    // contexto invisível que compartilha objetos com o da janela
+    GLFWwindow* compileContext = nullptr;
+    if (!AsyncProgramCompiler::supportsParallelCompile())
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        compileContext = glfwCreateWindow(1, 1, "", nullptr, window);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
     }
 
-    glUseProgram(shaderID);
-
-    // Localizações dos uniforms
-    GLint modelLoc = glGetUniformLocation(shaderID, "model");
-    GLint viewLoc = glGetUniformLocation(shaderID, "view");
-    GLint projLoc = glGetUniformLocation(shaderID, "projection");
+    initScene(width, height, compileContext);
+    framePacer.setTargetFps(options.fpsLimit);
+    if (!traceStartupPath.empty())
+    {
+        finishTraceCapture(traceStartupPath);
+    }
+    startupTimeline.mark("trace da inicialização");
 
-    glEnable(GL_DEPTH_TEST);
-    // Habilitar blending para transparência
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // O contexto da janela passa para a thread de renderização; esta fica com os
+    // eventos (a GLFW exige que sejam tratados na thread principal) e a simulação
+    if (!options.singleThread)
+    {
+        glfwMakeContextCurrent(nullptr);
+        renderThread.start(window, [width, height](const FrameSnapshot& snapshot) {
+            renderFrame(snapshot, width, height, 0);
+        }, [](const FrameSnapshot&) {
+            inputLatency.endFrame();
+        });
+    }
+    cout << "Renderização: " << (options.singleThread ? "mesma thread da simulação" : "thread dedicada (snapshots em buffer triplo)") << endl;
 
-    // Loop da aplicação - "game loop"
+    // Loop da aplicação - "game loop": a simulação roda em passos fixos e o desenho
+    // interpola entre os dois últimos passos
+    double previousTime = glfwGetTime();
     while (!glfwWindowShouldClose(window))
     {
-        // Calcula delta time
-        float currentFrame = static_cast<float>(glfwGetTime());
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+        updateAllocationStrict(currentFrame);
+        updateTraceCapture(currentFrame++);
+        CG_TRACE_SCOPE("frame");
 
-        // Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
-		glfwPollEvents();
-
-        // Processa input contínuo
-        processInput(window);
+        // Tempo real do frame (em double: em float perde precisão com a aplicação aberta por horas)
+        double currentTime = glfwGetTime();
+        double frameDelta = currentTime - previousTime;
+        previousTime = currentTime;
+        frameTimeStats.add(frameDelta * 1000.0);
 
-        // Atualiza trajetórias
-        for (auto& obj : sceneObjects)
+        // Checa se houveram eventos de input (key pressed, mouse moved etc.) e chama as funções de callback correspondentes
         {
-            if (obj.trajectory.isRunning())
-            {
-                obj.trajectory.update(deltaTime);
-                obj.position = obj.trajectory.getCurrentPosition();
-            }
+            CG_TRACE_SCOPE("eventos");
+            glfwPollEvents();
         }
 
-        // Limpa buffer de cor
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        float angle = (GLfloat)glfwGetTime();
-
-        // MATRIZ DA CAMERA usando a nova câmera em primeira pessoa
-        glm::mat4 view = camera.getViewMatrix();
-
-        // MATRIZ PARA ZOOM
-        glm::mat4 projection = glm::perspective(
-            glm::radians(45.0f),
-            (float)width / height,
-            0.1f,
-            100.0f
-        );
-
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-        glLineWidth(10);
-        glPointSize(20);
-        
-        // Configuração da iluminação de Phong
-        glUniform3f(glGetUniformLocation(shaderID, "ka"), ambientColor.r, ambientColor.g, ambientColor.b);
-        glUniform3f(glGetUniformLocation(shaderID, "kd"), diffuseColor.r, diffuseColor.g, diffuseColor.b);
-        glUniform3f(glGetUniformLocation(shaderID, "ks"), specularColor.r, specularColor.g, specularColor.b);
-        glUniform1f(glGetUniformLocation(shaderID, "q"), shininess);
-
-        // Usar luzes da configuração de cena (ou luz padrão se não houver configuração)
-        if (!sceneConfig.lights.empty()) {
-            const auto& light = sceneConfig.lights[0]; // Usar primeira luz por enquanto
-            glUniform3f(glGetUniformLocation(shaderID, "lightPos"), light.position.x, light.position.y, light.position.z);
-            glUniform3f(glGetUniformLocation(shaderID, "lightColor"), 
-                       light.color.x * light.intensity, 
-                       light.color.y * light.intensity, 
-                       light.color.z * light.intensity);
-        } else {
-            // Luz padrão se não houver configuração
-            glUniform3f(glGetUniformLocation(shaderID, "lightPos"), 3.0f, 1.0f, 2.0f);
-            glUniform3f(glGetUniformLocation(shaderID, "lightColor"), 0.8f, 0.8f, 0.8f);
+        // Passos de simulação devidos (input contínuo incluído)
+        int steps = simulation.advance(frameDelta);
+        for (int i = 0; i < steps; ++i)
+        {
+            updateScene((float)simulation.getStep(), window);
         }
-        
-        glUniform3f(glGetUniformLocation(shaderID, "cameraPos"), camera.position.x, camera.position.y, camera.position.z);
-        
-        // Renderização dos objetos da cena
-        for (size_t i = 0; i < sceneObjects.size(); ++i)
+        loadVisibleObjects((float)simulation.getRenderTime(), simulation.getAlpha());
+
+        if (renderThread.isRunning())
         {
-            auto& obj = sceneObjects[i];
-            
-            glActiveTexture(GL_TEXTURE0);
-            if (obj.geometry.textureID > 0) {
-                glBindTexture(GL_TEXTURE_2D, obj.geometry.textureID);
-            } else {
-                glBindTexture(GL_TEXTURE_2D, 0);
-            }
-            glUniform1i(glGetUniformLocation(shaderID, "tex_buffer"), 0);
-            
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, obj.position);
-            
-            // Rotação inicial para posicionar o objeto virado para a frente (câmera)
-            model = glm::rotate(model, glm::radians(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-            model = glm::scale(model, obj.scale);
-            
-            // Rotação específica para o Suzanne (girar para a direita)
-            if (obj.name == "Suzanne") {
-                model = glm::rotate(model, glm::radians(45.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-                
-                // Aplicar rotações individuais do Suzanne
-                if (suzanneRotateX)
-                    model = glm::rotate(model, angle, glm::vec3(1.0f, 0.0f, 0.0f));
-                else if (suzanneRotateY)
-                    model = glm::rotate(model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-                else if (suzanneRotateZ)
-                    model = glm::rotate(model, angle, glm::vec3(0.0f, 0.0f, 1.0f));
-            }
-            else if (obj.name == "WallCorner") {
-                // Aplicar rotações individuais do cubo
-                if (cubeRotateX)
-                    model = glm::rotate(model, angle, glm::vec3(1.0f, 0.0f, 0.0f));
-                else if (cubeRotateY)
-                    model = glm::rotate(model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-                else if (cubeRotateZ)
-                    model = glm::rotate(model, angle, glm::vec3(0.0f, 0.0f, 1.0f));
+            // Snapshot do frame N+1 montado enquanto a outra thread submete o frame N
+            FrameSnapshot& snapshot = renderThread.beginSnapshot();
+            buildSnapshot(snapshot, (float)simulation.getRenderTime(), simulation.getAlpha(), (float)frameDelta);
+            renderThread.publish();
+
+            // Um snapshot por frame desenhado: espera a renderização pegar este. Com late
+            // latch, os eventos continuam sendo tratados durante a espera, para o desenho
+            // do próximo frame pegar o mouse de logo antes dele
+            CG_TRACE_SCOPE("espera da renderização");
+            if (lateLatchEnabled)
+            {
+                while (!renderThread.waitConsumed(0.001) && !glfwWindowShouldClose(window))
+                    glfwPollEvents();
             }
-            
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-            glBindVertexArray(obj.geometry.VAO);
-            glDrawArrays(GL_TRIANGLES, 0, obj.geometry.vertexCount);
-            glBindVertexArray(0);
+            else
+                renderThread.waitConsumed(0.1);
         }
+        else
+        {
+            buildSnapshot(singleThreadSnapshot, (float)simulation.getRenderTime(), simulation.getAlpha(), (float)frameDelta);
+            renderFrame(singleThreadSnapshot, width, height, 0);
 
-        // Renderização dos pontos de controle da trajetória
-        renderTrajectoryPoints(sceneObjects[selectedObjectIndex].trajectory, shaderID, view, projection);
+            // Troca de buffers
+            CG_TRACE_SCOPE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+            inputLatency.endFrame();
+        }
 
-        // Troca de buffers
-        glfwSwapBuffers(window);
+        // Limitador de FPS (sleep + giro até o prazo)
+        CG_TRACE_SCOPE("limitador de FPS");
+        framePacer.wait();
     }
+    finishTraceCapture(traceOutputPath);
 
-    // Limpeza
-    for (auto& obj : sceneObjects)
+    if (renderThread.isRunning())
     {
-        glDeleteVertexArrays(1, &obj.geometry.VAO);
+        renderThread.stop();
+        glfwMakeContextCurrent(window);
+    }
+    shutdownScene();
+    if (compileContext)
+    {
+        glfwDestroyWindow(compileContext);
     }
     glfwTerminate();
     return 0;
 }
 
-// Função de callback de teclado - só pode ter uma instância (deve ser estática se
-// estiver dentro de uma classe) - É chamada sempre que uma tecla for pressionada
-// ou solta via GLFW
-
-void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode)
+// Interpreta as opções de linha de comando (todas opcionais; sem elas abre a janela)
+AppOptions parseArguments(int argc, char** argv)
 {
-    if (action == GLFW_PRESS || action == GLFW_REPEAT)
+    AppOptions options;
+    for (int i = 1; i < argc; ++i)
     {
-        if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
-		glfwSetWindowShouldClose(window, GL_TRUE);
-
-		if (key == GLFW_KEY_X && action == GLFW_PRESS)
-		{
-			rotateX = true;
-			rotateY = false;
-			rotateZ = false;
-		}
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--headless")
+            options.headless = true;
+        else if (arg == "--deferred")
+            options.deferred = true;
+        else if (arg == "--single-thread")
+            options.singleThread = true;
+        else if (arg == "--gpu-overlay")
+            options.gpuOverlay = true;
+        else if (arg == "--gpu-csv" && hasValue)
+            options.gpuCsvPath = argv[++i];
+        else if (arg == "--gl-stats")
+            options.glStats = true;
+        else if (arg == "--gl-call-log" && hasValue)
+            options.glCallLogPath = argv[++i];
+        else if (arg == "--perf")
+            options.perfCounters = true;
+        else if (arg == "--alloc-strict")
+            options.allocStrict = true;
+        else if (arg == "--lazy")
+            options.lazyLoading = true;
+        else if (arg == "--latency")
+            options.inputLatency = true;
+        else if (arg == "--late-latch")
+            options.lateLatch = true;
+        else if (arg == "--max-queued-frames" && hasValue)
+            options.maxQueuedFrames = max(0, atoi(argv[++i]));
+        else if (arg == "--metrics-socket" && hasValue)
+            options.metricsSocketPath = argv[++i];
+        else if (arg == "--metrics-hz" && hasValue)
+            options.metricsHz = max(0.1, atof(argv[++i]));
+        else if (arg == "--trace-startup" && hasValue)
+            options.traceStartupPath = argv[++i];
+        else if (arg == "--trace-frames" && hasValue)
+        {
+            long long first = 0, last = 0;
+            if (sscanf(argv[++i], "%lld-%lld", &first, &last) == 2 && first >= 0 && last >= first)
+            {
+                options.traceFirstFrame = first;
+                options.traceLastFrame = last;
+            }
+            else
+                cout << "Intervalo inválido (use PRIMEIRO-ÚLTIMO): " << argv[i] << endl;
+        }
+        else if (arg == "--trace-output" && hasValue)
+            options.traceOutputPath = argv[++i];
+        else if (arg == "--frames" && hasValue)
+            options.frames = max(1, atoi(argv[++i]));
+        else if (arg == "--size" && hasValue)
+        {
+            int w = 0, h = 0;
+            if (sscanf(argv[++i], "%dx%d", &w, &h) == 2 && w > 0 && h > 0)
+            {
+                options.width = w;
+                options.height = h;
+            }
+            else
+                cout << "Tamanho inválido (use LARGURAxALTURA): " << argv[i] << endl;
+        }
+        else if (arg == "--output" && hasValue)
+            options.outputDir = argv[++i];
+        else if (arg == "--save-every" && hasValue)
+            options.saveEvery = max(0, atoi(argv[++i]));
+        else if (arg == "--fps" && hasValue)
+            options.frameTime = 1.0f / max(1.0f, (float)atof(argv[++i]));
+        else if (arg == "--sim-hz" && hasValue)
+            options.simulationHz = max(1.0, atof(argv[++i]));
+        else if (arg == "--fps-limit" && hasValue)
+            options.fpsLimit = max(0.0, atof(argv[++i]));
+        else if (arg == "--scene" && hasValue)
+            options.scenePath = argv[++i];
+        else if (arg == "--benchmark" && i + 2 < argc)
+        {
+            options.scenePath = argv[++i];
+            options.benchmarkCameraPath = argv[++i];
+        }
+        else if (arg == "--warmup" && hasValue)
+            options.warmupFrames = max(0, atoi(argv[++i]));
+        else if (arg == "--bench-output" && hasValue)
+            options.benchmarkOutputPath = argv[++i];
+        else if (arg == "--simulate" && hasValue)
+            options.simulateCount = (size_t)strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--ticks" && hasValue)
+            options.simulateTicks = max(1, atoi(argv[++i]));
+        else if (arg == "--sim-threads" && hasValue)
+            options.simulateThreads = max(0, atoi(argv[++i]));
+        else if (arg == "--sim-dump" && hasValue)
+            options.simulateDumpPath = argv[++i];
+        else if (arg == "--sim-dump-every" && hasValue)
+            options.simulateDumpEvery = max(1, atoi(argv[++i]));
+        else
+            cout << "Opção desconhecida ou sem valor: " << arg << endl;
+    }
+    return options;
+}
 
-		if (key == GLFW_KEY_Y && action == GLFW_PRESS)
-		{
-			rotateX = false;
-			rotateY = true;
-			rotateZ = false;
-		}
+// Prepara shaders, cena e buffers no contexto atual (janela ou headless)
+void initScene(int width, int height, GLFWwindow* compileContext)
+{
+    CG_TRACE_FUNCTION();
+    startupTimeline.mark("contexto GL");
+    glViewport(0, 0, width, height);
 
-		if (key == GLFW_KEY_Z && action == GLFW_PRESS)
-		{
-			rotateX = false;
-			rotateY = false;
-			rotateZ = true;
+    // Compilação dos shaders e geometria (ou carga dos binários em cache)
+    programCache.init(glLoader);
+    AsyncProgramCompiler::Mode compileMode = programCompiler.init(glLoader, &programCache, compileContext);
+    cout << "Compilação de shaders: " << AsyncProgramCompiler::modeName(compileMode) << endl;
+    if (AsyncProgramCompiler::hasExtension("GL_NVX_gpu_memory_info"))
+        videoMemoryInfo = VIDEO_MEMORY_NVX;
+    else if (AsyncProgramCompiler::hasExtension("GL_ATI_meminfo"))
+        videoMemoryInfo = VIDEO_MEMORY_ATI;
+    startupTimeline.mark("cache e compilador de programas");
+    auto shaderSetupStart = std::chrono::steady_clock::now();
+    GLuint shaderID = setupShader();
+    std::chrono::duration<double> shaderSetupTime = std::chrono::steady_clock::now() - shaderSetupStart;
+    
+    startupTimeline.mark("shaders");
+    
+    // Carregar configuração de cena de arquivo
+    sceneConfig = loadSceneConfig(sceneConfigPath);
+    startupTimeline.mark("configuração da cena");
+    
+    // Configurar câmera baseado na configuração (antes dos objetos: o --lazy usa o frustum inicial)
+    if (sceneConfig.camera.position != glm::vec3(0.0f)) {
+        camera = FirstPersonCamera(sceneConfig.camera.position);
+    }
+    
+    // Criar objetos da cena baseado na configuração
+    viewAspect = (float)width / height;
+    createSceneObjects(sceneConfig);
+    startupTimeline.mark("objetos (OBJ, MTL, texturas)");
+
+    // Threads de trabalho do culling de oclusão
+    occlusionCuller = new OcclusionCuller();
+    cout << "Culling de oclusão: " << occlusionCuller->getWorkerCount() << " threads, buffer "
+         << OcclusionCuller::BUFFER_WIDTH << "x" << OcclusionCuller::BUFFER_HEIGHT << endl;
+
+    // Queries de oclusão para os objetos caros
+    occlusionQueries.init();
+    occlusionQueries.reset(sceneObjects.size());
+    startupTimeline.mark("culling e queries de oclusão");
+
+    // As funções de carregamento alteram binds por fora do cache
+    glState.invalidate();
+    glState.useProgram(shaderID);
+
+    // Buffers de dados por frame e por objeto
+    createFrameBuffers();
+    startupTimeline.mark("buffers do frame");
+
+    // Caminho deferred: G-buffer do tamanho do framebuffer (o passo de geometria usa
+    // as permutações SHADER_GBUFFER)
+    shaderSetupStart = std::chrono::steady_clock::now();
+    GLuint lightingProgramID = setupDeferredLightingShader();
+    shaderSetupTime += std::chrono::steady_clock::now() - shaderSetupStart;
+    startupTimeline.mark("shaders");
+    deferredAvailable = deferredRenderer.init(glState, width, height, lightingProgramID);
+
+    // Timer queries dos passos e overlay com as médias
+    gpuProfiler.init();
+    if (!gpuProfilerCsvPath.empty())
+    {
+        if (gpuProfiler.openCsv(gpuProfilerCsvPath))
+            cout << "Tempos de GPU gravados em " << gpuProfilerCsvPath << endl;
+        else
+            cout << "ERROR::GPU_PROFILER::CSV_OPEN_FAILED " << gpuProfilerCsvPath << endl;
+    }
+    startupTimeline.mark("deferred e profiler de GPU");
+    shaderSetupStart = std::chrono::steady_clock::now();
+    GLuint overlayProgramID = setupOverlayShader();
+    shaderSetupTime += std::chrono::steady_clock::now() - shaderSetupStart;
+    startupTimeline.mark("shaders");
+    textOverlay.init(glState, overlayProgramID);
+
+    // Tempo de preparação dos shaders: frio (compilando) ou quente (tudo do cache)
+    const auto& cacheStats = programCache.getStats();
+    cout << "Shaders prontos em " << shaderSetupTime.count() * 1000.0 << " ms (";
+    if (!programCache.isEnabled())
+        cout << "cache de binários indisponível";
+    else if (cacheStats.hits > 0 && cacheStats.misses + cacheStats.rejected == 0)
+        cout << "cache quente: " << cacheStats.hits << " programas carregados";
+    else
+        cout << "cache frio: " << cacheStats.hits << " carregados, " << cacheStats.misses << " compilados, "
+             << cacheStats.rejected << " rejeitados, " << cacheStats.stored << " gravados";
+    cout << ")" << endl;
+
+    glState.enable(GL_DEPTH_TEST);
+    // Habilitar blending para transparência
+    glState.enable(GL_BLEND);
+    glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    startupTimeline.mark("overlay e estado GL");
+}
+
+// Um passo fixo da simulação: input contínuo da câmera (se houver janela) e trajetórias
+void updateScene(float step, GLFWwindow* window)
+{
+    CG_TRACE_FUNCTION();
+    PerfCounters::Scope perfScope("trajetórias", sceneObjects.size());
+    AllocationTracker::Scope allocationScope(AllocationTracker::FRAME_LOOP);
+    // Estado do passo anterior, para a interpolação no desenho
+    previousCameraPosition = camera.position;
+    for (auto& obj : sceneObjects)
+    {
+        obj.previousPosition = obj.position;
+    }
+
+    deltaTime = step;
+    if (window)
+    {
+        processInput(window);
+    }
+
+    // Atualiza trajetórias
+    int runningTrajectories = 0;
+    for (auto& obj : sceneObjects)
+    {
+        if (obj.trajectory.isRunning())
+        {
+            obj.trajectory.update(step);
+            obj.position = obj.trajectory.getCurrentPosition();
+            runningTrajectories++;
+        }
+    }
+    metrics.set(metricHandles.trajectories, runningTrajectories);
+}
+
+// Monta o snapshot do frame com o estado atual da simulação. time move as rotações e
+// alpha interpola câmera e objetos entre os dois últimos passos de simulação
+void buildSnapshot(FrameSnapshot& snapshot, float time, float alpha, float frameDelta)
+{
+    CG_TRACE_FUNCTION();
+    AllocationTracker::Scope allocationScope(AllocationTracker::FRAME_LOOP);
+    snapshot.sequence = ++snapshotSequence;
+    snapshot.frameDelta = frameDelta;
+    snapshot.inputTime = lateLatchEnabled ? 0 : inputLatency.takeInput(); // Com late latch, o desenho consome
+    snapshot.deferred = deferredEnabled && deferredAvailable;
+    snapshot.occlusionCulling = occlusionCullingEnabled;
+    snapshot.occlusionQueries = occlusionQueriesEnabled;
+    snapshot.gpuOverlay = gpuOverlayEnabled;
+
+    // MATRIZ DA CAMERA usando a nova câmera em primeira pessoa
+    snapshot.camera = camera;
+    snapshot.camera.position = glm::mix(previousCameraPosition, camera.position, alpha);
+
+    // Matrizes de modelo (clear/push_back reaproveitam a capacidade do snapshot reciclado)
+    snapshot.objects.clear();
+    for (const auto& obj : sceneObjects)
+    {
+        snapshot.objects.push_back({ &obj.geometry, buildModelMatrix(obj, time, alpha), obj.isOccluder });
+    }
+
+    // Todas as luzes da configuração de cena (ou luz padrão se não houver configuração)
+    snapshot.lights.clear();
+    for (const auto& light : sceneConfig.lights) {
+        snapshot.lights.push_back({ glm::vec4(light.position, light.range), glm::vec4(light.color * light.intensity, 1.0f) });
+    }
+    if (snapshot.lights.empty()) {
+        // Luz padrão se não houver configuração
+        snapshot.lights.push_back({ glm::vec4(3.0f, 1.0f, 2.0f, defaultLightRange), glm::vec4(0.8f, 0.8f, 0.8f, 1.0f) });
+    }
+
+    snapshot.controlPoints.clear();
+    if (showTrajectoryPoints && !sceneObjects.empty())
+    {
+        for (const auto& point : sceneObjects[selectedObjectIndex].trajectory.getControlPoints())
+        {
+            snapshot.controlPoints.push_back(point.position);
+        }
+    }
+
+    metrics.set(metricHandles.frame, (double)snapshot.sequence);
+    metrics.set(metricHandles.frameMs, frameDelta * 1000.0);
+    metrics.set(metricHandles.objects, (double)snapshot.objects.size());
+    metrics.set(metricHandles.lights, (double)snapshot.lights.size());
+}
+
+// Renderiza o frame de um snapshot em targetFramebuffer (0 = janela). Roda na thread
+// dona do contexto GL e não lê o estado da simulação, só o snapshot
+void renderFrame(const FrameSnapshot& snapshot, int width, int height, GLuint targetFramebuffer)
+{
+    CG_TRACE_FUNCTION();
+    AllocationTracker::Scope allocationScope(AllocationTracker::FRAME_LOOP);
+
+    // Limite de fila da GPU (pode esperar o frame mais antigo) antes de ler o input: com
+    // --late-latch a câmera usa a orientação do mouse de agora, não a do snapshot
+    inputLatency.beginFrame();
+    FirstPersonCamera renderCamera = snapshot.camera;
+    inputLatency.setFrameInput(lateLatchEnabled ? latchCameraOrientation(renderCamera) : snapshot.inputTime);
+    const vector<SnapshotObject>& objects = snapshot.objects;
+    const vector<GPULight>& frameLights = snapshot.lights;
+    glm::mat4 view = renderCamera.getViewMatrix();
+
+    // MATRIZ PARA ZOOM
+    glm::mat4 projection = glm::perspective(
+        glm::radians(45.0f),
+        (float)width / height,
+        0.1f,
+        farPlane
+    );
+
+    // Disparo do culling de oclusão nas threads de trabalho, que rodam enquanto esta
+    // thread prepara o frame e a GPU termina o anterior
+    if (snapshot.occlusionCulling)
+    {
+        frameOccluders.clear();
+        frameOccludees.clear();
+        for (const auto& obj : objects)
+        {
+            if (obj.isOccluder && !obj.geometry->occluderTriangles.empty())
+                frameOccluders.push_back({ &obj.geometry->occluderTriangles, obj.model });
+            frameOccludees.push_back({ obj.geometry->boundsMin, obj.geometry->boundsMax, obj.model });
+        }
+        occlusionCuller->beginFrame(projection * view, frameOccluders, frameOccludees);
+    }
+
+    // Tempos de GPU: lê o frame de FRAME_LATENCY frames atrás (se pronto) e abre o escopo
+    // do frame inteiro
+    gpuProfiler.beginFrame();
+    int frameScope = gpuProfiler.beginScope("frame");
+
+    // Limpa buffer de cor (da janela ou do FBO do modo headless)
+    glState.bindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+    glState.clearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glState.lineWidth(10);
+    glState.pointSize(20);
+    
+    bool deferredFrame = snapshot.deferred;
+    pathFrameTime[deferredFrame ? 1 : 0] += snapshot.frameDelta;
+    pathFrames[deferredFrame ? 1 : 0]++;
+
+    // Dados do frame: câmera e luz num único upload compartilhado por todos os programas
+    FrameUniforms frameData;
+    frameData.view = view;
+    frameData.projection = projection;
+    frameData.viewProjection = projection * view;
+    frameData.cameraPos = glm::vec4(renderCamera.position, 1.0f);
+
+    // Luzes do snapshot distribuídas nos clusters do frustum desta câmera
+    lightClusterer.build(view, glm::radians(45.0f), (float)width / height, 0.1f, farPlane, frameLights);
+
+    // A luz ambiente continua vindo da primeira luz
+    frameData.ambientLight = frameLights[0].color;
+    frameData.screenSize = glm::vec4((float)width, (float)height, 1.0f / width, 1.0f / height);
+    frameData.clusterParams = glm::vec4(lightClusterer.getSliceScale(), lightClusterer.getSliceBias(), 0.0f, 0.0f);
+    frameData.clusterGrid = glm::uvec4(LightClusterer::GRID_X, LightClusterer::GRID_Y, LightClusterer::GRID_Z,
+                                       (unsigned)frameLights.size());
+
+    // Dados por objeto: modelo e matriz normal calculadas uma vez por objeto na CPU
+    frameObjectData.clear();
+    for (const auto& obj : objects)
+    {
+        frameObjectData.push_back(makeObjectUniforms(obj.model, *obj.geometry));
+    }
+
+    // Resultado do culling de oclusão (1 = visível)
+    const vector<uint8_t>* visibility = nullptr;
+    if (snapshot.occlusionCulling)
+    {
+        CG_TRACE_SCOPE("espera do culling");
+        visibility = &occlusionCuller->waitResults();
+    }
+
+    // Permutações que terminaram de compilar desde o último frame
+    shaderPermutations.beginFrame();
+
+    // Resultados prontos das queries de frames anteriores (sem bloquear). Ao ligar ou
+    // desligar as queries (tecla J), o que ficou em voo é de antes e é descartado
+    if (snapshot.occlusionQueries != occlusionQueriesActive)
+    {
+        occlusionQueries.invalidateAll();
+        occlusionQueriesActive = snapshot.occlusionQueries;
+    }
+    if (snapshot.occlusionQueries)
+    {
+        occlusionQueries.beginFrame();
+    }
+    
+    // Monta a fila de renderização com os desenhos visíveis. Os objetos caros ficam numa
+    // camada posterior para serem testados com occlusion queries contra o depth buffer
+    // já preenchido pelos demais
+    renderQueue.clear();
+    vector<const SceneProgram*>& objectPrograms = frameObjectPrograms;
+    objectPrograms.assign(objects.size(), nullptr);
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        const Geometry& geometry = *objects[i].geometry;
+
+        if (visibility && !(*visibility)[i])
+        {
+            // Rejeitado pela CPU: ao voltar a aparecer, não age sobre uma query antiga
+            if (snapshot.occlusionQueries && i < occlusionQueries.getObjectCount())
+                occlusionQueries.invalidate(i);
+            continue;
+        }
+        if (geometry.vertexCount == 0)
+            continue; // Objeto adiado pelo --lazy (só a caixa do BOUNDS, ainda sem geometria)
+
+        // Permutação do material (compilada em segundo plano na primeira vez que
+        // aparece; até lá o objeto é desenhado com a variante simples)
+        uint32_t features = materialShaderFeatures(geometry) | (deferredFrame ? SHADER_GBUFFER : 0u);
+        objectPrograms[i] = &shaderPermutations.getOrFallback(ShaderPermutations::withLightCount(features, (uint32_t)frameLights.size()));
+        GLuint programID = objectPrograms[i]->id;
+
+        bool expensive = snapshot.occlusionQueries && geometry.vertexCount >= occlusionQueryMinVertices;
+        glm::vec3 center = glm::vec3(objects[i].model * glm::vec4((geometry.boundsMin + geometry.boundsMax) * 0.5f, 1.0f));
+        float depth = glm::length(center - renderCamera.position) / farPlane;
+
+        uint64_t key = RenderQueue::makeKey(expensive ? RenderQueue::LAYER_OCCLUSION_TESTED : RenderQueue::LAYER_DEFAULT,
+                                            false, programID, geometry.textureID, geometry.VAO, depth);
+        renderQueue.push(key, { (uint32_t)i, programID, geometry.textureID, geometry.VAO });
+    }
+    renderQueue.sort();
+
+    // Caixas envolventes das occlusion queries entram no SSBO depois dos objetos
+    vector<GLint>& boxObjectIndex = frameBoxObjectIndex;
+    boxObjectIndex.assign(objects.size(), -1);
+    for (const auto& item : renderQueue.getItems())
+    {
+        if (item.key >> 60 != RenderQueue::LAYER_OCCLUSION_TESTED)
+            continue;
+        const DrawCommand& cmd = renderQueue.getCommand(item);
+        const SnapshotObject& obj = objects[cmd.objectIndex];
+        glm::vec3 extent = glm::max(obj.geometry->boundsMax - obj.geometry->boundsMin, glm::vec3(1e-4f));
+        glm::mat4 boxModel = glm::scale(glm::translate(obj.model, obj.geometry->boundsMin), extent);
+        boxObjectIndex[cmd.objectIndex] = (GLint)frameObjectData.size();
+        frameObjectData.push_back(makeObjectUniforms(boxModel));
+    }
+
+    // Pontos de controle da trajetória também
+    GLint trajectoryObjectIndex = (GLint)frameObjectData.size();
+    for (const auto& point : snapshot.controlPoints)
+    {
+        frameObjectData.push_back(makeObjectUniforms(glm::translate(glm::mat4(1.0f), point)));
+    }
+
+    // Região do frame no buffer de streaming: só espera a GPU se ela estiver mais de
+    // dois frames atrasada. Depois disso o upload é só memcpy
+    {
+        CG_TRACE_SCOPE("upload do frame");
+        frameStream.beginFrame(glState, frameStream.alignedSize(sizeof(FrameUniforms)) +
+                                        frameStream.alignedSize(frameObjectData.size() * sizeof(ObjectUniforms)) +
+                                        lightClusterer.getStreamSize(frameStream));
+        uploadFrameBuffers(frameData, frameObjectData);
+        lightClusterer.upload(glState, frameStream);
+        frameStream.flush(glState);
+    }
+
+    // Execução da fila: o cache de estado descarta os binds que não mudam nada.
+    // No deferred a fila é desenhada no G-buffer
+    int objectsScope = gpuProfiler.beginScope(deferredFrame ? "objetos (G-buffer)" : "objetos");
+    if (deferredFrame)
+    {
+        deferredRenderer.beginGeometryPass(glState);
+    }
+
+    PerfCounters::Scope drawPerfScope("desenho dos objetos", renderQueue.getItems().size());
+    for (const auto& item : renderQueue.getItems())
+    {
+        const DrawCommand& cmd = renderQueue.getCommand(item);
+        const Geometry& geometry = *objects[cmd.objectIndex].geometry;
+        const glm::mat4& model = objects[cmd.objectIndex].model;
+        const SceneProgram& program = *objectPrograms[cmd.objectIndex];
+
+        glState.useProgram(cmd.program);
+        glState.uniform1i(program.texBuffer, 0);
+        applyMaterialUniforms(program, geometry.material);
+        if (program.features & SHADER_TEXTURED)
+        {
+            glState.bindTextureUnit(0, GL_TEXTURE_2D, cmd.texture);
+        }
+
+        auto drawObject = [&]() {
+            glState.uniform1i(program.objectIndex, (GLint)cmd.objectIndex);
+            glState.bindVertexArray(cmd.vao);
+            glDrawArrays(GL_TRIANGLES, 0, geometry.vertexCount);
+        };
+
+        if (item.key >> 60 != RenderQueue::LAYER_OCCLUSION_TESTED)
+        {
+            drawObject();
+            continue;
+        }
+
+        // Câmera dentro da caixa (com folga do plano near) invalida a query
+        glm::vec3 localCamera = glm::vec3(glm::inverse(model) * glm::vec4(renderCamera.position, 1.0f));
+        float minScale = std::min(glm::length(glm::vec3(model[0])),
+                         std::min(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        glm::vec3 margin(0.1f / std::max(minScale, 1e-4f));
+        bool cameraInside = glm::all(glm::greaterThanEqual(localCamera, geometry.boundsMin - margin)) &&
+                            glm::all(glm::lessThanEqual(localCamera, geometry.boundsMax + margin));
+
+        occlusionQueries.drawObject(glState, cmd.objectIndex, program.objectIndex, boxObjectIndex[cmd.objectIndex], cameraInside, drawObject);
+    }
+    gpuProfiler.endScope(objectsScope);
+
+    // Passo de iluminação: cada pixel sombreado uma vez; a profundidade volta para o
+    // framebuffer de saída para os desenhos forward seguintes
+    if (deferredFrame)
+    {
+        GpuProfiler::Scope lightingScope(gpuProfiler, "iluminacao deferred");
+        deferredRenderer.lightingPass(glState, glm::inverse(projection * view), targetFramebuffer);
+    }
+
+    // Renderização dos pontos de controle da trajetória
+    if (!snapshot.controlPoints.empty())
+    {
+        GpuProfiler::Scope pointsScope(gpuProfiler, "pontos de trajetoria");
+        renderTrajectoryPoints(snapshot.controlPoints, shaderPermutations.get(SHADER_VERTEX_COLOR), trajectoryObjectIndex);
+    }
+
+    // Overlay com as médias de GPU (por cima de tudo, no framebuffer de saída)
+    if (snapshot.gpuOverlay)
+    {
+        GpuProfiler::Scope overlayScope(gpuProfiler, "overlay");
+        drawGpuOverlay(width, height, snapshot.frameDelta);
+    }
+    gpuProfiler.endScope(frameScope);
+    gpuProfiler.endFrame();
+
+    // Fecha as contagens de chamadas GL deste frame (se instaladas)
+    glCallStats.endFrame();
+    if (metricsServer.isRunning())
+    {
+        publishRenderMetrics(snapshot);
+    }
+
+    // Fence da região: ela só volta a ser escrita quando a GPU terminar estes desenhos
+    frameStream.endFrame();
+
+    if (!startupTimeline.isFinished())
+    {
+        startupTimeline.finish("primeiro frame");
+        printStartupTimeline();
+    }
+}
+
+// Libera os recursos da cena e mostra as estatísticas finais
+void shutdownScene()
+{
+    // Limpeza
+    printFrameTimeStats();
+    printRenderThreadStats();
+    if (occlusionCuller->getTotalFrames() > 0)
+    {
+        cout << "Culling de oclusão: média de " << occlusionCuller->getAverageCulled() << " objetos ocultos por frame em "
+             << occlusionCuller->getAverageCullTimeMs() << " ms" << endl;
+    }
+    delete occlusionCuller;
+    if (occlusionQueries.getStats().frames > 0)
+    {
+        printOcclusionQueryStats();
+    }
+    occlusionQueries.destroy();
+    frameStream.destroy(glState);
+    deferredRenderer.destroy();
+    inputLatency.report(cout, lateLatchEnabled);
+    inputLatency.destroy();
+    printGpuProfilerStats();
+    printGLCallStats();
+    PerfCounters::instance().report(cout);
+    AllocationTracker::report(cout);
+    metricsServer.stop();
+    gpuProfiler.destroy();
+    textOverlay.destroy();
+    const auto& permutationStats = shaderPermutations.getStats();
+    if (permutationStats.stalledFrames > 0)
+    {
+        cout << "Shaders: " << permutationStats.stalledFrames << " frames teriam travado esperando compilação ("
+             << permutationStats.fallbackDraws << " desenhos com a variante simples)" << endl;
+    }
+    shaderPermutations.destroy();
+    programCompiler.shutdown();
+    for (auto& obj : sceneObjects)
+    {
+        glDeleteVertexArrays(1, &obj.geometry.VAO);
+    }
+}
+
+// Modo --headless: renderiza options.frames frames num FBO, num contexto EGL sem
+// janela, com passo de tempo fixo, e grava PNGs em options.outputDir
+int runHeadless(const AppOptions& options)
+{
+#ifdef CG_HAVE_EGL
+    HeadlessContext context;
+    if (!context.create())
+    {
+        return -1;
+    }
+    glLoader = (GLADloadproc)HeadlessContext::getProcAddress;
+    if (!gladLoadGLLoader(glLoader)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        context.destroy();
+        return -1;
+    }
+    installGLCallStats(options);
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+    std::cout << "OpenGL version supported: " << glGetString(GL_VERSION) << std::endl;
+
+    // Sem janela não há contexto extra para compilar em segundo plano; e as imagens
+    // não podem sair com a variante simples dos shaders
+    initScene(options.width, options.height, nullptr);
+    shaderPermutations.setWaitForPrograms(true);
+    if (!traceStartupPath.empty())
+    {
+        finishTraceCapture(traceStartupPath);
+    }
+
+    OffscreenTarget target;
+    bool targetReady = target.init(options.width, options.height);
+    glState.invalidate(); // init() vincula o FBO por fora do cache
+    if (!targetReady)
+    {
+        shutdownScene();
+        context.destroy();
+        return -1;
+    }
+
+    // As trajetórias da configuração rodam desde o primeiro frame
+    for (auto& obj : sceneObjects)
+    {
+        obj.trajectory.start();
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(options.outputDir, error);
+
+    int saved = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < options.frames; ++frame)
+    {
+        updateTraceCapture(frame);
+        CG_TRACE_SCOPE("frame");
+        auto frameStart = std::chrono::steady_clock::now();
+        int steps = simulation.advance(options.frameTime);
+        for (int i = 0; i < steps; ++i)
+        {
+            updateScene((float)simulation.getStep(), nullptr);
+        }
+        loadVisibleObjects((float)simulation.getRenderTime(), simulation.getAlpha());
+        buildSnapshot(singleThreadSnapshot, (float)simulation.getRenderTime(), simulation.getAlpha(), options.frameTime);
+        renderFrame(singleThreadSnapshot, options.width, options.height, target.getFramebuffer());
+
+        if (options.saveEvery > 0 && frame % options.saveEvery == 0)
+        {
+            CG_TRACE_SCOPE("PNG");
+            char name[32];
+            snprintf(name, sizeof(name), "frame_%05d.png", frame);
+            string path = (std::filesystem::path(options.outputDir) / name).string();
+            if (target.savePNG(glState, path))
+                saved++;
+            else
+                cout << "ERROR::HEADLESS::PNG_WRITE_FAILED " << path << endl;
+        }
+        frameTimeStats.add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+    }
+    finishTraceCapture(traceOutputPath);
+    glFinish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cout << "Headless: " << options.frames << " frames " << options.width << "x" << options.height << " em "
+         << seconds << " s (" << seconds * 1000.0 / options.frames << " ms/frame), "
+         << saved << " imagens em " << options.outputDir << endl;
+
+    target.destroy();
+    shutdownScene();
+    context.destroy();
+    return 0;
+#else
+    (void)options;
+    cout << "ERROR::HEADLESS::EGL_UNAVAILABLE: compile com EGL (OpenGL::EGL no CMake) para usar --headless" << endl;
+    return -1;
+#endif
+}
+
+// Modo --benchmark: a câmera percorre uma trajetória com passo de simulação fixo, sem
+// vsync nem input, e os tempos dos frames medidos (depois do aquecimento) vão para um
+// JSON. Tudo roda numa thread só para separar o tempo de CPU (simulação + submissão)
+// do tempo de GPU (escopo "frame" do profiler)
+int runBenchmark(const AppOptions& options)
+{
+    Trajectory cameraPath;
+    if (!cameraPath.loadFromFile(options.benchmarkCameraPath) || cameraPath.getPointCount() < 2)
+    {
+        cout << "ERROR::BENCHMARK::CAMERA_PATH_LOAD_FAILED " << options.benchmarkCameraPath << endl;
+        return -1;
+    }
+
+    // A câmera olha para o centro dos pontos de controle (trajetórias em volta da cena)
+    glm::vec3 pathCenter(0.0f);
+    for (const auto& point : cameraPath.getControlPoints())
+    {
+        pathCenter += point.position;
+    }
+    pathCenter /= (float)cameraPath.getPointCount();
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(options.width, options.height, "Ola 3D -- benchmark", nullptr, nullptr);
+    if (!window)
+    {
+        cout << "ERROR::BENCHMARK::WINDOW_CREATION_FAILED" << endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0); // Sem vsync: o frame dura o que CPU e GPU levarem
+
+    glLoader = (GLADloadproc)glfwGetProcAddress;
+    if (!gladLoadGLLoader(glLoader)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    installGLCallStats(options);
+    string renderer = (const char*)glGetString(GL_RENDERER);
+    std::cout << "Renderer: " << renderer << std::endl;
+    std::cout << "OpenGL version supported: " << glGetString(GL_VERSION) << std::endl;
+
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+
+    // Sem contexto extra de compilação e sem a variante simples dos shaders: os frames
+    // medidos são os mesmos em toda execução
+    initScene(width, height, nullptr);
+    shaderPermutations.setWaitForPrograms(true);
+    if (!traceStartupPath.empty())
+    {
+        finishTraceCapture(traceStartupPath);
+    }
+
+    for (auto& obj : sceneObjects)
+    {
+        obj.trajectory.start();
+    }
+    cameraPath.start();
+
+    FrameTimeStats frameStats((size_t)options.frames), cpuStats((size_t)options.frames), gpuStats((size_t)options.frames);
+    uint64_t gpuSamplesSeen = 0;
+    int totalFrames = options.warmupFrames + options.frames;
+    // O tempo de GPU lido num frame é o de FRAME_LATENCY frames antes: as leituras começam
+    // FRAME_LATENCY frames depois do aquecimento e continuam FRAME_LATENCY frames depois do
+    // último medido, para cobrir os mesmos frames que os tempos de CPU
+    int gpuFirstFrame = options.warmupFrames + GpuProfiler::FRAME_LATENCY;
+    int loopFrames = totalFrames + GpuProfiler::FRAME_LATENCY;
+    cout << "Benchmark: " << options.warmupFrames << " frames de aquecimento + " << options.frames << " medidos, "
+         << options.frameTime * 1000.0f << " ms de tempo por frame, passo de simulação de " << simulation.getStep() * 1000.0 << " ms" << endl;
+
+    if (allocationStrictFrame >= 0)
+    {
+        allocationStrictFrame = options.warmupFrames;
+    }
+    for (int frame = 0; frame < loopFrames && !glfwWindowShouldClose(window); ++frame)
+    {
+        updateAllocationStrict(frame);
+        updateTraceCapture(frame);
+        CG_TRACE_SCOPE("frame");
+        auto frameStart = std::chrono::steady_clock::now();
+
+        // Eventos só para a janela continuar respondendo; o input não é tratado
+        glfwPollEvents();
+
+        int steps = simulation.advance(options.frameTime);
+        for (int i = 0; i < steps; ++i)
+        {
+            updateScene((float)simulation.getStep(), nullptr);
+            cameraPath.update((float)simulation.getStep());
+            camera.position = cameraPath.getCurrentPosition();
+            glm::vec3 toCenter = pathCenter - camera.position;
+            if (glm::length(toCenter) > 1e-4f)
+            {
+                toCenter = glm::normalize(toCenter);
+                camera.yaw = glm::degrees(atan2(toCenter.z, toCenter.x));
+                camera.pitch = glm::degrees(asin(glm::clamp(toCenter.y, -1.0f, 1.0f)));
+                camera.updateCameraVectors();
+            }
+        }
+        loadVisibleObjects((float)simulation.getRenderTime(), simulation.getAlpha());
+        buildSnapshot(singleThreadSnapshot, (float)simulation.getRenderTime(), simulation.getAlpha(), options.frameTime);
+        renderFrame(singleThreadSnapshot, width, height, 0);
+        double cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+
+        glfwSwapBuffers(window);
+        double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+
+        // Tempo de GPU do escopo "frame" lido neste frame (de FRAME_LATENCY frames atrás)
+        const GpuProfiler::ScopeStats* gpuFrame = nullptr;
+        for (const auto& scope : gpuProfiler.getScopes())
+        {
+            if (scope.depth == 0 && scope.name == "frame")
+                gpuFrame = &scope;
+        }
+        bool newGpuSample = gpuFrame && gpuFrame->samples > gpuSamplesSeen;
+        if (gpuFrame)
+            gpuSamplesSeen = gpuFrame->samples;
+
+        if (newGpuSample && frame >= gpuFirstFrame)
+            gpuStats.add(gpuFrame->lastMs);
+        if (frame < options.warmupFrames || frame >= totalFrames)
+            continue;
+        frameStats.add(frameMs);
+        cpuStats.add(cpuMs);
+    }
+    finishTraceCapture(traceOutputPath);
+    glFinish();
+
+    auto frameResult = frameStats.compute();
+    auto cpuResult = cpuStats.compute();
+    auto gpuResult = gpuStats.compute();
+    cout << "Benchmark (" << frameResult.samples << " frames): média " << frameResult.averageMs << " ms, p50 "
+         << frameResult.p50 << ", p95 " << frameResult.p95 << ", p99 " << frameResult.p99 << ", mín. "
+         << frameResult.minMs << ", máx. " << frameResult.maxMs << " ms; CPU " << cpuResult.averageMs << " ms, GPU "
+         << gpuResult.averageMs << " ms (" << gpuResult.samples << " leituras)" << endl;
+
+    if (writeBenchmarkJson(options, renderer, width, height, frameResult, cpuResult, gpuResult))
+        cout << "Resultado do benchmark gravado em " << options.benchmarkOutputPath << endl;
+    else
+        cout << "ERROR::BENCHMARK::JSON_WRITE_FAILED " << options.benchmarkOutputPath << endl;
+
+    shutdownScene();
+    glfwTerminate();
+    return frameResult.samples == (size_t)options.frames ? 0 : -1;
+}
+
+// Modo --simulate: só as trajetórias, sem janela nem GL. As trajetórias da cena (ou um
+// círculo de 8 pontos, se a cena não tiver nenhuma) são replicadas até simulateCount
+// objetos, deslocados numa grade, e avançam simulateTicks passos fixos (--sim-hz) o mais
+// rápido possível. Cada thread cuida de uma faixa contígua dos objetos do início ao fim,
+// sem sincronizar a cada passo (os objetos não dependem uns dos outros)
+int runSimulation(const AppOptions& options)
+{
+    CG_TRACE_FUNCTION();
+    SceneConfig config = loadSceneConfig(options.scenePath);
+
+    vector<Trajectory> templates;
+    for (const auto& objConfig : config.objects)
+    {
+        if (!objConfig.hasTrajectory || objConfig.trajectoryPoints.size() < 2)
+            continue;
+        Trajectory trajectory;
+        for (size_t i = 0; i < objConfig.trajectoryPoints.size(); ++i)
+        {
+            float time = (i < objConfig.trajectoryTimes.size()) ? objConfig.trajectoryTimes[i] : 2.0f;
+            trajectory.addControlPoint(objConfig.trajectoryPoints[i], time);
+        }
+        templates.push_back(trajectory);
+    }
+    if (templates.empty())
+    {
+        Trajectory circle;
+        for (int i = 0; i < 8; ++i)
+        {
+            float angle = (2.0f * M_PI * i) / 8;
+            circle.addControlPoint(glm::vec3(3.0f * cos(angle), 0.0f, 3.0f * sin(angle)), 1.0f);
+        }
+        templates.push_back(circle);
+    }
+
+    size_t count = options.simulateCount;
+    auto setupStart = std::chrono::steady_clock::now();
+    vector<Trajectory> trajectories(count);
+    vector<glm::vec3> positions(count);
+    size_t gridSide = max<size_t>(1, (size_t)ceil(sqrt((double)count)));
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::vec3 offset((float)(i % gridSide) * 10.0f, 0.0f, (float)(i / gridSide) * 10.0f);
+        for (const auto& point : templates[i % templates.size()].getControlPoints())
+        {
+            trajectories[i].addControlPoint(point.position + offset, point.time);
+        }
+        trajectories[i].start();
+    }
+    double setupSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - setupStart).count();
+
+    // Amostras para validação: até 1024 objetos espaçados igualmente, a cada simulateDumpEvery ticks
+    bool dumping = !options.simulateDumpPath.empty();
+    size_t sampleStride = max<size_t>(1, count / 1024);
+    size_t sampleCount = (count + sampleStride - 1) / sampleStride;
+    int dumpCount = dumping ? options.simulateTicks / options.simulateDumpEvery : 0;
+    vector<glm::vec3> samples((size_t)dumpCount * sampleCount);
+
+    int threadCount = options.simulateThreads > 0 ? options.simulateThreads : (int)max(1u, std::thread::hardware_concurrency());
+    threadCount = (int)min<size_t>((size_t)threadCount, count);
+    float step = (float)simulation.getStep();
+    cout << "Simulação: " << count << " objetos (" << templates.size() << " trajetórias modelo, preparadas em "
+         << setupSeconds << " s), " << options.simulateTicks << " ticks de " << step * 1000.0f << " ms, "
+         << threadCount << " threads" << endl;
+
+    auto simulateRange = [&](size_t begin, size_t end) {
+        CG_TRACE_SCOPE("simulação");
+        PerfCounters::Scope perfScope("simulação", (uint64_t)(end - begin) * options.simulateTicks);
+        AllocationTracker::Scope allocationScope(AllocationTracker::FRAME_LOOP);
+        size_t firstSample = (begin + sampleStride - 1) / sampleStride;
+        for (int tick = 0; tick < options.simulateTicks; ++tick)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                trajectories[i].update(step);
+                positions[i] = trajectories[i].getCurrentPosition();
+            }
+            if (dumping && (tick + 1) % options.simulateDumpEvery == 0)
+            {
+                size_t dump = (size_t)(tick + 1) / options.simulateDumpEvery - 1;
+                for (size_t s = firstSample; s < sampleCount && s * sampleStride < end; ++s)
+                {
+                    samples[dump * sampleCount + s] = positions[s * sampleStride];
+                }
+            }
+        }
+    };
+
+    // Passos sem alocação: o modo estrito vale desde o primeiro tick
+    if (options.allocStrict && AllocationTracker::compiledIn())
+    {
+        AllocationTracker::setStrict(true);
+    }
+    auto start = std::chrono::steady_clock::now();
+    vector<std::thread> workers;
+    for (int t = 1; t < threadCount; ++t)
+    {
+        workers.emplace_back(simulateRange, count * t / threadCount, count * (t + 1) / threadCount);
+    }
+    simulateRange(0, count / threadCount);
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    AllocationTracker::setStrict(false);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Soma das posições finais: igual entre execuções (e entre quantidades de threads)
+    double checksum = 0.0;
+    for (const auto& position : positions)
+    {
+        checksum += (double)position.x + position.y + position.z;
+    }
+    double updates = (double)count * options.simulateTicks;
+    cout << "Simulação: " << updates << " atualizações em " << seconds << " s = " << updates / seconds / 1.0e6
+         << " milhões por segundo (" << updates / (seconds * 1000.0) << " por ms, " << seconds * 1.0e9 / updates
+         << " ns cada); checksum das posições " << checksum << endl;
+
+    if (dumping)
+    {
+        if (writeSimulationSamples(options.simulateDumpPath, samples, sampleCount, sampleStride, options.simulateDumpEvery, step, count))
+            cout << dumpCount << " amostras de " << sampleCount << " posições gravadas em " << options.simulateDumpPath << endl;
+        else
+            cout << "ERROR::SIMULATION::DUMP_WRITE_FAILED " << options.simulateDumpPath << endl;
+    }
+    PerfCounters::instance().report(cout);
+    AllocationTracker::report(cout);
+    return 0;
+}
+
+// Função de callback de teclado - só pode ter uma instância (deve ser estática se
+// estiver dentro de uma classe) - É chamada sempre que uma tecla for pressionada
+// ou solta via GLFW
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode)
+{
+    // Teclas que recriam recursos GL (H) ou leem estatísticas dos objetos da renderização
+    // param a thread de renderização enquanto são tratadas
+    bool touchesRenderer = action == GLFW_PRESS &&
+        (key == GLFW_KEY_H || key == GLFW_KEY_B || key == GLFW_KEY_J || key == GLFW_KEY_K || key == GLFW_KEY_N);
+    RenderThread<FrameSnapshot>::Pause pause(touchesRenderer ? &renderThread : nullptr);
+
+    // Modo estrito de alocações: a tecla pode ligar um caminho novo, que aloca no primeiro uso
+    if (action == GLFW_PRESS && allocationStrictFrame >= 0)
+    {
+        AllocationTracker::setStrict(false);
+        allocationStrictFrame = currentFrame + allocationWarmupFrames;
+    }
+
+    if (action == GLFW_PRESS || action == GLFW_REPEAT)
+    {
+        if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+		glfwSetWindowShouldClose(window, GL_TRUE);
+
+		if (key == GLFW_KEY_X && action == GLFW_PRESS)
+		{
+			rotateX = true;
+			rotateY = false;
+			rotateZ = false;
+		}
+
+		if (key == GLFW_KEY_Y && action == GLFW_PRESS)
+		{
+			rotateX = false;
+			rotateY = true;
+			rotateZ = false;
+		}
+
+		if (key == GLFW_KEY_Z && action == GLFW_PRESS)
+		{
+			rotateX = false;
+			rotateY = false;
+			rotateZ = true;
 		}
 		
 		// Seleção de objetos para rotação individual
@@ -980,10 +2161,10 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 			
 			// Resetar posições dos objetos
 			if (sceneObjects.size() >= 1) {
-				sceneObjects[0].position = suzanneInitialPosition; // Suzanne
+				sceneObjects[0].position = sceneObjects[0].previousPosition = suzanneInitialPosition; // Suzanne
 			}
 			if (sceneObjects.size() >= 2) {
-				sceneObjects[1].position = cubeInitialPosition; // WallCorner
+				sceneObjects[1].position = sceneObjects[1].previousPosition = cubeInitialPosition; // WallCorner
 			}
 			
 			// Parar todas as trajetórias
@@ -1002,34 +2183,15 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 			sceneObjects.clear();
 			
 			// Recarregar configuração
-			SceneConfig newConfig = loadSceneConfig("scene_config.txt");
+			SceneConfig newConfig = loadSceneConfig(sceneConfigPath);
 			
-			// Recriar objetos
-			for (const auto& objConfig : newConfig.objects) {
-				SceneObject obj(objConfig.name);
-				
-				if (objConfig.objFilePath.find(".obj") != string::npos) {
-					obj.geometry = setupGeometryFromFile(objConfig.objFilePath.c_str());
-				} else {
-					obj.geometry = createThreeWallCornerGeometry(objConfig.texturePath);
-				}
-				
-				obj.position = objConfig.position;
-				obj.rotation = objConfig.rotation;
-				obj.scale = objConfig.scale;
-				
-				if (objConfig.hasTrajectory) {
-					for (size_t i = 0; i < objConfig.trajectoryPoints.size(); ++i) {
-						float time = (i < objConfig.trajectoryTimes.size()) ? objConfig.trajectoryTimes[i] : 2.0f;
-						obj.trajectory.addControlPoint(objConfig.trajectoryPoints[i], time);
-					}
-				}
-				
-				sceneObjects.push_back(obj);
-			}
+			// Recriar objetos (com --lazy, os fora do campo de visão ficam adiados)
+			createSceneObjects(newConfig);
 			
-			// Atualizar configuração global
-			sceneConfig = newConfig;
+			// Atualizar configuração global (sem copiar listas de objetos e luzes)
+			sceneConfig = std::move(newConfig);
+			occlusionQueries.reset(sceneObjects.size());
+			glState.invalidate();
 			
 			cout << "Configuração de cena recarregada!" << endl;
 		}
@@ -1120,6 +2282,143 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 			cout << "Objeto selecionado: " << sceneObjects[selectedObjectIndex].name << endl;
 		}
 		
+		if (key == GLFW_KEY_K && action == GLFW_PRESS)
+		{
+			// Liga/desliga o culling de oclusão por CPU
+			occlusionCullingEnabled = !occlusionCullingEnabled;
+			cout << "Culling de oclusão: " << (occlusionCullingEnabled ? "ATIVADO" : "DESATIVADO") << endl;
+			if (occlusionCuller && occlusionCuller->getTotalFrames() > 0)
+			{
+				cout << "Último frame: " << occlusionCuller->getLastCulledCount() << " objetos ocultos em "
+					 << occlusionCuller->getLastCullTimeMs() << " ms (média " << occlusionCuller->getAverageCulled()
+					 << " objetos, " << occlusionCuller->getAverageCullTimeMs() << " ms)" << endl;
+			}
+		}
+		
+		if (key == GLFW_KEY_J && action == GLFW_PRESS)
+		{
+			// Liga/desliga as occlusion queries por GPU
+			occlusionQueriesEnabled = !occlusionQueriesEnabled;
+			cout << "Occlusion queries: " << (occlusionQueriesEnabled ? "ATIVADAS" : "DESATIVADAS") << endl;
+			printOcclusionQueryStats();
+		}
+		
+		if (key == GLFW_KEY_U && action == GLFW_PRESS)
+		{
+			// Alterna o limite de FPS e mostra os tempos de frame com o limite anterior
+			printFrameTimeStats();
+			const double limits[4] = { 0.0, 30.0, 60.0, 144.0 };
+			int current = 0;
+			for (int l = 0; l < 4; ++l)
+			{
+				if (framePacer.getTargetFps() == limits[l])
+					current = l;
+			}
+			framePacer.setTargetFps(limits[(current + 1) % 4]);
+			if (framePacer.getTargetFps() > 0.0)
+				cout << "Limite de FPS: " << framePacer.getTargetFps() << endl;
+			else
+				cout << "Limite de FPS: desligado" << endl;
+		}
+		
+		if (key == GLFW_KEY_N && action == GLFW_PRESS)
+		{
+			// Alterna forward/deferred e compara o tempo médio de frame de cada caminho
+			if (!deferredAvailable)
+			{
+				cout << "Renderização deferred indisponível (G-buffer incompleto)" << endl;
+			}
+			else
+			{
+				deferredEnabled = !deferredEnabled;
+				cout << "Renderização: " << (deferredEnabled ? "DEFERRED" : "FORWARD") << endl;
+			}
+			const char* pathNames[2] = { "Forward", "Deferred" };
+			for (int p = 0; p < 2; ++p)
+			{
+				if (pathFrames[p] > 0)
+				{
+					cout << pathNames[p] << ": " << pathFrames[p] << " frames, média de "
+						 << pathFrameTime[p] * 1000.0 / pathFrames[p] << " ms por frame" << endl;
+				}
+			}
+		}
+		
+		if (key == GLFW_KEY_B && action == GLFW_PRESS)
+		{
+			// Estatísticas da fila de renderização
+			const auto& stats = renderQueue.getStats();
+			cout << "=== Fila de renderização ===" << endl;
+			cout << "Último frame: " << stats.lastDraws << " desenhos, trocas de estado: "
+				 << stats.lastStateChangesUnsorted << " sem ordenação, " << stats.lastStateChangesSorted << " ordenado" << endl;
+			if (stats.frames > 0)
+			{
+				cout << "Média por frame: " << (double)stats.draws / stats.frames << " desenhos, trocas de estado: "
+					 << (double)stats.stateChangesUnsorted / stats.frames << " sem ordenação, "
+					 << (double)stats.stateChangesSorted / stats.frames << " ordenado" << endl;
+			}
+			cout << "Cache de estado GL: " << glState.totalIssued() << " chamadas emitidas, "
+				 << glState.totalElided() << " descartadas" << endl;
+			const auto& counters = glState.getCounters();
+			for (int c = 0; c < GLStateCache::CALL_COUNT; ++c)
+			{
+				if (counters.issued[c] + counters.elided[c] > 0)
+				{
+					cout << "  " << GLStateCache::callName(c) << ": " << counters.issued[c] << " emitidas, "
+						 << counters.elided[c] << " descartadas" << endl;
+				}
+			}
+			const auto& permutationStats = shaderPermutations.getStats();
+			const auto& compileStats = programCompiler.getStats();
+			cout << "Permutações de shader: " << shaderPermutations.getProgramCount() << " programas ("
+				 << permutationStats.pending << " compilando), " << permutationStats.compileMs
+				 << " ms de bloqueio na thread principal" << endl;
+			cout << "  Compilação " << AsyncProgramCompiler::modeName(programCompiler.getMode()) << ": "
+				 << compileStats.cacheHits << " do cache, " << compileStats.failed << " falhas, latência média "
+				 << (compileStats.submitted > 0 ? compileStats.totalLatencyMs / compileStats.submitted : 0.0)
+				 << " ms, máx. " << compileStats.maxLatencyMs << " ms" << endl;
+			cout << "  Frames que teriam travado: " << permutationStats.stalledFrames << " ("
+				 << permutationStats.fallbackDraws << " desenhos com a variante simples)" << endl;
+			printFrameTimeStats();
+			printRenderThreadStats();
+			inputLatency.report(cout, lateLatchEnabled);
+			printGpuProfilerStats();
+			printGLCallStats();
+			PerfCounters::instance().report(cout);
+			AllocationTracker::report(cout);
+			const auto& streamStats = frameStream.getStats();
+			cout << "Buffer de streaming: " << streamStats.lastFrameBytes / 1024.0 << " KB no último frame, "
+				 << streamStats.stalledFrames << " de " << streamStats.frames << " frames esperaram a GPU ("
+				 << streamStats.stallMs << " ms no total, máx. " << streamStats.maxStallMs << " ms), "
+				 << streamStats.reallocations << " realocações" << endl;
+			cout << "Luzes: " << lightClusterer.getLightCount() << " em " << LightClusterer::CLUSTER_COUNT << " clusters, "
+				 << lightClusterer.getAssignmentCount() << " atribuições, máx. "
+				 << lightClusterer.getMaxLightsPerCluster() << " luzes num cluster" << endl;
+			cout << "============================" << endl;
+		}
+		
+		if (key == GLFW_KEY_E && action == GLFW_PRESS)
+		{
+			// Grava um trace de CPU dos próximos 120 frames
+			if (!CpuTracer::compiledIn())
+			{
+				cout << "Tracer de CPU indisponível: configure com -DCG_ENABLE_TRACING=ON" << endl;
+			}
+			else if (!CpuTracer::instance().isCapturing())
+			{
+				traceFirstFrame = currentFrame + 1;
+				traceLastFrame = traceFirstFrame + 119;
+				traceOutputPath = "trace_frame_" + std::to_string(traceFirstFrame) + ".json";
+			}
+		}
+		
+		if (key == GLFW_KEY_M && action == GLFW_PRESS)
+		{
+			// Mostra/esconde o overlay com os tempos de GPU por passo
+			gpuOverlayEnabled = !gpuOverlayEnabled;
+			cout << "Overlay do profiler de GPU: " << (gpuOverlayEnabled ? "ATIVADO" : "DESATIVADO") << endl;
+		}
+		
 		if (key == GLFW_KEY_V && action == GLFW_PRESS)
 		{
 			// Mostra/esconde pontos de trajetória
@@ -1214,6 +2513,22 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
     lastY = ypos;
 
     camera.processMouseMovement(xoffset, yoffset);
+    inputLatency.noteInput(camera.yaw, camera.pitch);
+}
+
+// Late latch: orientação do último evento de mouse, lida no início do desenho. Devolve o
+// instante do evento mais antigo ainda não mostrado (0 = nenhum)
+int64_t latchCameraOrientation(FirstPersonCamera& renderCamera)
+{
+    int64_t inputTime = inputLatency.takeInput(); // Antes da orientação: ela já inclui esse evento
+    float yaw, pitch;
+    if (inputLatency.latestOrientation(yaw, pitch))
+    {
+        renderCamera.yaw = yaw;
+        renderCamera.pitch = pitch;
+        renderCamera.updateCameraVectors();
+    }
+    return inputTime;
 }
 
 // Função de callback para clique do mouse
@@ -1246,52 +2561,43 @@ void processInput(GLFWwindow* window)
         camera.processKeyboard("DOWN", deltaTime);
 }
 
-// Esta função está basntante hardcoded - objetivo é compilar e "buildar" um programa de
-// shader simples e único neste exemplo de código
+// Esta função registra as fontes das permutações de shader da cena
 // O código fonte do vertex e fragment shader está nos arrays vertexShaderSource e
-// fragmentShader source no iniçio deste arquivo
-// A função retorna o identificador do programa de shader
+// fragmentShaderSource (e gBufferFragmentSource) no iniçio deste arquivo
+// A função retorna o identificador do programa dos pontos de controle
 int setupShader()
 {
-	// Vertex shader
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-	// Checando erros de compilação (exibição via log no terminal)
-	GLint success;
-	GLchar infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-	// Fragment shader
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-	// Checando erros de compilação (exibição via log no terminal)
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-	// Linkando os shaders e criando o identificador do programa de shader
-	GLuint shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-	// Checando por erros de linkagem
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-	if (!success) {
-		glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-	}
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+	shaderPermutations.init({ octahedralSource, vertexShaderSource },
+	                        { fragmentShaderHeader, frameDataBlockSource, LightClusterer::glslDeclarations(), fragmentShaderSource },
+	                        { fragmentShaderHeader, octahedralSource, gBufferFragmentSource },
+	                        programCompiler);
+
+	// As permutações dos materiais são compiladas em segundo plano quando aparecem pela
+	// primeira vez; aqui, esperando, só as variantes simples que as substituem enquanto
+	// isso e a dos pontos de controle (cor do vértice, sem iluminação)
+	shaderPermutations.prepareFallbacks();
+	return shaderPermutations.get(SHADER_VERTEX_COLOR).id;
+}
+
+// Programa do passo de iluminação do deferred
+GLuint setupDeferredLightingShader()
+{
+	const GLchar* lightingParts[5] = { lightingFragmentHeader, frameDataBlockSource, LightClusterer::glslDeclarations(),
+	                                   octahedralSource, lightingFragmentSource };
+	return compileProgram(1, &lightingVertexSource, 5, lightingParts);
+}
+
+// Programa do overlay de texto (profiler de GPU)
+GLuint setupOverlayShader()
+{
+	return compileProgram(1, &overlayVertexSource, 1, &overlayFragmentSource);
+}
 
-	return shaderProgram;
+// Compila e linka um programa a partir de fontes divididas em partes (concatenadas pelo
+// GL), esperando o resultado. Usa o binário em cache para as mesmas fontes e driver
+GLuint compileProgram(GLsizei vertexCount, const GLchar** vertexParts, GLsizei fragmentCount, const GLchar** fragmentParts)
+{
+	return programCompiler.wait(programCompiler.submit(vertexCount, vertexParts, fragmentCount, fragmentParts));
 }
 
 // Esta função está bastante harcoded - objetivo é criar os buffers que armazenam a 
@@ -1402,6 +2708,7 @@ int setupGeometry()
 // Função para carregar textura
 int loadTexture(const string& path)
 {
+    CG_TRACE_FUNCTION();
     GLuint texID;
     glGenTextures(1, &texID);
     glBindTexture(GL_TEXTURE_2D, texID);
@@ -1431,101 +2738,56 @@ int loadTexture(const string& path)
     return texID;
 }
 
-// Função para carregar arquivo OBJ
-bool loadObject(
-	const char* path,
-	std::vector<glm::vec3>& out_vertices,
-	std::vector<glm::vec2>& out_uvs,
-	std::vector<glm::vec3>& out_normals)
+// Função para configurar geometria a partir de arquivo OBJ
+Geometry setupGeometryFromFile(const char* filepath, bool keepPositions, bool quantize)
 {
-	std::ifstream file(path);
-
-	if (!file)
-	{
-			std::cerr << "Failed to open file: " << path << std::endl;
-			return false;
-	}
-
-	std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
-	std::vector<glm::vec3> temp_vertices;
-	std::vector<glm::vec2> temp_uvs;
-	std::vector<glm::vec3> temp_normals;
-
-	std::string line;
-
-	while (std::getline(file, line))
-	{
-			std::istringstream iss(line);
-			std::string type;
-			iss >> type;
+    CG_TRACE_FUNCTION();
+    std::vector<glm::vec3> vert;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
 
-			if (type == "v") 
-			{
-					glm::vec3 vertex;
-					iss >> vertex.x >> vertex.y >> vertex.z;
-					temp_vertices.push_back(vertex);
-			}
-			else if (type == "vt") 
-			{
-					glm::vec2 uv;
-					iss >> uv.x >> uv.y;
-					temp_uvs.push_back(uv);
-			}
-			else if (type == "vn") 
-			{
-					glm::vec3 normal;
-					iss >> normal.x >> normal.y >> normal.z;
-					temp_normals.push_back(normal);
-			}
-			else if (type == "f")
-			{
-					unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-					char slash;
-
-					for (int i = 0; i < 3; ++i)
-					{
-							iss >> vertexIndex[i] >> slash >> uvIndex[i] >> slash >> normalIndex[i];
-							vertexIndices.push_back(vertexIndex[i]);
-							uvIndices.push_back(uvIndex[i]);
-							normalIndices.push_back(normalIndex[i]);
-					}
-			}
-			else if (type == "mtllib")
-			{
-					iss >> mtlFilePath;
-			}
-	}
+    string mtlLibrary;
+    loadObject(filepath, vert, uvs, normals, &mtlLibrary);
 
-	for (unsigned int i = 0; i < vertexIndices.size(); ++i)
-	{
-			unsigned int vertexIndex = vertexIndices[i];
-			unsigned int uvIndex = uvIndices[i];
-			unsigned int normalIndex = normalIndices[i];
+    // Caixa envolvente em espaço de objeto
+    glm::vec3 boundsMin(0.0f), boundsMax(0.0f);
+    if (!vert.empty())
+    {
+        boundsMin = boundsMax = vert[0];
+        for (const auto& v : vert)
+        {
+            boundsMin = glm::min(boundsMin, v);
+            boundsMax = glm::max(boundsMax, v);
+        }
+    }
 
-			glm::vec3 vertex = temp_vertices[vertexIndex - 1];
-			glm::vec2 uv = temp_uvs[uvIndex - 1];
-			glm::vec3 normal = temp_normals[normalIndex - 1];
+    Geometry geom = quantize ? setupQuantizedGeometry(vert, uvs, normals, boundsMin, boundsMax)
+                             : setupFullGeometry(vert, uvs, normals);
+    geom.boundsMin = boundsMin;
+    geom.boundsMax = boundsMax;
+    if (keepPositions)
+    {
+        geom.occluderTriangles = vert;
+    }
 
-			out_vertices.push_back(vertex);
-			out_uvs.push_back(uv);
-			out_normals.push_back(normal);
-	}
+    string basePath = string(filepath).substr(0, string(filepath).find_last_of("/"));
+    string mtlPath = basePath + "/" + mtlLibrary;
+    string textureFile = loadMTL(mtlPath, geom.material);
 
-	file.close();
+    if (!textureFile.empty())
+    {
+        string fullTexturePath = basePath + "/" + textureFile;
+        geom.textureID = loadTexture(fullTexturePath);
+        geom.textureFilePath = fullTexturePath;
+    }
 
-	return true;
+    return geom;
 }
 
-// Função para configurar geometria a partir de arquivo OBJ
-Geometry setupGeometryFromFile(const char* filepath)
+// Vértices completos em float: posição, normal, cor e coordenadas de textura
+Geometry setupFullGeometry(const vector<glm::vec3>& vert, const vector<glm::vec2>& uvs, const vector<glm::vec3>& normals)
 {
     std::vector<GLfloat> vertices;
-    std::vector<glm::vec3> vert;
-    std::vector<glm::vec2> uvs;
-    std::vector<glm::vec3> normals;
-
-    loadObject(filepath, vert, uvs, normals);
-
     vertices.reserve(vert.size() * 11); // 11 componentes: pos(3) + normal(3) + cor(3) + tex(2)
     for (size_t i = 0; i < vert.size(); ++i)
     {
@@ -1571,77 +2833,91 @@ Geometry setupGeometryFromFile(const char* filepath)
     Geometry geom;
     geom.VAO = VAO;
     geom.vertexCount = vertices.size() / 11; // Corrigido para 11 componentes por vértice
-
-    string basePath = string(filepath).substr(0, string(filepath).find_last_of("/"));
-    string mtlPath = basePath + "/" + mtlFilePath;
-    string textureFile = loadMTL(mtlPath);
-
-    if (!textureFile.empty())
-    {
-        string fullTexturePath = basePath + "/" + textureFile;
-        geom.textureID = loadTexture(fullTexturePath);
-        geom.textureFilePath = fullTexturePath;
-    }
-
     return geom;
 }
 
-// Função para carregar arquivo MTL
-string loadMTL(const string& path)
+// Vértices compactados (20 bytes em vez de 44): posição snorm16 relativa à caixa
+// envolvente, normal octaédrica snorm16 e coordenadas de textura em float. Sem cor
+// por vértice; a matriz dequantize é aplicada junto com a de modelo
+Geometry setupQuantizedGeometry(const vector<glm::vec3>& vert, const vector<glm::vec2>& uvs, const vector<glm::vec3>& normals,
+                                const glm::vec3& boundsMin, const glm::vec3& boundsMax)
 {
-    ifstream mtlFile(path);
-    if (!mtlFile)
+    struct QuantizedVertex
     {
-        cerr << "Failed to open MTL file: " << path << endl;
-        return "";
-    }
+        GLshort position[4];
+        GLshort normal[2];
+        GLfloat uv[2];
+    };
 
-    string line, texturePath;
-    while (getline(mtlFile, line))
-    {
-        istringstream iss(line);
-        string keyword;
-        iss >> keyword;
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    glm::vec3 halfExtent = glm::max((boundsMax - boundsMin) * 0.5f, glm::vec3(1e-6f));
+    auto toSnorm16 = [](float v) {
+        return (GLshort)std::lround(std::min(std::max(v, -1.0f), 1.0f) * 32767.0f);
+    };
 
-        if (keyword == "map_Kd")
-        {
-            iss >> texturePath;
-        }
-        else if (keyword == "Ka")
-        {
-            iss >> ambientColor.r >> ambientColor.g >> ambientColor.b;
-        }
-        else if (keyword == "Kd")
-        {
-            iss >> diffuseColor.r >> diffuseColor.g >> diffuseColor.b;
-        }
-        else if (keyword == "Ks")
-        {
-            iss >> specularColor.r >> specularColor.g >> specularColor.b;
-        }
-        else if (keyword == "Ns")
-        {
-            iss >> shininess;
-        }
-        else if (keyword == "Ke")
+    vector<QuantizedVertex> vertices(vert.size());
+    for (size_t i = 0; i < vert.size(); ++i)
+    {
+        glm::vec3 p = (vert[i] - center) / halfExtent;
+        vertices[i].position[0] = toSnorm16(p.x);
+        vertices[i].position[1] = toSnorm16(p.y);
+        vertices[i].position[2] = toSnorm16(p.z);
+        vertices[i].position[3] = 32767;
+
+        // Normal -> octaedro (mesma codificação de decodeOctahedral no shader); sem normal ou
+        // uv para o vértice, os mesmos padrões do loadObject
+        glm::vec3 n = i < normals.size() ? normals[i] : glm::vec3(0.0f, 0.0f, 1.0f);
+        float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        glm::vec2 e = sum > 0.0f ? glm::vec2(n.x, n.y) / sum : glm::vec2(0.0f);
+        if (n.z < 0.0f)
         {
-            iss >> emissiveColor.r >> emissiveColor.g >> emissiveColor.b;
+            e = glm::vec2((1.0f - std::abs(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f),
+                          (1.0f - std::abs(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f));
         }
-    }
-    mtlFile.close();
+        vertices[i].normal[0] = toSnorm16(e.x);
+        vertices[i].normal[1] = toSnorm16(e.y);
 
-    if (texturePath.empty())
-    {
-        cerr << "No diffuse texture found in MTL file: " << path << endl;
+        glm::vec2 uv = i < uvs.size() ? uvs[i] : glm::vec2(0.0f);
+        vertices[i].uv[0] = uv.x;
+        vertices[i].uv[1] = uv.y;
     }
-    return texturePath;
+
+    GLuint VBO, VAO;
+    glGenBuffers(1, &VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(QuantizedVertex), vertices.data(), GL_STATIC_DRAW);
+
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+
+    // Atributo posição (snorm16 normalizado para [-1, 1])
+    glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(QuantizedVertex), (GLvoid*)offsetof(QuantizedVertex, position));
+    glEnableVertexAttribArray(0);
+
+    // Atributo de textura (s, t)
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(QuantizedVertex), (GLvoid*)offsetof(QuantizedVertex, uv));
+    glEnableVertexAttribArray(2);
+
+    // Atributo normal octaédrica (snorm16)
+    glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, sizeof(QuantizedVertex), (GLvoid*)offsetof(QuantizedVertex, normal));
+    glEnableVertexAttribArray(3);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    Geometry geom;
+    geom.VAO = VAO;
+    geom.vertexCount = (GLuint)vertices.size();
+    geom.quantized = true;
+    geom.dequantize = glm::scale(glm::translate(glm::mat4(1.0f), center), halfExtent);
+    return geom;
 }
 
-// Função para renderizar pontos de controle da trajetória
-void renderTrajectoryPoints(const Trajectory& trajectory, GLuint shaderID, 
-                           const glm::mat4& view, const glm::mat4& projection)
+// Função para renderizar pontos de controle da trajetória. As matrizes de modelo
+// dos pontos já estão no SSBO a partir de firstObjectIndex
+void renderTrajectoryPoints(const vector<glm::vec3>& points, const SceneProgram& program, GLint firstObjectIndex)
 {
-    if (!showTrajectoryPoints)
+    if (points.empty())
         return;
 
     // Criar geometria temporária para os pontos de controle
@@ -1649,34 +2925,17 @@ void renderTrajectoryPoints(const Trajectory& trajectory, GLuint shaderID,
     if (controlPointVAO == 0)
     {
         controlPointVAO = createControlPointGeometry();
+        glState.invalidate();
     }
 
-    // Obter localização dos uniforms
-    GLint modelLoc = glGetUniformLocation(shaderID, "model");
-    GLint viewLoc = glGetUniformLocation(shaderID, "view");
-    GLint projLoc = glGetUniformLocation(shaderID, "projection");
-
-    // Configurar matrizes
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-    // Renderizar cada ponto de controle
-    const auto& controlPoints = trajectory.getControlPoints();
-    for (size_t i = 0; i < controlPoints.size(); ++i)
-    {
-        const auto& point = controlPoints[i];
-        
-        // Criar matriz de modelo para o ponto
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, point.position);
-        // Não precisa de escala pois já é pequeno
-        
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        
-        // Renderizar o ponto (cubo vermelho simples)
-        glBindVertexArray(controlPointVAO);
+    glState.useProgram(program.id);
+    glState.bindVertexArray(controlPointVAO);
+
+    // Renderizar cada ponto de controle (cubo vermelho simples, já é pequeno)
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        glState.uniform1i(program.objectIndex, firstObjectIndex + (GLint)i);
         glDrawArrays(GL_TRIANGLES, 0, 36); // 36 vértices para um cubo
-        glBindVertexArray(0);
     }
 }
 
@@ -1768,4 +3027,532 @@ GLuint createControlPointGeometry()
     glBindVertexArray(0);
 
     return VAO;
-}
\ No newline at end of file
+}
+// Função para criar um objeto da cena a partir da sua configuração, ainda sem geometria
+// (só com a caixa do BOUNDS, se houver); loadSceneObjectGeometry carrega o modelo
+SceneObject createSceneObject(const ObjectConfig& objConfig)
+{
+    CG_TRACE_FUNCTION();
+    SceneObject obj(objConfig.name);
+    obj.geometry.VAO = 0;
+    obj.geometry.vertexCount = 0;
+    obj.geometry.boundsMin = objConfig.boundsMin;
+    obj.geometry.boundsMax = objConfig.boundsMax;
+
+    // Aplicar transformações iniciais
+    obj.position = objConfig.position;
+    obj.previousPosition = objConfig.position;
+    obj.rotation = objConfig.rotation;
+    obj.scale = objConfig.scale;
+    obj.isOccluder = objConfig.isOccluder;
+
+    // Configurar trajetória se especificada
+    if (objConfig.hasTrajectory) {
+        for (size_t i = 0; i < objConfig.trajectoryPoints.size(); ++i) {
+            float time = (i < objConfig.trajectoryTimes.size()) ? objConfig.trajectoryTimes[i] : 2.0f;
+            obj.trajectory.addControlPoint(objConfig.trajectoryPoints[i], time);
+        }
+    }
+
+    return obj;
+}
+
+// Função para carregar a geometria (OBJ, MTL, texturas e buffers) de um objeto da cena
+void loadSceneObjectGeometry(SceneObject& obj, const ObjectConfig& objConfig)
+{
+    CG_TRACE_FUNCTION();
+    AllocationTracker::Scope allocationScope(AllocationTracker::LOADING);
+
+    // Carregar geometria do arquivo OBJ
+    if (objConfig.objFilePath.find(".obj") != string::npos) {
+        obj.geometry = setupGeometryFromFile(objConfig.objFilePath.c_str(), objConfig.isOccluder, objConfig.quantize);
+    } else {
+        // Se não for OBJ, criar geometria padrão (cubo)
+        obj.geometry = createThreeWallCornerGeometry(objConfig.texturePath, objConfig.isOccluder);
+    }
+    obj.loaded = true;
+}
+
+// Função para criar os objetos de uma configuração de cena. Com --lazy, os que têm BOUNDS
+// e estão fora do frustum da câmera atual ficam sem geometria até entrarem nele
+void createSceneObjects(const SceneConfig& config)
+{
+    CG_TRACE_FUNCTION();
+    glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), viewAspect, 0.1f, farPlane) * camera.getViewMatrix();
+    pendingObjects = 0;
+    sceneObjects.reserve(config.objects.size());
+    for (size_t i = 0; i < config.objects.size(); ++i) {
+        const ObjectConfig& objConfig = config.objects[i];
+        SceneObject obj = createSceneObject(objConfig);
+        obj.configIndex = (int)i;
+        if (!lazyLoading || !objConfig.hasBounds ||
+            isPotentiallyVisible(viewProjection, buildModelMatrix(obj, 0.0f), objConfig.boundsMin, objConfig.boundsMax)) {
+            loadSceneObjectGeometry(obj, objConfig);
+            cout << "Objeto criado: " << objConfig.name << endl;
+        } else {
+            pendingObjects++;
+            cout << "Objeto adiado (fora do campo de visão): " << objConfig.name << endl;
+        }
+        sceneObjects.push_back(std::move(obj));
+    }
+}
+
+// Função para testar uma caixa em espaço de objeto contra o frustum: invisível só se os 8
+// cantos ficam do lado de fora de um mesmo plano (em coordenadas de clip, antes da divisão)
+bool isPotentiallyVisible(const glm::mat4& viewProjection, const glm::mat4& model, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    glm::mat4 toClip = viewProjection * model;
+    int outside[6] = { 0, 0, 0, 0, 0, 0 };
+    for (int c = 0; c < 8; ++c)
+    {
+        glm::vec3 corner((c & 1) ? boundsMax.x : boundsMin.x, (c & 2) ? boundsMax.y : boundsMin.y, (c & 4) ? boundsMax.z : boundsMin.z);
+        glm::vec4 clip = toClip * glm::vec4(corner, 1.0f);
+        outside[0] += clip.x < -clip.w;
+        outside[1] += clip.x > clip.w;
+        outside[2] += clip.y < -clip.w;
+        outside[3] += clip.y > clip.w;
+        outside[4] += clip.z < -clip.w;
+        outside[5] += clip.z > clip.w;
+    }
+    for (int plane = 0; plane < 6; ++plane)
+    {
+        if (outside[plane] == 8)
+            return false;
+    }
+    return true;
+}
+
+// Função para carregar os objetos adiados que entraram no frustum (mesma câmera
+// interpolada do snapshot). A thread de renderização fica parada durante a carga
+void loadVisibleObjects(float time, float alpha)
+{
+    if (pendingObjects == 0)
+        return;
+    CG_TRACE_FUNCTION();
+    FirstPersonCamera view = camera;
+    view.position = glm::mix(previousCameraPosition, camera.position, alpha);
+    glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), viewAspect, 0.1f, farPlane) * view.getViewMatrix();
+
+    std::optional<RenderThread<FrameSnapshot>::Pause> pause;
+    size_t loadedNow = 0;
+    auto loadStart = std::chrono::steady_clock::now();
+    for (auto& obj : sceneObjects)
+    {
+        if (obj.loaded || !isPotentiallyVisible(viewProjection, buildModelMatrix(obj, time, alpha), obj.geometry.boundsMin, obj.geometry.boundsMax))
+            continue;
+        if (!pause)
+            pause.emplace(renderThread.isRunning() ? &renderThread : nullptr);
+        loadSceneObjectGeometry(obj, sceneConfig.objects[obj.configIndex]);
+        loadedNow++;
+    }
+    if (loadedNow == 0)
+        return;
+
+    pendingObjects -= loadedNow;
+    glState.invalidate(); // As funções de carregamento alteram binds por fora do cache
+    cout << "Carga sob demanda: " << loadedNow << " objetos em "
+         << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count() << " ms ("
+         << pendingObjects << " ainda adiados)" << endl;
+
+    // Objetos novos podem pedir permutações de shader ainda não usadas: recomeça o aquecimento
+    if (allocationStrictFrame >= 0)
+    {
+        AllocationTracker::setStrict(false);
+        allocationStrictFrame = currentFrame + allocationWarmupFrames;
+    }
+}
+
+// Função para montar a matriz de modelo de um objeto da cena
+// (alpha interpola a posição entre o passo de simulação anterior e o atual)
+glm::mat4 buildModelMatrix(const SceneObject& obj, float angle, float alpha)
+{
+    glm::vec3 position = glm::mix(obj.previousPosition, obj.position, alpha);
+
+    // Rotação específica para o Suzanne (girar para a direita) e rotações individuais
+    // do Suzanne e do cubo
+    if (obj.name == "Suzanne") {
+        int axis = suzanneRotateX ? 0 : suzanneRotateY ? 1 : suzanneRotateZ ? 2 : -1;
+        return composeModelMatrix(position, obj.scale, 45.0f, axis, angle);
+    }
+    if (obj.name == "WallCorner") {
+        int axis = cubeRotateX ? 0 : cubeRotateY ? 1 : cubeRotateZ ? 2 : -1;
+        return composeModelMatrix(position, obj.scale, 0.0f, axis, angle);
+    }
+    return composeModelMatrix(position, obj.scale, 0.0f, -1, angle);
+}
+
+// Função para mostrar os percentis de tempo de frame (janela dos últimos frames)
+void printFrameTimeStats()
+{
+    FrameTimeStats::Percentiles p = frameTimeStats.compute();
+    if (p.samples == 0)
+        return;
+    cout << "Tempo de frame (" << p.samples << " frames, simulação a " << simulation.getRate() << " Hz, limite "
+         << (framePacer.getTargetFps() > 0.0 ? std::to_string((int)framePacer.getTargetFps()) + " FPS" : string("desligado")) << "): "
+         << "média " << p.averageMs << " ms, p50 " << p.p50 << ", p90 " << p.p90 << ", p99 " << p.p99
+         << ", p99.9 " << p.p999 << ", máx. " << p.maxMs << " ms" << endl;
+}
+
+// Função para mostrar o tempo até o primeiro frame, fase por fase
+void printStartupTimeline()
+{
+    double total = startupTimeline.getTotalMs();
+    cout << "Tempo até o primeiro frame: " << total << " ms" << endl;
+    for (const auto& phase : startupTimeline.getPhases())
+    {
+        cout << "  " << phase.name << ": " << phase.ms << " ms (" << (total > 0.0 ? 100.0 * phase.ms / total : 0.0) << "%)" << endl;
+    }
+    if (lazyLoading)
+        cout << "  " << pendingObjects << " objetos adiados pelo --lazy" << endl;
+}
+
+// Função para gravar o resultado do --benchmark em JSON (um objeto por grandeza medida)
+bool writeBenchmarkJson(const AppOptions& options, const string& renderer, int width, int height,
+                        const FrameTimeStats::Percentiles& frame, const FrameTimeStats::Percentiles& cpu,
+                        const FrameTimeStats::Percentiles& gpu)
+{
+    ofstream file(options.benchmarkOutputPath, ios::out | ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    auto quoted = [](const string& text) {
+        string result = "\"";
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            result += c;
+        }
+        return result + "\"";
+    };
+    auto times = [](const FrameTimeStats::Percentiles& p) {
+        ostringstream out;
+        out << "{ \"samples\": " << p.samples << ", \"min\": " << p.minMs << ", \"avg\": " << p.averageMs
+            << ", \"p50\": " << p.p50 << ", \"p95\": " << p.p95 << ", \"p99\": " << p.p99
+            << ", \"max\": " << p.maxMs << " }";
+        return out.str();
+    };
+
+    file << "{\n";
+    file << "  \"scene\": " << quoted(options.scenePath) << ",\n";
+    file << "  \"camera_path\": " << quoted(options.benchmarkCameraPath) << ",\n";
+    file << "  \"renderer\": " << quoted(renderer) << ",\n";
+    file << "  \"width\": " << width << ",\n";
+    file << "  \"height\": " << height << ",\n";
+    file << "  \"deferred\": " << (deferredEnabled && deferredAvailable ? "true" : "false") << ",\n";
+    file << "  \"warmup_frames\": " << options.warmupFrames << ",\n";
+    file << "  \"measured_frames\": " << options.frames << ",\n";
+    file << "  \"frame_time_ms\": " << options.frameTime * 1000.0f << ",\n";
+    file << "  \"simulation_step_ms\": " << simulation.getStep() * 1000.0 << ",\n";
+    file << "  \"frame_ms\": " << times(frame) << ",\n";
+    file << "  \"cpu_ms\": " << times(cpu) << ",\n";
+    file << "  \"gpu_ms\": " << times(gpu) << "\n";
+    file << "}\n";
+    return true;
+}
+
+// Função para gravar as posições amostradas do --simulate. Formato (little-endian):
+//   cabeçalho: "CGSM", uint32 versão (1), uint64 objetos, uint32 amostras por tick,
+//              uint32 passo entre objetos amostrados, uint32 ticks entre amostras,
+//              float dt, uint32 quantidade de amostras
+//   por amostra: uint32 tick, amostras * 3 float (x, y, z)
+bool writeSimulationSamples(const string& path, const vector<glm::vec3>& samples, size_t sampleCount, size_t sampleStride,
+                            int dumpEvery, float step, size_t objectCount)
+{
+    ofstream file(path, ios::out | ios::binary | ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    uint32_t dumps = sampleCount > 0 ? (uint32_t)(samples.size() / sampleCount) : 0;
+    uint32_t version = 1, perTick = (uint32_t)sampleCount, stride = (uint32_t)sampleStride, every = (uint32_t)dumpEvery;
+    uint64_t objects = objectCount;
+    file.write("CGSM", 4);
+    file.write((const char*)&version, sizeof(version));
+    file.write((const char*)&objects, sizeof(objects));
+    file.write((const char*)&perTick, sizeof(perTick));
+    file.write((const char*)&stride, sizeof(stride));
+    file.write((const char*)&every, sizeof(every));
+    file.write((const char*)&step, sizeof(step));
+    file.write((const char*)&dumps, sizeof(dumps));
+    for (uint32_t d = 0; d < dumps; ++d)
+    {
+        uint32_t tick = (d + 1) * every;
+        file.write((const char*)&tick, sizeof(tick));
+        for (size_t s = 0; s < sampleCount; ++s)
+        {
+            const glm::vec3& p = samples[d * sampleCount + s];
+            float xyz[3] = { p.x, p.y, p.z };
+            file.write((const char*)xyz, sizeof(xyz));
+        }
+    }
+    return file.good();
+}
+
+// Função para iniciar/terminar a captura do tracer de CPU no intervalo de frames pedido.
+// Com a thread de renderização, o desenho do último frame ainda roda no frame seguinte
+// da simulação: a captura só para um frame depois
+void updateTraceCapture(long long frame)
+{
+    if (traceFirstFrame < 0 || !CpuTracer::compiledIn())
+        return;
+    if (frame == traceFirstFrame)
+    {
+        CpuTracer::instance().startCapture();
+        cout << "Trace de CPU: gravando frames " << traceFirstFrame << " a " << traceLastFrame << endl;
+    }
+    else if (frame == traceLastFrame + 2)
+    {
+        finishTraceCapture(traceOutputPath);
+    }
+}
+
+// Função para ligar o modo estrito de alocações no frame marcado
+void updateAllocationStrict(long long frame)
+{
+    if (frame != allocationStrictFrame)
+        return;
+    AllocationTracker::setStrict(true);
+    cout << "Alocações: modo estrito a partir do frame " << frame << " (qualquer alocação no loop do frame aborta)" << endl;
+}
+
+// Função para registrar as métricas ao vivo (antes de o servidor começar a ler)
+void registerMetrics()
+{
+    metricHandles.frame = metrics.add("frame");
+    metricHandles.frameMs = metrics.add("frame_ms");
+    metricHandles.gpuMs = metrics.add("gpu_ms");
+    metricHandles.draws = metrics.add("draws");
+    metricHandles.glCalls = metrics.add("gl_calls");
+    metricHandles.streamKb = metrics.add("stream_kb");
+    metricHandles.objects = metrics.add("objects");
+    metricHandles.trajectories = metrics.add("trajectories");
+    metricHandles.lights = metrics.add("lights");
+    metricHandles.vramUsedMb = metrics.add("vram_used_mb");
+    metricHandles.vramFreeMb = metrics.add("vram_free_mb");
+    metricHandles.inputLatencyMs = metrics.add("input_latency_ms");
+}
+
+// Função para publicar as métricas da renderização (na thread dona do contexto GL)
+void publishRenderMetrics(const FrameSnapshot& snapshot)
+{
+    metrics.set(metricHandles.draws, renderQueue.getStats().lastDraws);
+    if (inputLatency.getLastLatencyMs() >= 0.0)
+        metrics.set(metricHandles.inputLatencyMs, inputLatency.getLastLatencyMs());
+    metrics.set(metricHandles.streamKb, frameStream.getStats().lastFrameBytes / 1024.0);
+    for (const auto& scope : gpuProfiler.getScopes())
+    {
+        if (scope.depth == 0 && scope.name == "frame")
+            metrics.set(metricHandles.gpuMs, scope.lastMs);
+    }
+    if (glCallStats.isInstalled())
+    {
+        metrics.set(metricHandles.glCalls, (double)glCallStats.getLastFrame().calls);
+    }
+
+    // Memória de vídeo a cada 60 frames: a consulta passa pelo driver
+    if (snapshot.sequence % 60 != 0)
+        return;
+    const GLenum TOTAL_AVAILABLE_MEMORY_NVX = 0x9048, CURRENT_AVAILABLE_VIDMEM_NVX = 0x9049, VBO_FREE_MEMORY_ATI = 0x87FB;
+    if (videoMemoryInfo == VIDEO_MEMORY_NVX)
+    {
+        GLint totalKb = 0, availableKb = 0;
+        glGetIntegerv(TOTAL_AVAILABLE_MEMORY_NVX, &totalKb);
+        glGetIntegerv(CURRENT_AVAILABLE_VIDMEM_NVX, &availableKb);
+        metrics.set(metricHandles.vramUsedMb, (totalKb - availableKb) / 1024.0);
+        metrics.set(metricHandles.vramFreeMb, availableKb / 1024.0);
+    }
+    else if (videoMemoryInfo == VIDEO_MEMORY_ATI)
+    {
+        GLint freeKb[4] = {}; // Total livre, maior bloco, auxiliar total, auxiliar maior bloco
+        glGetIntegerv(VBO_FREE_MEMORY_ATI, freeKb);
+        metrics.set(metricHandles.vramFreeMb, freeKb[0] / 1024.0);
+    }
+}
+
+// Função para parar a captura do tracer de CPU (se houver uma) e gravar o JSON
+void finishTraceCapture(const string& path)
+{
+    if (!CpuTracer::instance().isCapturing())
+        return;
+    CpuTracer::instance().stopCapture();
+    if (CpuTracer::instance().writeJson(path))
+        cout << "Trace de CPU gravado em " << path << " (abrir em chrome://tracing ou ui.perfetto.dev)" << endl;
+    else
+        cout << "ERROR::TRACER::JSON_WRITE_FAILED " << path << endl;
+}
+
+// Função para mostrar a sobreposição entre simulação e renderização
+void printRenderThreadStats()
+{
+    auto stats = renderThread.getStats();
+    if (stats.rendered == 0)
+        return;
+    cout << "Thread de renderização: " << stats.rendered << " frames de " << stats.published << " snapshots ("
+         << stats.dropped << " descartados), " << stats.renderMs / stats.rendered << " ms por frame (máx. "
+         << stats.maxRenderMs << "), simulação esperou " << stats.waitMs / stats.published << " ms por frame" << endl;
+}
+
+// Função para montar e desenhar o overlay do profiler de GPU (médias móveis por escopo)
+void drawGpuOverlay(int width, int height, float frameDelta)
+{
+    char line[128];
+    float x = 10.0f, y = 10.0f;
+    snprintf(line, sizeof(line), "GPU (media de %d frames)   CPU %.2f ms", GpuProfiler::HISTORY, frameDelta * 1000.0f);
+    textOverlay.addText(x, y, line, 255, 255, 0);
+    y += TextOverlay::lineHeight();
+    for (const auto& scope : gpuProfiler.getScopes())
+    {
+        snprintf(line, sizeof(line), "%*s%-24s %7.3f ms  max %7.3f", scope.depth * 2, "", scope.name.c_str(),
+                 scope.averageMs, scope.maxMs);
+        textOverlay.addText(x, y, line);
+        y += TextOverlay::lineHeight();
+    }
+    if (glCallStats.isInstalled())
+    {
+        // Contagens do frame anterior (o atual ainda está sendo emitido)
+        const auto& calls = glCallStats.getLastFrame();
+        snprintf(line, sizeof(line), "GL: %llu chamadas, %llu draws, %llu binds, %llu uniforms, %.1f KB enviados",
+                 (unsigned long long)calls.calls, (unsigned long long)calls.draws, (unsigned long long)calls.binds,
+                 (unsigned long long)calls.uniforms, (calls.bufferBytes + calls.textureBytes) / 1024.0);
+        textOverlay.addText(x, y + TextOverlay::lineHeight() * 0.5f, line, 0, 255, 255);
+    }
+    textOverlay.draw(glState, width, height);
+}
+
+// Função para mostrar as médias do profiler de GPU no console
+void printGpuProfilerStats()
+{
+    if (gpuProfiler.getFramesRead() == 0)
+        return;
+    cout << "GPU (" << gpuProfiler.getFramesRead() << " frames lidos, " << gpuProfiler.getFramesMissed()
+         << " ainda não prontos na leitura):" << endl;
+    for (const auto& scope : gpuProfiler.getScopes())
+    {
+        cout << "  " << string(scope.depth * 2, ' ') << scope.name << ": média " << scope.averageMs
+             << " ms, máx. " << scope.maxMs << " ms" << endl;
+    }
+}
+
+// Função para instalar os contadores de chamadas GL (precisa vir antes de outras threads usarem GL)
+void installGLCallStats(const AppOptions& options)
+{
+    if (!options.glStats && options.glCallLogPath.empty())
+        return;
+    glCallStats.install();
+    cout << "Contadores de chamadas GL: " << glCallStats.getEntryCount() << " funções instrumentadas" << endl;
+    if (!options.glCallLogPath.empty())
+    {
+        if (glCallStats.openCallLog(options.glCallLogPath))
+            cout << "Log de chamadas GL por frame em " << options.glCallLogPath << endl;
+        else
+            cout << "ERROR::GL_CALL_STATS::LOG_OPEN_FAILED " << options.glCallLogPath << endl;
+    }
+}
+
+// Função para mostrar as médias por frame das chamadas GL e as funções mais chamadas
+void printGLCallStats()
+{
+    const auto& totals = glCallStats.getTotals();
+    if (totals.frames == 0)
+        return;
+    double frames = (double)totals.frames;
+    cout << "Chamadas GL (média de " << totals.frames << " frames): " << totals.calls / frames << " chamadas, "
+         << totals.draws / frames << " draws, " << totals.binds / frames << " binds, " << totals.uniforms / frames
+         << " uniforms, " << totals.stateChanges / frames << " mudanças de estado, " << totals.uploads / frames
+         << " envios (" << totals.bufferBytes / frames / 1024.0 << " KB em buffers, "
+         << totals.textureBytes / frames / 1024.0 << " KB em texturas)" << endl;
+
+    vector<int> entries;
+    for (int i = 0; i < (int)totals.perEntry.size(); ++i)
+    {
+        if (totals.perEntry[i] > 0)
+            entries.push_back(i);
+    }
+    sort(entries.begin(), entries.end(), [&](int a, int b) { return totals.perEntry[a] > totals.perEntry[b]; });
+    for (size_t i = 0; i < entries.size() && i < 10; ++i)
+    {
+        cout << "  " << glCallStats.getEntryName(entries[i]) << ": " << totals.perEntry[entries[i]] / frames
+             << " por frame" << endl;
+    }
+}
+
+// Função para mostrar as estatísticas das occlusion queries
+void printOcclusionQueryStats()
+{
+    const auto& stats = occlusionQueries.getStats();
+    cout << "=== Occlusion queries ===" << endl;
+    cout << "Frames: " << stats.frames << endl;
+    cout << "Queries emitidas: " << stats.queriesIssued << " (lidas: " << stats.resultsRead << ")" << endl;
+    cout << "Desenhos diretos: " << stats.directDraws << endl;
+    cout << "Desenhos condicionais: " << stats.conditionalDraws << endl;
+    cout << "Desenhos descartados pela GPU: " << stats.skippedDraws << endl;
+    cout << "Objetos sem query livre: " << stats.starvedQueries << endl;
+    cout << "Latência média: " << occlusionQueries.getAverageLatencyFrames() << " frames (máx. "
+         << stats.maxLatencyFrames << ", frames de atraso acumulados: " << stats.lateFrames << ")" << endl;
+    cout << "=========================" << endl;
+}
+
+// Função para criar o buffer de streaming que guarda o UBO de dados por frame e o SSBO
+// de dados por objeto (e as luzes do LightClusterer)
+void createFrameBuffers()
+{
+    frameStream.init(glState, glLoader, 64 * 1024);
+    cout << "Buffer de streaming: " << StreamingBuffer::REGION_COUNT << " regiões, "
+         << (frameStream.isPersistent() ? "mapeamento persistente" : "glBufferSubData (sem glBufferStorage)") << endl;
+}
+
+// Função para copiar os dados do frame para a região atual e vincular as faixas
+void uploadFrameBuffers(const FrameUniforms& frame, const vector<ObjectUniforms>& objects)
+{
+    StreamingBuffer::Allocation frameRange = frameStream.allocate(sizeof(FrameUniforms));
+    memcpy(frameRange.data, &frame, sizeof(FrameUniforms));
+    glState.bindBufferRange(GL_UNIFORM_BUFFER, FRAME_UBO_BINDING, frameStream.getBuffer(), frameRange.offset, frameRange.size);
+
+    StreamingBuffer::Allocation objectRange = frameStream.allocate(objects.size() * sizeof(ObjectUniforms));
+    if (!objects.empty())
+    {
+        memcpy(objectRange.data, objects.data(), objects.size() * sizeof(ObjectUniforms));
+    }
+    glState.bindBufferRange(GL_SHADER_STORAGE_BUFFER, OBJECT_SSBO_BINDING, frameStream.getBuffer(), objectRange.offset, objectRange.size);
+}
+
+// Função para montar os dados de um desenho (modelo + matriz normal)
+ObjectUniforms makeObjectUniforms(const glm::mat4& model)
+{
+    ObjectUniforms data;
+    data.model = model;
+    data.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(model))));
+    return data;
+}
+
+// Mesma coisa para um objeto da cena: vértices quantizados levam a descompactação
+// na matriz de modelo, mas a matriz normal continua a do modelo original
+ObjectUniforms makeObjectUniforms(const glm::mat4& model, const Geometry& geometry)
+{
+    ObjectUniforms data = makeObjectUniforms(model);
+    if (geometry.quantized)
+        data.model = model * geometry.dequantize;
+    return data;
+}
+
+// Função para escolher as flags de permutação de shader do material de uma geometria
+uint32_t materialShaderFeatures(const Geometry& geometry)
+{
+    uint32_t features = 0;
+    if (geometry.textureID != 0)
+        features |= SHADER_TEXTURED;
+    if (glm::any(glm::greaterThan(geometry.material.specular, glm::vec3(0.0f))))
+        features |= SHADER_SPECULAR;
+    if (geometry.quantized)
+        features |= SHADER_QUANTIZED;
+    return features;
+}
+
+// Função para enviar os coeficientes de Phong de um material ao programa atual
+void applyMaterialUniforms(const SceneProgram& program, const Material& material)
+{
+    glState.uniform3f(program.ka, material.ambient.r, material.ambient.g, material.ambient.b);
+    glState.uniform3f(program.kd, material.diffuse.r, material.diffuse.g, material.diffuse.b);
+    glState.uniform3f(program.ks, material.specular.r, material.specular.g, material.specular.b);
+    glState.uniform1f(program.q, material.shininess);
+}
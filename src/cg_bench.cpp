@@ -0,0 +1,382 @@
+// cg_bench: microbenchmarks dos caminhos de CPU do GrauBProva, sem janela nem contexto GL
+//
+// Mede loadObject e loadMTL em cada arquivo de assets/Modelos3D, loadSceneConfig em
+// configurações sintéticas grandes, Trajectory::update + getCurrentPosition com várias
+// quantidades de pontos e composeModelMatrix. Cada caso roda até --min-time segundos
+// (depois de uma iteração de aquecimento) e o resultado por operação (mediana, média e
+// mínimo em nanossegundos) vai para um JSON.
+//
+// Com --baseline <json> (um resultado anterior do próprio cg_bench) cada caso é
+// comparado pela mediana; variações acima de --threshold % contam como regressão e o
+// programa termina com código 1.
+//
+// Com --perf os escopos de PerfCounters dos loaders (loadObject, loadSceneConfig) contam
+// ciclos, instruções e misses de hardware durante os casos, e o relatório sai no fim.
+//
+// Uso: cg_bench [--assets <pasta>] [--output <json>] [--baseline <json>]
+//               [--threshold <%>] [--filter <texto>] [--min-time <s>] [--perf]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "SceneData.h"
+
+using namespace std;
+
+// Opções de linha de comando
+struct BenchOptions
+{
+    string assetsDir = "assets/Modelos3D";
+    string outputPath = "cg_bench.json";
+    string baselinePath;       // Resultado anterior para comparação (vazio = sem comparação)
+    double thresholdPercent = 10.0;
+    string filter;             // Só os casos cujo nome contém este texto
+    double minTime = 0.5;      // Segundos medidos por caso
+    bool perfCounters = false; // Contadores de hardware nos escopos dos loaders
+};
+
+// Tempos de um caso, por operação
+struct BenchResult
+{
+    string name;
+    uint64_t iterations = 0;
+    int opsPerIteration = 1;
+    double medianNs = 0.0;
+    double meanNs = 0.0;
+    double minNs = 0.0;
+};
+
+// Descarta cout/cerr enquanto existir (os loaders avisam no console a cada chamada)
+class QuietOutput
+{
+public:
+    QuietOutput() : previousOut(cout.rdbuf(&discard)), previousErr(cerr.rdbuf(&discard)) {}
+    ~QuietOutput()
+    {
+        cout.rdbuf(previousOut);
+        cerr.rdbuf(previousErr);
+    }
+
+private:
+    struct NullBuffer : public streambuf
+    {
+        int overflow(int c) override { return c; }
+    };
+    NullBuffer discard;
+    streambuf* previousOut;
+    streambuf* previousErr;
+};
+
+// Resultados acumulados aqui para o compilador não descartar o trabalho medido
+volatile double benchSink = 0.0;
+
+BenchOptions parseBenchArguments(int argc, char** argv);
+void writeSyntheticScene(const string& path, int objectCount);
+map<string, double> loadBaseline(const string& path);
+bool writeResultsJson(const BenchOptions& options, const vector<BenchResult>& results, const map<string, double>& baseline);
+string formatNs(double ns);
+
+// Roda body até minTime segundos, uma amostra por iteração. body faz opsPerIteration
+// operações (casos muito curtos são medidos em lotes para o relógio não dominar)
+template <typename Body>
+BenchResult measure(const string& name, int opsPerIteration, double minTime, Body body)
+{
+    typedef chrono::steady_clock Clock;
+    BenchResult result;
+    result.name = name;
+    result.opsPerIteration = opsPerIteration;
+
+    vector<double> samples;
+    {
+        QuietOutput quiet;
+        body(); // Aquecimento: cache de arquivos, alocador
+
+        auto start = Clock::now();
+        do
+        {
+            auto before = Clock::now();
+            body();
+            samples.push_back(chrono::duration<double, nano>(Clock::now() - before).count() / opsPerIteration);
+        } while (chrono::duration<double>(Clock::now() - start).count() < minTime || samples.size() < 5);
+    }
+
+    sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double sample : samples)
+        sum += sample;
+    result.iterations = samples.size();
+    result.medianNs = samples[samples.size() / 2];
+    result.meanNs = sum / samples.size();
+    result.minNs = samples.front();
+    return result;
+}
+
+// Função MAIN
+int main(int argc, char** argv)
+{
+    BenchOptions options = parseBenchArguments(argc, argv);
+    if (options.perfCounters)
+        PerfCounters::instance().enable();
+    vector<BenchResult> results;
+    auto selected = [&](const string& name) { return options.filter.empty() || name.find(options.filter) != string::npos; };
+    auto run = [&](const string& name, int opsPerIteration, auto body) {
+        if (!selected(name))
+            return;
+        results.push_back(measure(name, opsPerIteration, options.minTime, body));
+        const BenchResult& r = results.back();
+        cout << r.name << ": mediana " << formatNs(r.medianNs) << ", média " << formatNs(r.meanNs) << ", mín. "
+             << formatNs(r.minNs) << " (" << r.iterations << " iterações)" << endl;
+    };
+
+    // Arquivos OBJ e MTL dos assets, em ordem de nome (os nomes dos casos são estáveis)
+    vector<filesystem::path> objFiles, mtlFiles;
+    error_code error;
+    for (const auto& entry : filesystem::directory_iterator(options.assetsDir, error))
+    {
+        if (entry.path().extension() == ".obj")
+            objFiles.push_back(entry.path());
+        else if (entry.path().extension() == ".mtl")
+            mtlFiles.push_back(entry.path());
+    }
+    if (error)
+        cout << "ERROR::BENCH::ASSETS_NOT_FOUND " << options.assetsDir << " (casos de OBJ/MTL ignorados)" << endl;
+    sort(objFiles.begin(), objFiles.end());
+    sort(mtlFiles.begin(), mtlFiles.end());
+
+    for (const auto& path : objFiles)
+    {
+        string file = path.string();
+        run("loadObject/" + path.filename().string(), 1, [&]() {
+            vector<glm::vec3> vertices, normals;
+            vector<glm::vec2> uvs;
+            loadObject(file.c_str(), vertices, uvs, normals);
+            benchSink = benchSink + (double)vertices.size();
+        });
+    }
+
+    for (const auto& path : mtlFiles)
+    {
+        string file = path.string();
+        run("loadMTL/" + path.filename().string(), 1, [&]() {
+            Material material;
+            string texture = loadMTL(file, material);
+            benchSink = benchSink + material.shininess + (double)texture.size();
+        });
+    }
+
+    // Configurações sintéticas: objetos com trajetória de 4 pontos e uma luz a cada 10 objetos
+    filesystem::path tempDir = filesystem::temp_directory_path(error);
+    for (int objectCount : { 100, 1000, 10000 })
+    {
+        string name = "loadSceneConfig/objects=" + to_string(objectCount);
+        if (!selected(name))
+            continue;
+        string path = (tempDir / ("cg_bench_scene_" + to_string(objectCount) + ".txt")).string();
+        writeSyntheticScene(path, objectCount);
+        run(name, 1, [&]() {
+            SceneConfig config = loadSceneConfig(path);
+            benchSink = benchSink + (double)config.objects.size();
+        });
+        filesystem::remove(path, error);
+    }
+
+    // Trajetórias: pontos num círculo, 1000 passos de 1/240 s por iteração
+    for (int pointCount : { 4, 64, 1024 })
+    {
+        Trajectory trajectory;
+        for (int i = 0; i < pointCount; ++i)
+        {
+            float angle = 6.2831853f * i / pointCount;
+            trajectory.addControlPoint(glm::vec3(cos(angle) * 3.0f, 0.0f, sin(angle) * 3.0f), 0.05f);
+        }
+        trajectory.start();
+        run("Trajectory/points=" + to_string(pointCount), 1000, [&]() {
+            float sum = 0.0f;
+            for (int step = 0; step < 1000; ++step)
+            {
+                trajectory.update(1.0f / 240.0f);
+                sum += trajectory.getCurrentPosition().x;
+            }
+            benchSink = benchSink + sum;
+        });
+    }
+
+    // Matrizes de modelo como no buildSnapshot: objeto parado e objeto girando em Y
+    const char* spinNames[] = { "none", "Y" };
+    for (int spin = 0; spin < 2; ++spin)
+    {
+        int axis = spin == 0 ? -1 : 1;
+        float yaw = spin == 0 ? 0.0f : 45.0f;
+        run(string("composeModelMatrix/spin=") + spinNames[spin], 1000, [&]() {
+            float sum = 0.0f;
+            for (int i = 0; i < 1000; ++i)
+            {
+                glm::mat4 model = composeModelMatrix(glm::vec3((float)i, 0.0f, 1.0f), glm::vec3(1.5f), yaw, axis, i * 0.01f);
+                sum += model[3][0] + model[0][0];
+            }
+            benchSink = benchSink + sum;
+        });
+    }
+
+    if (results.empty())
+    {
+        cout << "Nenhum caso selecionado" << endl;
+        return 0;
+    }
+
+    // Comparação com o resultado anterior
+    map<string, double> baseline;
+    int regressions = 0;
+    if (!options.baselinePath.empty())
+    {
+        baseline = loadBaseline(options.baselinePath);
+        if (baseline.empty())
+            cout << "ERROR::BENCH::BASELINE_LOAD_FAILED " << options.baselinePath << endl;
+        else
+            cout << "Comparação com " << options.baselinePath << " (limite " << options.thresholdPercent << "%):" << endl;
+        for (const auto& r : results)
+        {
+            auto it = baseline.find(r.name);
+            if (it == baseline.end() || it->second <= 0.0)
+                continue;
+            double change = (r.medianNs - it->second) / it->second * 100.0;
+            bool regressed = change > options.thresholdPercent;
+            regressions += regressed ? 1 : 0;
+            cout << "  " << r.name << ": " << formatNs(it->second) << " -> " << formatNs(r.medianNs) << " ("
+                 << (change >= 0.0 ? "+" : "") << change << "%)" << (regressed ? "  REGRESSÃO" : "") << endl;
+        }
+    }
+
+    if (writeResultsJson(options, results, baseline))
+        cout << "Resultados gravados em " << options.outputPath << endl;
+    else
+        cout << "ERROR::BENCH::JSON_WRITE_FAILED " << options.outputPath << endl;
+    PerfCounters::instance().report(cout);
+
+    return regressions > 0 ? 1 : 0;
+}
+
+// Interpreta as opções de linha de comando (todas opcionais)
+BenchOptions parseBenchArguments(int argc, char** argv)
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--assets" && hasValue)
+            options.assetsDir = argv[++i];
+        else if (arg == "--output" && hasValue)
+            options.outputPath = argv[++i];
+        else if (arg == "--baseline" && hasValue)
+            options.baselinePath = argv[++i];
+        else if (arg == "--threshold" && hasValue)
+            options.thresholdPercent = max(0.0, atof(argv[++i]));
+        else if (arg == "--filter" && hasValue)
+            options.filter = argv[++i];
+        else if (arg == "--min-time" && hasValue)
+            options.minTime = max(0.01, atof(argv[++i]));
+        else if (arg == "--perf")
+            options.perfCounters = true;
+        else
+            cout << "Opção desconhecida ou sem valor: " << arg << endl;
+    }
+    return options;
+}
+
+// Função para gerar uma configuração de cena no formato do scene_config.txt
+void writeSyntheticScene(const string& path, int objectCount)
+{
+    ofstream file(path, ios::out | ios::trunc);
+    file << "# Cena sintética do cg_bench\n[OBJECTS]\n";
+    for (int i = 0; i < objectCount; ++i)
+    {
+        file << "OBJECT Objeto" << i << " assets/Modelos3D/Suzanne.obj " << i * 0.5f << " 0 " << -i * 0.25f
+             << " 0 " << i % 360 << " 0 1 1 1 assets/Modelos3D/Suzanne.png 1 4 0 0 0 1 1 0 0 1 1 0 1 1 0 0 1 1\n";
+        if (i % 7 == 0)
+            file << "OCCLUDER Objeto" << i << "\n";
+    }
+    file << "\n[LIGHTS]\n";
+    for (int i = 0; i < max(1, objectCount / 10); ++i)
+        file << "LIGHT " << i * 0.5f << " 3 0 1 0.9 0.8 1.5 12\n";
+    file << "\n[CAMERA]\nPOSITION 0 0 5\nTARGET 0 0 0\nFRUSTUM 45 0.1 100\n";
+}
+
+// Função para ler as medianas de um JSON gravado pelo cg_bench (nome -> ns)
+map<string, double> loadBaseline(const string& path)
+{
+    map<string, double> medians;
+    ifstream file(path);
+    if (!file.is_open())
+        return medians;
+    stringstream buffer;
+    buffer << file.rdbuf();
+    string text = buffer.str();
+
+    // Formato conhecido (writeResultsJson): basta procurar os pares nome/mediana
+    const string nameKey = "\"name\": \"", medianKey = "\"median_ns\": ";
+    size_t position = 0;
+    while ((position = text.find(nameKey, position)) != string::npos)
+    {
+        size_t nameStart = position + nameKey.size();
+        size_t nameEnd = text.find('"', nameStart);
+        size_t objectEnd = text.find('}', nameStart);
+        size_t median = text.find(medianKey, nameStart);
+        if (nameEnd == string::npos || median == string::npos || median > objectEnd)
+            break;
+        medians[text.substr(nameStart, nameEnd - nameStart)] = strtod(text.c_str() + median + medianKey.size(), nullptr);
+        position = objectEnd;
+    }
+    return medians;
+}
+
+// Função para gravar os resultados (e a comparação, se houver) em JSON
+bool writeResultsJson(const BenchOptions& options, const vector<BenchResult>& results, const map<string, double>& baseline)
+{
+    ofstream file(options.outputPath, ios::out | ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    file << "{\n  \"min_time_s\": " << options.minTime << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult& r = results[i];
+        file << "    { \"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+             << ", \"ops_per_iteration\": " << r.opsPerIteration << ", \"median_ns\": " << r.medianNs
+             << ", \"mean_ns\": " << r.meanNs << ", \"min_ns\": " << r.minNs;
+        auto it = baseline.find(r.name);
+        if (it != baseline.end() && it->second > 0.0)
+        {
+            file << ", \"baseline_median_ns\": " << it->second
+                 << ", \"change_percent\": " << (r.medianNs - it->second) / it->second * 100.0;
+        }
+        file << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return true;
+}
+
+// Tempo legível: ns, µs ou ms
+string formatNs(double ns)
+{
+    char text[32];
+    if (ns < 1.0e3)
+        snprintf(text, sizeof(text), "%.1f ns", ns);
+    else if (ns < 1.0e6)
+        snprintf(text, sizeof(text), "%.2f µs", ns / 1.0e3);
+    else
+        snprintf(text, sizeof(text), "%.2f ms", ns / 1.0e6);
+    return text;
+}
@@ -0,0 +1,129 @@
+// cg_metrics: cliente das métricas ao vivo do GrauBProva (--metrics-socket)
+//
+// Conecta no socket Unix do servidor e mostra cada linha de JSON recebida. Com
+// --record <arquivo> as linhas também vão para o arquivo (JSON por linha, pronto para jq
+// ou pandas); --quiet deixa só a gravação. Termina quando o GrauBProva fecha, depois de
+// --lines linhas ou com Ctrl+C.
+//
+// Uso: cg_metrics <socket> [--record <arquivo>] [--lines <n>] [--quiet]
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+using namespace std;
+
+// Opções de linha de comando
+struct MetricsClientOptions
+{
+    string socketPath;
+    string recordPath; // Arquivo de gravação (vazio = não grava)
+    long long lines = 0; // Linhas até sair (0 = até o servidor fechar)
+    bool quiet = false;
+};
+
+MetricsClientOptions parseClientArguments(int argc, char** argv)
+{
+    MetricsClientOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--record" && hasValue)
+            options.recordPath = argv[++i];
+        else if (arg == "--lines" && hasValue)
+            options.lines = atoll(argv[++i]);
+        else if (arg == "--quiet")
+            options.quiet = true;
+        else if (options.socketPath.empty() && arg.compare(0, 2, "--") != 0)
+            options.socketPath = arg;
+        else
+            cout << "Opção desconhecida ou sem valor: " << arg << endl;
+    }
+    return options;
+}
+
+int main(int argc, char** argv)
+{
+    MetricsClientOptions options = parseClientArguments(argc, argv);
+    if (options.socketPath.empty())
+    {
+        cout << "Uso: cg_metrics <socket> [--record <arquivo>] [--lines <n>] [--quiet]" << endl;
+        return 1;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (options.socketPath.size() >= sizeof(address.sun_path))
+    {
+        cout << "ERROR::METRICS::INVALID_PATH " << options.socketPath << endl;
+        return 1;
+    }
+    memcpy(address.sun_path, options.socketPath.c_str(), options.socketPath.size());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) != 0)
+    {
+        cout << "ERROR::METRICS::CONNECT_FAILED " << options.socketPath << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    ofstream record;
+    if (!options.recordPath.empty())
+    {
+        record.open(options.recordPath, ios::out | ios::app);
+        if (!record.is_open())
+        {
+            cout << "ERROR::METRICS::RECORD_OPEN_FAILED " << options.recordPath << endl;
+            close(fd);
+            return 1;
+        }
+    }
+
+    // As linhas podem chegar partidas entre leituras: só linhas completas são mostradas
+    string pending;
+    char buffer[4096];
+    long long received = 0;
+    while (options.lines <= 0 || received < options.lines)
+    {
+        ssize_t bytes = read(fd, buffer, sizeof(buffer));
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        if (bytes <= 0)
+            break;
+        pending.append(buffer, (size_t)bytes);
+
+        size_t start = 0, end;
+        while ((end = pending.find('\n', start)) != string::npos && (options.lines <= 0 || received < options.lines))
+        {
+            string line = pending.substr(start, end - start);
+            start = end + 1;
+            ++received;
+            if (!options.quiet)
+                cout << line << endl;
+            if (record.is_open())
+                record << line << '\n';
+        }
+        pending.erase(0, start);
+    }
+    close(fd);
+
+    if (record.is_open())
+        cout << received << " linhas gravadas em " << options.recordPath << endl;
+    return 0;
+#else
+    cout << "ERROR::METRICS::UNSUPPORTED sockets Unix indisponíveis nesta plataforma" << endl;
+    return 1;
+#endif
+}